@@ -0,0 +1,139 @@
+// Counts heap allocations made while validating polygon-heavy WKT, with the
+// geometry types in src/def.h (whose rings come from a per-thread arena, reset
+// after every row) against the same types on std::allocator, held in reused
+// objects as the kernels used to. Needs only Boost:
+//
+//   g++ -O2 -std=c++14 -I src inst/bench/arena.cpp -o arena && ./arena
+//
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "def.h"
+#include "reader.h"
+
+static unsigned long allocations = 0;
+
+void* operator new(size_t size){
+  allocations++;
+  void* out = std::malloc(size ? size : 1);
+  if(out == NULL){
+    throw std::bad_alloc();
+  }
+  return out;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+typedef boost::geometry::model::polygon<point_type> std_polygon_type;
+typedef boost::geometry::model::multi_polygon<std_polygon_type> std_multipolygon_type;
+
+// Synthetic multipolygons: `parts` jittered circles of n vertices, each with
+// a hole; the number of parts varies from row to row so rings grow and shrink
+std::vector<std::string> make_multipolygons(unsigned int rows, unsigned int n){
+  std::mt19937 rng(20201017);
+  std::uniform_real_distribution<double> jitter(0.9, 1.1);
+  std::uniform_int_distribution<int> part_count(1, 6);
+  std::vector<std::string> out;
+  char buf[64];
+  for(unsigned int i = 0; i < rows; i++){
+    std::string wkt = "MULTIPOLYGON (";
+    int parts = part_count(rng);
+    for(int p = 0; p < parts; p++){
+      wkt += p ? ", ((" : "((";
+      for(int ring = 0; ring < 2; ring++){
+        double radius = ring ? 1 : 2;
+        wkt += ring ? "), (" : "";
+        for(unsigned int j = 0; j <= n; j++){
+          // Outer rings clockwise, holes anticlockwise
+          double angle = (ring ? 1 : -1) * 2 * M_PI * (j % n) / n;
+          double r = radius * ((j % n) == 0 ? 1 : jitter(rng));
+          std::snprintf(buf, sizeof(buf), "%s%.15g %.15g", j ? ", " : "",
+                        (p * 10) + r * std::cos(angle), r * std::sin(angle));
+          wkt += buf;
+        }
+      }
+      wkt += "))";
+    }
+    wkt += ")";
+    out.push_back(wkt);
+  }
+  return out;
+}
+
+template <typename F>
+double time_it(F f){
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(){
+  const unsigned int sizes[] = {8, 64, 512};
+  for(unsigned int s = 0; s < 3; s++){
+    unsigned int rows = 400000 / sizes[s];
+    std::vector<std::string> input = make_multipolygons(rows, sizes[s]);
+    unsigned int std_valid = 0, arena_valid = 0;
+
+    // Reading only
+    std_multipolygon_type holder;
+    unsigned long before = allocations;
+    double std_read = time_it([&](){
+      for(unsigned int i = 0; i < input.size(); i++){
+        wkt_utils::read_wkt(input[i].data(), input[i].size(), holder);
+      }
+    });
+    unsigned long std_read_allocs = allocations - before;
+
+    before = allocations;
+    double arena_read = time_it([&](){
+      for(unsigned int i = 0; i < input.size(); i++){
+        wkt_utils::arena_scope scope;
+        multipolygon_type p;
+        wkt_utils::read_wkt(input[i].data(), input[i].size(), p);
+      }
+    });
+    unsigned long arena_read_allocs = allocations - before;
+
+    // Reading and validating, as validate_wkt does
+    before = allocations;
+    double std_time = time_it([&](){
+      for(unsigned int i = 0; i < input.size(); i++){
+        wkt_utils::read_wkt(input[i].data(), input[i].size(), holder);
+        std_valid += boost::geometry::is_valid(holder);
+      }
+    });
+    unsigned long std_allocs = allocations - before;
+
+    before = allocations;
+    double arena_time = time_it([&](){
+      for(unsigned int i = 0; i < input.size(); i++){
+        wkt_utils::arena_scope scope;
+        multipolygon_type p;
+        wkt_utils::read_wkt(input[i].data(), input[i].size(), p);
+        arena_valid += boost::geometry::is_valid(p);
+      }
+    });
+    unsigned long arena_allocs = allocations - before;
+
+    std::printf("%4u vertices/ring x %6u rows\n", sizes[s], rows);
+    std::printf("  read:           std %8lu allocs %6.3fs   arena %8lu allocs %6.3fs\n",
+                std_read_allocs, std_read, arena_read_allocs, arena_read);
+    std::printf("  read+is_valid:  std %8lu allocs %6.3fs   arena %8lu allocs %6.3fs\n",
+                std_allocs, std_time, arena_allocs, arena_time);
+    if(std_valid != arena_valid){
+      std::printf("  results differ!\n");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,312 @@
+// Times the C++ kernels behind wkt_bounding(), wkt_centroid(), validate_wkt(),
+// wkt_correct(), wkt_reverse(), wkt_simplify(), wkt_coords() and wkt_twkb()
+// on synthetic WKT of four shapes - points, 10,000-vertex polygons,
+// multipolygons of many small parts and GeometryCollections - reporting
+// rows/s (items_per_second) and MB/s (bytes_per_second) of WKT read. The R
+// wrappers, and wkt2geojson() and geojson2wkt(), which build R objects, are
+// timed by kernels.R instead.
+// Needs Boost and google-benchmark:
+//
+//   g++ -O2 -std=c++14 -I src inst/bench/kernels.cpp -lbenchmark -lpthread -o kernels && ./kernels
+//
+// Pass --benchmark_filter=<regex> to run some of them, and
+// --benchmark_format=csv for something to compare between versions.
+//
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "def.h"
+#include "streaming.h"
+#include "simplify.h"
+#include "sweep.h"
+#include "twkb.h"
+#include "writer.h"
+
+enum dataset { points, polygons, multipolygons, collections };
+
+const char* dataset_names[] = {"points", "polygons", "multipolygons", "collections"};
+
+// A jittered circle with n vertices, clockwise (boost::geometry's default)
+// or, for about one row in ten, anticlockwise, so that wkt_correct() has
+// something to do
+void add_ring(std::string& wkt, std::mt19937& rng, double cx, double cy, double radius,
+              unsigned int n, bool clockwise){
+  std::uniform_real_distribution<double> jitter(0.9, 1.1);
+  char buf[64];
+  wkt += '(';
+  for(unsigned int j = 0; j <= n; j++){
+    double angle = (clockwise ? -2 : 2) * M_PI * (j % n) / n;
+    double r = (j % n) == 0 ? radius : radius * jitter(rng);
+    std::snprintf(buf, sizeof(buf), "%s%.15g %.15g", j ? ", " : "",
+                  cx + r * std::cos(angle), cy + r * std::sin(angle));
+    wkt += buf;
+  }
+  wkt += ')';
+}
+
+void add_polygon(std::string& wkt, std::mt19937& rng, unsigned int n, bool holed){
+  std::uniform_real_distribution<double> centre(-170, 170);
+  bool clockwise = rng() % 10 != 0;
+  double cx = centre(rng), cy = centre(rng) / 2;
+  wkt += '(';
+  add_ring(wkt, rng, cx, cy, 1, n, clockwise);
+  if(holed){
+    wkt += ", ";
+    add_ring(wkt, rng, cx, cy, 0.5, n, !clockwise);
+  }
+  wkt += ')';
+}
+
+/**
+ * Makes about `bytes` of WKT, in rows of the given shape
+ */
+std::vector<std::string> make_input(dataset type, size_t bytes){
+  std::mt19937 rng(20201017);
+  std::uniform_real_distribution<double> coordinate(-180, 180);
+  std::vector<std::string> out;
+  size_t total = 0;
+  char buf[128];
+  while(total < bytes){
+    std::string wkt;
+    switch(type){
+    case points:
+      std::snprintf(buf, sizeof(buf), "POINT (%.15g %.15g)", coordinate(rng), coordinate(rng) / 2);
+      wkt = buf;
+      break;
+    case polygons:
+      wkt = "POLYGON ";
+      add_polygon(wkt, rng, 10000, false);
+      break;
+    case multipolygons:
+      wkt = "MULTIPOLYGON (";
+      for(unsigned int p = 0; p < 200; p++){
+        if(p){
+          wkt += ", ";
+        }
+        add_polygon(wkt, rng, 16, true);
+      }
+      wkt += ')';
+      break;
+    case collections:
+      std::snprintf(buf, sizeof(buf), "GEOMETRYCOLLECTION (POINT (%.15g %.15g), POLYGON ",
+                    coordinate(rng), coordinate(rng) / 2);
+      wkt = buf;
+      add_polygon(wkt, rng, 64, true);
+      wkt += ", GEOMETRYCOLLECTION (LINESTRING (0 0, 1 1, 2 0), MULTIPOLYGON (";
+      add_polygon(wkt, rng, 32, false);
+      wkt += ", ";
+      add_polygon(wkt, rng, 32, false);
+      wkt += ")))";
+    }
+    total += wkt.size();
+    out.push_back(wkt);
+  }
+  return out;
+}
+
+// Inputs are made once each, on first use, and shared between benchmarks
+const std::vector<std::string>& input(dataset type){
+  static std::vector<std::string> inputs[4];
+  if(inputs[type].empty()){
+    inputs[type] = make_input(type, 32 * 1024 * 1024);
+  }
+  return inputs[type];
+}
+
+/**
+ * Runs `f` over every row of a dataset, once per benchmark iteration, and
+ * records the rows and bytes read
+ */
+template <typename F>
+void run(benchmark::State& state, F f){
+  dataset type = static_cast<dataset>(state.range(0));
+  const std::vector<std::string>& rows = input(type);
+  size_t bytes = 0;
+  for(unsigned int i = 0; i < rows.size(); i++){
+    bytes += rows[i].size();
+  }
+  for(auto _ : state){
+    for(unsigned int i = 0; i < rows.size(); i++){
+      f(rows[i]);
+    }
+  }
+  state.SetLabel(dataset_names[type]);
+  state.SetItemsProcessed(state.iterations() * rows.size());
+  state.SetBytesProcessed(state.iterations() * bytes);
+}
+
+void bounding(benchmark::State& state){
+  run(state, [](const std::string& x){
+    wkt_utils::envelope_handler envelope;
+    wkt_utils::read_geometry(x.data(), x.size(), envelope);
+    benchmark::DoNotOptimize(envelope.box.max_x);
+  });
+}
+
+void centroid(benchmark::State& state){
+  run(state, [](const std::string& x){
+    wkt_utils::centroid_handler centroid;
+    double cx, cy;
+    wkt_utils::read_geometry(x.data(), x.size(), centroid);
+    benchmark::DoNotOptimize(centroid.result(cx, cy));
+  });
+}
+
+// wkt_centroid(geodesic = "spherical")
+void spherical_centroid(benchmark::State& state){
+  run(state, [](const std::string& x){
+    wkt_utils::spherical_centroid_handler centroid;
+    double cx, cy;
+    wkt_utils::read_geometry(x.data(), x.size(), centroid);
+    benchmark::DoNotOptimize(centroid.result(cx, cy));
+  });
+}
+
+// GeometryCollections are validated, corrected and reversed member by
+// member through src/shape.h, which needs R; only the other datasets are
+// run through these
+template <typename Geometry>
+void validate(benchmark::State& state){
+  run(state, [](const std::string& x){
+    wkt_utils::arena_scope scope;
+    Geometry geom;
+    boost::geometry::validity_failure_type failure;
+    wkt_utils::read_wkt(x.data(), x.size(), geom);
+    benchmark::DoNotOptimize(wkt_utils::is_valid(geom, failure));
+  });
+}
+
+// validate_wkt(level = "structure"), which checks as it reads
+void structure(benchmark::State& state){
+  run(state, [](const std::string& x){
+    wkt_utils::structure_handler structure;
+    wkt_utils::read_geometry(x.data(), x.size(), structure);
+    benchmark::DoNotOptimize(structure.failure);
+  });
+}
+
+template <typename Geometry>
+void correct(benchmark::State& state){
+  std::string out;
+  run(state, [&out](const std::string& x){
+    wkt_utils::orientation_handler orientation;
+    wkt_utils::read_geometry(x.data(), x.size(), orientation);
+    if(orientation.oriented){
+      return;
+    }
+    wkt_utils::arena_scope scope;
+    Geometry geom;
+    wkt_utils::read_wkt(x.data(), x.size(), geom);
+    boost::geometry::correct(geom);
+    out.clear();
+    wkt_utils::geometry_text_writer writer(out);
+    writer.write(geom);
+    benchmark::DoNotOptimize(out.data());
+  });
+}
+
+template <typename Geometry>
+void reverse(benchmark::State& state){
+  std::string out;
+  run(state, [&out](const std::string& x){
+    wkt_utils::arena_scope scope;
+    Geometry geom;
+    wkt_utils::read_wkt(x.data(), x.size(), geom);
+    boost::geometry::reverse(geom);
+    out.clear();
+    wkt_utils::geometry_text_writer writer(out);
+    writer.write(geom);
+    benchmark::DoNotOptimize(out.data());
+  });
+}
+
+// wkt_simplify(), at a tolerance of a hundredth of the polygons' radius (or
+// the square of that, as an area, for Visvalingam-Whyatt)
+template <typename Geometry, wkt_utils::simplify_method Method>
+void simplify(benchmark::State& state){
+  std::string out;
+  wkt_utils::simplifier simplifier(Method, false);
+  double tolerance = Method == wkt_utils::douglas_peucker ? 0.01 : 0.0001;
+  run(state, [&out, &simplifier, tolerance](const std::string& x){
+    wkt_utils::arena_scope scope;
+    Geometry geom, simplified;
+    wkt_utils::read_wkt(x.data(), x.size(), geom);
+    simplifier.simplify(geom, simplified, tolerance);
+    out.clear();
+    wkt_utils::geometry_text_writer writer(out);
+    writer.write(simplified);
+    benchmark::DoNotOptimize(out.data());
+  });
+}
+
+// wkt_coords() reads each object twice: once to count its coordinates, and
+// once to copy them into the output columns
+struct count_handler : wkt_utils::wkt_handler {
+  static const bool collections = true;
+  size_t count;
+  count_handler() : count(0) {}
+  inline void coord(const wkt_utils::coordinate&){
+    count++;
+  }
+};
+
+struct copy_handler : wkt_utils::wkt_handler {
+  static const bool collections = true;
+  double* x;
+  double* y;
+  copy_handler(double* x, double* y) : x(x), y(y) {}
+  inline void coord(const wkt_utils::coordinate& c){
+    *x++ = c.x;
+    *y++ = c.y;
+  }
+};
+
+void coords(benchmark::State& state){
+  std::vector<double> x, y;
+  run(state, [&x, &y](const std::string& wkt){
+    count_handler count;
+    wkt_utils::read_geometry(wkt.data(), wkt.size(), count);
+    x.resize(count.count);
+    y.resize(count.count);
+    copy_handler copy(x.data(), y.data());
+    wkt_utils::read_geometry(wkt.data(), wkt.size(), copy);
+    benchmark::DoNotOptimize(x.data());
+  });
+}
+
+// wkt_twkb() at 5 decimal places, reporting the size of the TWKB as a
+// fraction of the WKT's
+void twkb(benchmark::State& state){
+  std::string out;
+  size_t written = 0, read = 0;
+  run(state, [&out, &written, &read](const std::string& x){
+    out.clear();
+    wkt_utils::twkb_writer writer(out, 5, 0, 0, false, false);
+    wkt_utils::read_geometry(x.data(), x.size(), writer);
+    written += out.size();
+    read += x.size();
+    benchmark::DoNotOptimize(out.data());
+  });
+  state.counters["size"] = (double) written / read;
+}
+
+BENCHMARK(bounding)->DenseRange(points, collections)->Unit(benchmark::kMillisecond);
+BENCHMARK(centroid)->DenseRange(points, collections)->Unit(benchmark::kMillisecond);
+BENCHMARK(spherical_centroid)->DenseRange(points, collections)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(validate, point_type)->Arg(points)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(validate, polygon_type)->Arg(polygons)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(validate, multipolygon_type)->Arg(multipolygons)->Unit(benchmark::kMillisecond);
+BENCHMARK(structure)->DenseRange(points, collections)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(correct, polygon_type)->Arg(polygons)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(correct, multipolygon_type)->Arg(multipolygons)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(reverse, polygon_type)->Arg(polygons)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(reverse, multipolygon_type)->Arg(multipolygons)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(simplify, polygon_type, wkt_utils::douglas_peucker)->Arg(polygons)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(simplify, polygon_type, wkt_utils::visvalingam_whyatt)->Arg(polygons)->Unit(benchmark::kMillisecond);
+BENCHMARK(coords)->DenseRange(points, collections)->Unit(benchmark::kMillisecond);
+BENCHMARK(twkb)->DenseRange(points, collections)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
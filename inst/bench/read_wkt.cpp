@@ -0,0 +1,82 @@
+// Compares the WKT reader in src/reader.h against the path it replaced
+// (copy, lower-case, then boost::geometry::read_wkt). Needs only Boost:
+//
+//   g++ -O2 -std=c++14 -I src inst/bench/read_wkt.cpp -o read_wkt && ./read_wkt
+//
+#include <chrono>
+#include <cstdio>
+#include <cctype>
+#include <random>
+#include <string>
+#include <vector>
+#include "def.h"
+#include "reader.h"
+
+// Synthetic polygons: a jittered circle with n vertices, printed at full precision
+std::vector<std::string> make_polygons(unsigned int rows, unsigned int n){
+  std::mt19937 rng(20201017);
+  std::uniform_real_distribution<double> jitter(0.9, 1.1);
+  std::uniform_real_distribution<double> centre(-170, 170);
+  std::vector<std::string> out;
+  char buf[64];
+  for(unsigned int i = 0; i < rows; i++){
+    double cx = centre(rng), cy = centre(rng) / 2;
+    std::string wkt = "POLYGON ((";
+    for(unsigned int j = 0; j <= n; j++){
+      double angle = 2 * M_PI * (j % n) / n;
+      double r = (j % n) == 0 ? 1 : jitter(rng);
+      std::snprintf(buf, sizeof(buf), "%s%.15g %.15g", j ? ", " : "",
+                    cx + r * std::cos(angle), cy + r * std::sin(angle));
+      wkt += buf;
+    }
+    wkt += "))";
+    out.push_back(wkt);
+  }
+  return out;
+}
+
+template <typename F>
+double time_it(F f){
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(){
+  const unsigned int sizes[] = {5, 100, 10000};
+  for(unsigned int s = 0; s < 3; s++){
+    unsigned int rows = 2000000 / sizes[s];
+    std::vector<std::string> input = make_polygons(rows, sizes[s]);
+    double bytes = 0;
+    for(unsigned int i = 0; i < input.size(); i++){
+      bytes += input[i].size();
+    }
+    polygon_type poly;
+    double old_sum = 0, new_sum = 0;
+
+    double old_time = time_it([&](){
+      for(unsigned int i = 0; i < input.size(); i++){
+        std::string holding = input[i];
+        for(unsigned int j = 0; j < holding.size(); j++){
+          holding[j] = std::tolower(holding[j]);
+        }
+        boost::geometry::read_wkt(holding, poly);
+        old_sum += poly.outer()[1].get<0>();
+      }
+    });
+    double new_time = time_it([&](){
+      for(unsigned int i = 0; i < input.size(); i++){
+        wkt_utils::read_wkt(input[i].data(), input[i].size(), poly);
+        new_sum += poly.outer()[1].get<0>();
+      }
+    });
+
+    std::printf("%6u vertices x %7u rows: boost %7.3fs (%6.1f MB/s)  reader.h %7.3fs (%6.1f MB/s)  %.1fx\n",
+                sizes[s], rows, old_time, bytes / old_time / 1e6, new_time, bytes / new_time / 1e6,
+                old_time / new_time);
+    if(old_sum != new_sum){
+      std::printf("  results differ!\n");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,96 @@
+// Compares the streaming envelope and centroid handlers in src/streaming.h
+// against reading each object into a boost::geometry multipolygon first,
+// which is what wkt_bounding() and wkt_centroid() used to do. Needs only Boost:
+//
+//   g++ -O2 -std=c++14 -I src inst/bench/streaming.cpp -o streaming && ./streaming
+//
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "def.h"
+#include "streaming.h"
+
+// Synthetic multipolygons: parts jittered circles with n vertices each
+std::vector<std::string> make_multipolygons(unsigned int rows, unsigned int parts, unsigned int n){
+  std::mt19937 rng(20201017);
+  std::uniform_real_distribution<double> jitter(0.9, 1.1);
+  std::uniform_real_distribution<double> centre(-170, 170);
+  std::vector<std::string> out;
+  char buf[64];
+  for(unsigned int i = 0; i < rows; i++){
+    std::string wkt = "MULTIPOLYGON (";
+    for(unsigned int p = 0; p < parts; p++){
+      double cx = centre(rng), cy = centre(rng) / 2;
+      wkt += p ? ", ((" : "((";
+      for(unsigned int j = 0; j <= n; j++){
+        double angle = -2 * M_PI * (j % n) / n;
+        double r = (j % n) == 0 ? 1 : jitter(rng);
+        std::snprintf(buf, sizeof(buf), "%s%.15g %.15g", j ? ", " : "",
+                      cx + r * std::cos(angle), cy + r * std::sin(angle));
+        wkt += buf;
+      }
+      wkt += "))";
+    }
+    wkt += ")";
+    out.push_back(wkt);
+  }
+  return out;
+}
+
+template <typename F>
+double time_it(F f){
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(){
+  const unsigned int sizes[] = {10, 1000, 100000};
+  for(unsigned int s = 0; s < 3; s++){
+    unsigned int rows = 4000000 / (sizes[s] * 4);
+    std::vector<std::string> input = make_multipolygons(rows, 4, sizes[s]);
+    multipolygon_type multipoly;
+    wkt_utils::envelope_handler envelope;
+    wkt_utils::centroid_handler centroid;
+    double old_sum = 0, new_sum = 0;
+
+    double old_box = time_it([&](){
+      for(unsigned int i = 0; i < input.size(); i++){
+        wkt_utils::read_wkt(input[i].data(), input[i].size(), multipoly);
+        old_sum += boost::geometry::return_envelope<box_type>(multipoly).max_corner().get<0>();
+      }
+    });
+    double new_box = time_it([&](){
+      for(unsigned int i = 0; i < input.size(); i++){
+        wkt_utils::read_geometry(input[i].data(), input[i].size(), envelope);
+        new_sum += envelope.box.max_x;
+      }
+    });
+    double old_centroid = time_it([&](){
+      point_type p;
+      for(unsigned int i = 0; i < input.size(); i++){
+        wkt_utils::read_wkt(input[i].data(), input[i].size(), multipoly);
+        boost::geometry::centroid(multipoly, p);
+        old_sum += p.get<0>();
+      }
+    });
+    double new_centroid = time_it([&](){
+      double x, y;
+      for(unsigned int i = 0; i < input.size(); i++){
+        wkt_utils::read_geometry(input[i].data(), input[i].size(), centroid);
+        centroid.result(x, y);
+        new_sum += x;
+      }
+    });
+
+    std::printf("4 x %6u vertices x %6u rows: envelope %6.3fs -> %6.3fs (%.1fx)  centroid %6.3fs -> %6.3fs (%.1fx)\n",
+                sizes[s], rows, old_box, new_box, old_box / new_box,
+                old_centroid, new_centroid, old_centroid / new_centroid);
+    if(old_sum != new_sum){
+      std::printf("  results differ!\n");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,78 @@
+// Times writing bounding-box polygons and reversed polygons as WKT, through
+// a std::stringstream and boost::geometry::wkt (as bounding_wkt(),
+// wkt_reverse() and wkt_correct() used to) against geometry_text_writer in
+// src/writer.h, writing into one reused buffer. Checks that both give the
+// same text. Needs only Boost:
+//
+//   g++ -O2 -std=c++14 -I src inst/bench/write_wkt.cpp -o write_wkt && ./write_wkt
+//
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "def.h"
+#include "writer.h"
+
+template <typename F>
+double time_it(F f){
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(){
+  const unsigned int rows = 2000000;
+  std::mt19937 rng(20201017);
+  std::uniform_real_distribution<double> coordinate(-180, 180);
+  std::vector<double> boxes(rows * 4);
+  for(unsigned int i = 0; i < boxes.size(); i++){
+    // Mostly clean decimals, as bounding boxes of real data tend to be
+    boxes[i] = (i % 3) ? std::round(coordinate(rng) * 1e4) / 1e4 : coordinate(rng);
+  }
+
+  size_t stream_bytes = 0, writer_bytes = 0, mismatches = 0;
+  double stream_time = time_it([&](){
+    for(unsigned int i = 0; i < rows; i++){
+      polygon_type poly;
+      boost::geometry::convert(boost::geometry::make<box_type>(boxes[4 * i], boxes[4 * i + 1],
+                                                               boxes[4 * i + 2], boxes[4 * i + 3]), poly);
+      std::stringstream ss;
+      ss << boost::geometry::wkt(poly);
+      stream_bytes += ss.str().size();
+    }
+  });
+
+  std::string holding;
+  wkt_utils::geometry_text_writer writer(holding);
+  double writer_time = time_it([&](){
+    for(unsigned int i = 0; i < rows; i++){
+      holding.clear();
+      writer.write_box(boxes[4 * i], boxes[4 * i + 1], boxes[4 * i + 2], boxes[4 * i + 3]);
+      writer_bytes += holding.size();
+    }
+  });
+
+  for(unsigned int i = 0; i < rows; i += 97){
+    polygon_type poly;
+    boost::geometry::convert(boost::geometry::make<box_type>(boxes[4 * i], boxes[4 * i + 1],
+                                                             boxes[4 * i + 2], boxes[4 * i + 3]), poly);
+    std::stringstream ss;
+    ss << boost::geometry::wkt(poly);
+    holding.clear();
+    writer.write_box(boxes[4 * i], boxes[4 * i + 1], boxes[4 * i + 2], boxes[4 * i + 3]);
+    mismatches += ss.str() != holding;
+  }
+
+  std::printf("%u bounding boxes\n", rows);
+  std::printf("  stringstream + boost::geometry::wkt  %6.3fs  (%lu bytes)\n",
+              stream_time, (unsigned long) stream_bytes);
+  std::printf("  geometry_text_writer                 %6.3fs  (%lu bytes)\n",
+              writer_time, (unsigned long) writer_bytes);
+  if(mismatches){
+    std::printf("  %lu results differ!\n", (unsigned long) mismatches);
+  }
+  return 0;
+}
@@ -19,6 +19,17 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// bounding_wkt_matrix
+CharacterVector bounding_wkt_matrix(NumericMatrix x);
+RcppExport SEXP _wellknown_bounding_wkt_matrix(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(bounding_wkt_matrix(x));
+    return rcpp_result_gen;
+END_RCPP
+}
 // bounding_wkt_list
 CharacterVector bounding_wkt_list(List x);
 RcppExport SEXP _wellknown_bounding_wkt_list(SEXP xSEXP) {
@@ -31,82 +42,447 @@ BEGIN_RCPP
 END_RCPP
 }
 // wkt_centroid
-DataFrame wkt_centroid(CharacterVector wkt);
-RcppExport SEXP _wellknown_wkt_centroid(SEXP wktSEXP) {
+DataFrame wkt_centroid(SEXP wkt, std::string geodesic, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_centroid(SEXP wktSEXP, SEXP geodesicSEXP, SEXP nthreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< CharacterVector >::type wkt(wktSEXP);
-    rcpp_result_gen = Rcpp::wrap(wkt_centroid(wkt));
+    Rcpp::traits::input_parameter< SEXP >::type wkt(wktSEXP);
+    Rcpp::traits::input_parameter< std::string >::type geodesic(geodesicSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_centroid(wkt, geodesic, nthreads));
     return rcpp_result_gen;
 END_RCPP
 }
-// wkt_reverse
-CharacterVector wkt_reverse(CharacterVector x);
-RcppExport SEXP _wellknown_wkt_reverse(SEXP xSEXP) {
+// geojson2wkt_
+CharacterVector geojson2wkt_(CharacterVector json, int fmt, std::string third, int digits, int scipen);
+RcppExport SEXP _wellknown_geojson2wkt_(SEXP jsonSEXP, SEXP fmtSEXP, SEXP thirdSEXP, SEXP digitsSEXP, SEXP scipenSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< CharacterVector >::type json(jsonSEXP);
+    Rcpp::traits::input_parameter< int >::type fmt(fmtSEXP);
+    Rcpp::traits::input_parameter< std::string >::type third(thirdSEXP);
+    Rcpp::traits::input_parameter< int >::type digits(digitsSEXP);
+    Rcpp::traits::input_parameter< int >::type scipen(scipenSEXP);
+    rcpp_result_gen = Rcpp::wrap(geojson2wkt_(json, fmt, third, digits, scipen));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_index
+SEXP wkt_index(SEXP wkt, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_index(SEXP wktSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type wkt(wktSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_index(wkt, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_index_box_
+List wkt_index_box_(SEXP index, NumericVector min_x, NumericVector min_y, NumericVector max_x, NumericVector max_y, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_index_box_(SEXP indexSEXP, SEXP min_xSEXP, SEXP min_ySEXP, SEXP max_xSEXP, SEXP max_ySEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type min_x(min_xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type min_y(min_ySEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type max_x(max_xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type max_y(max_ySEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_index_box_(index, min_x, min_y, max_x, max_y, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_index_nearest_
+List wkt_index_nearest_(SEXP index, NumericVector x, NumericVector y, int k, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_index_nearest_(SEXP indexSEXP, SEXP xSEXP, SEXP ySEXP, SEXP kSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_index_nearest_(index, x, y, k, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_index_info_
+NumericVector wkt_index_info_(SEXP index);
+RcppExport SEXP _wellknown_wkt_index_info_(SEXP indexSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_index_info_(index));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_area
+NumericVector wkt_area(SEXP wkt, std::string geodesic, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_area(SEXP wktSEXP, SEXP geodesicSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type wkt(wktSEXP);
+    Rcpp::traits::input_parameter< std::string >::type geodesic(geodesicSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_area(wkt, geodesic, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_length
+NumericVector wkt_length(SEXP wkt, std::string geodesic, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_length(SEXP wktSEXP, SEXP geodesicSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type wkt(wktSEXP);
+    Rcpp::traits::input_parameter< std::string >::type geodesic(geodesicSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_length(wkt, geodesic, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_parse
+SEXP wkt_parse(SEXP x);
+RcppExport SEXP _wellknown_wkt_parse(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_parse(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_parsed_info_
+NumericVector wkt_parsed_info_(SEXP x);
+RcppExport SEXP _wellknown_wkt_parsed_info_(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_parsed_info_(x));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_polyline_
+CharacterVector wkt_polyline_(SEXP x, int precision, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_polyline_(SEXP xSEXP, SEXP precisionSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_polyline_(x, precision, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// polyline_wkt_
+CharacterVector polyline_wkt_(CharacterVector x, int precision, SEXP nthreads);
+RcppExport SEXP _wellknown_polyline_wkt_(SEXP xSEXP, SEXP precisionSEXP, SEXP nthreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< CharacterVector >::type x(xSEXP);
-    rcpp_result_gen = Rcpp::wrap(wkt_reverse(x));
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(polyline_wkt_(x, precision, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_predicate_
+LogicalVector wkt_predicate_(SEXP x, SEXP y, std::string predicate, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_predicate_(SEXP xSEXP, SEXP ySEXP, SEXP predicateSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type y(ySEXP);
+    Rcpp::traits::input_parameter< std::string >::type predicate(predicateSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_predicate_(x, y, predicate, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_join_
+DataFrame wkt_join_(SEXP x, SEXP y, std::string predicate, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_join_(SEXP xSEXP, SEXP ySEXP, SEXP predicateSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type y(ySEXP);
+    Rcpp::traits::input_parameter< std::string >::type predicate(predicateSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_join_(x, y, predicate, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_reverse
+CharacterVector wkt_reverse(SEXP x, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_reverse(SEXP xSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_reverse(x, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_round
+CharacterVector wkt_round(SEXP x, int digits, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_round(SEXP xSEXP, SEXP digitsSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type digits(digitsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_round(x, digits, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_snap
+CharacterVector wkt_snap(SEXP x, double grid, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_snap(SEXP xSEXP, SEXP gridSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< double >::type grid(gridSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_snap(x, grid, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_simplify
+CharacterVector wkt_simplify(SEXP x, NumericVector tolerance, std::string method, bool preserve_topology, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_simplify(SEXP xSEXP, SEXP toleranceSEXP, SEXP methodSEXP, SEXP preserve_topologySEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type tolerance(toleranceSEXP);
+    Rcpp::traits::input_parameter< std::string >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< bool >::type preserve_topology(preserve_topologySEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_simplify(x, tolerance, method, preserve_topology, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wellknown_stats
+List wellknown_stats(bool reset);
+RcppExport SEXP _wellknown_wellknown_stats(SEXP resetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< bool >::type reset(resetSEXP);
+    rcpp_result_gen = Rcpp::wrap(wellknown_stats(reset));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_twkb_
+List wkt_twkb_(SEXP x, int precision, int precision_z, int precision_m, bool sizes, bool bbox, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_twkb_(SEXP xSEXP, SEXP precisionSEXP, SEXP precision_zSEXP, SEXP precision_mSEXP, SEXP sizesSEXP, SEXP bboxSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< int >::type precision_z(precision_zSEXP);
+    Rcpp::traits::input_parameter< int >::type precision_m(precision_mSEXP);
+    Rcpp::traits::input_parameter< bool >::type sizes(sizesSEXP);
+    Rcpp::traits::input_parameter< bool >::type bbox(bboxSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_twkb_(x, precision, precision_z, precision_m, sizes, bbox, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// twkb_wkt_
+CharacterVector twkb_wkt_(List x, SEXP nthreads);
+RcppExport SEXP _wellknown_twkb_wkt_(SEXP xSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(twkb_wkt_(x, nthreads));
     return rcpp_result_gen;
 END_RCPP
 }
 // validate_wkt
-DataFrame validate_wkt(CharacterVector x);
-RcppExport SEXP _wellknown_validate_wkt(SEXP xSEXP) {
+DataFrame validate_wkt(SEXP x, std::string level, SEXP nthreads);
+RcppExport SEXP _wellknown_validate_wkt(SEXP xSEXP, SEXP levelSEXP, SEXP nthreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< CharacterVector >::type x(xSEXP);
-    rcpp_result_gen = Rcpp::wrap(validate_wkt(x));
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< std::string >::type level(levelSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(validate_wkt(x, level, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// validate_wkt_file_
+DataFrame validate_wkt_file_(std::string path, std::string format, std::string column_name, int column_index, int chunk_size, std::string level, SEXP nthreads);
+RcppExport SEXP _wellknown_validate_wkt_file_(SEXP pathSEXP, SEXP formatSEXP, SEXP column_nameSEXP, SEXP column_indexSEXP, SEXP chunk_sizeSEXP, SEXP levelSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< std::string >::type format(formatSEXP);
+    Rcpp::traits::input_parameter< std::string >::type column_name(column_nameSEXP);
+    Rcpp::traits::input_parameter< int >::type column_index(column_indexSEXP);
+    Rcpp::traits::input_parameter< int >::type chunk_size(chunk_sizeSEXP);
+    Rcpp::traits::input_parameter< std::string >::type level(levelSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(validate_wkt_file_(path, format, column_name, column_index, chunk_size, level, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_wkb_
+List wkt_wkb_(SEXP x, int endian, int srid, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_wkb_(SEXP xSEXP, SEXP endianSEXP, SEXP sridSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type endian(endianSEXP);
+    Rcpp::traits::input_parameter< int >::type srid(sridSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_wkb_(x, endian, srid, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkb_wkt_
+CharacterVector wkb_wkt_(List x, int precision, bool trim, SEXP nthreads);
+RcppExport SEXP _wellknown_wkb_wkt_(SEXP xSEXP, SEXP precisionSEXP, SEXP trimSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< List >::type x(xSEXP);
+    Rcpp::traits::input_parameter< int >::type precision(precisionSEXP);
+    Rcpp::traits::input_parameter< bool >::type trim(trimSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkb_wkt_(x, precision, trim, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt2geojson_
+List wkt2geojson_(SEXP str, int fmt, bool feature, bool numeric, bool simplify);
+RcppExport SEXP _wellknown_wkt2geojson_(SEXP strSEXP, SEXP fmtSEXP, SEXP featureSEXP, SEXP numericSEXP, SEXP simplifySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type str(strSEXP);
+    Rcpp::traits::input_parameter< int >::type fmt(fmtSEXP);
+    Rcpp::traits::input_parameter< bool >::type feature(featureSEXP);
+    Rcpp::traits::input_parameter< bool >::type numeric(numericSEXP);
+    Rcpp::traits::input_parameter< bool >::type simplify(simplifySEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt2geojson_(str, fmt, feature, numeric, simplify));
     return rcpp_result_gen;
 END_RCPP
 }
 // wkt_bounding
-SEXP wkt_bounding(CharacterVector wkt, bool as_matrix);
-RcppExport SEXP _wellknown_wkt_bounding(SEXP wktSEXP, SEXP as_matrixSEXP) {
+SEXP wkt_bounding(SEXP wkt, bool as_matrix, bool zm, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_bounding(SEXP wktSEXP, SEXP as_matrixSEXP, SEXP zmSEXP, SEXP nthreadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type wkt(wktSEXP);
+    Rcpp::traits::input_parameter< bool >::type as_matrix(as_matrixSEXP);
+    Rcpp::traits::input_parameter< bool >::type zm(zmSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_bounding(wkt, as_matrix, zm, nthreads));
+    return rcpp_result_gen;
+END_RCPP
+}
+// wkt_bounding_file_
+SEXP wkt_bounding_file_(std::string path, std::string format, std::string column_name, int column_index, int chunk_size, bool as_matrix, bool zm, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_bounding_file_(SEXP pathSEXP, SEXP formatSEXP, SEXP column_nameSEXP, SEXP column_indexSEXP, SEXP chunk_sizeSEXP, SEXP as_matrixSEXP, SEXP zmSEXP, SEXP nthreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< CharacterVector >::type wkt(wktSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< std::string >::type format(formatSEXP);
+    Rcpp::traits::input_parameter< std::string >::type column_name(column_nameSEXP);
+    Rcpp::traits::input_parameter< int >::type column_index(column_indexSEXP);
+    Rcpp::traits::input_parameter< int >::type chunk_size(chunk_sizeSEXP);
     Rcpp::traits::input_parameter< bool >::type as_matrix(as_matrixSEXP);
-    rcpp_result_gen = Rcpp::wrap(wkt_bounding(wkt, as_matrix));
+    Rcpp::traits::input_parameter< bool >::type zm(zmSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_bounding_file_(path, format, column_name, column_index, chunk_size, as_matrix, zm, nthreads));
     return rcpp_result_gen;
 END_RCPP
 }
 // wkt_coords
-DataFrame wkt_coords(CharacterVector wkt);
-RcppExport SEXP _wellknown_wkt_coords(SEXP wktSEXP) {
+DataFrame wkt_coords(SEXP wkt, bool zm, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_coords(SEXP wktSEXP, SEXP zmSEXP, SEXP nthreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< CharacterVector >::type wkt(wktSEXP);
-    rcpp_result_gen = Rcpp::wrap(wkt_coords(wkt));
+    Rcpp::traits::input_parameter< SEXP >::type wkt(wktSEXP);
+    Rcpp::traits::input_parameter< bool >::type zm(zmSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_coords(wkt, zm, nthreads));
     return rcpp_result_gen;
 END_RCPP
 }
 // wkt_correct
-CharacterVector wkt_correct(CharacterVector x);
-RcppExport SEXP _wellknown_wkt_correct(SEXP xSEXP) {
+CharacterVector wkt_correct(SEXP x, SEXP nthreads);
+RcppExport SEXP _wellknown_wkt_correct(SEXP xSEXP, SEXP nthreadsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< CharacterVector >::type x(xSEXP);
-    rcpp_result_gen = Rcpp::wrap(wkt_correct(x));
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type nthreads(nthreadsSEXP);
+    rcpp_result_gen = Rcpp::wrap(wkt_correct(x, nthreads));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
     {"_wellknown_bounding_wkt_points", (DL_FUNC) &_wellknown_bounding_wkt_points, 4},
+    {"_wellknown_bounding_wkt_matrix", (DL_FUNC) &_wellknown_bounding_wkt_matrix, 1},
     {"_wellknown_bounding_wkt_list", (DL_FUNC) &_wellknown_bounding_wkt_list, 1},
-    {"_wellknown_wkt_centroid", (DL_FUNC) &_wellknown_wkt_centroid, 1},
-    {"_wellknown_wkt_reverse", (DL_FUNC) &_wellknown_wkt_reverse, 1},
-    {"_wellknown_validate_wkt", (DL_FUNC) &_wellknown_validate_wkt, 1},
-    {"_wellknown_wkt_bounding", (DL_FUNC) &_wellknown_wkt_bounding, 2},
-    {"_wellknown_wkt_coords", (DL_FUNC) &_wellknown_wkt_coords, 1},
-    {"_wellknown_wkt_correct", (DL_FUNC) &_wellknown_wkt_correct, 1},
+    {"_wellknown_wkt_centroid", (DL_FUNC) &_wellknown_wkt_centroid, 3},
+    {"_wellknown_geojson2wkt_", (DL_FUNC) &_wellknown_geojson2wkt_, 5},
+    {"_wellknown_wkt_index", (DL_FUNC) &_wellknown_wkt_index, 2},
+    {"_wellknown_wkt_index_box_", (DL_FUNC) &_wellknown_wkt_index_box_, 6},
+    {"_wellknown_wkt_index_nearest_", (DL_FUNC) &_wellknown_wkt_index_nearest_, 5},
+    {"_wellknown_wkt_index_info_", (DL_FUNC) &_wellknown_wkt_index_info_, 1},
+    {"_wellknown_wkt_area", (DL_FUNC) &_wellknown_wkt_area, 3},
+    {"_wellknown_wkt_length", (DL_FUNC) &_wellknown_wkt_length, 3},
+    {"_wellknown_wkt_parse", (DL_FUNC) &_wellknown_wkt_parse, 1},
+    {"_wellknown_wkt_parsed_info_", (DL_FUNC) &_wellknown_wkt_parsed_info_, 1},
+    {"_wellknown_wkt_polyline_", (DL_FUNC) &_wellknown_wkt_polyline_, 3},
+    {"_wellknown_polyline_wkt_", (DL_FUNC) &_wellknown_polyline_wkt_, 3},
+    {"_wellknown_wkt_predicate_", (DL_FUNC) &_wellknown_wkt_predicate_, 4},
+    {"_wellknown_wkt_join_", (DL_FUNC) &_wellknown_wkt_join_, 4},
+    {"_wellknown_wkt_reverse", (DL_FUNC) &_wellknown_wkt_reverse, 2},
+    {"_wellknown_wkt_round", (DL_FUNC) &_wellknown_wkt_round, 3},
+    {"_wellknown_wkt_snap", (DL_FUNC) &_wellknown_wkt_snap, 3},
+    {"_wellknown_wkt_simplify", (DL_FUNC) &_wellknown_wkt_simplify, 5},
+    {"_wellknown_wellknown_stats", (DL_FUNC) &_wellknown_wellknown_stats, 1},
+    {"_wellknown_wkt_twkb_", (DL_FUNC) &_wellknown_wkt_twkb_, 7},
+    {"_wellknown_twkb_wkt_", (DL_FUNC) &_wellknown_twkb_wkt_, 2},
+    {"_wellknown_validate_wkt", (DL_FUNC) &_wellknown_validate_wkt, 3},
+    {"_wellknown_validate_wkt_file_", (DL_FUNC) &_wellknown_validate_wkt_file_, 7},
+    {"_wellknown_wkt_wkb_", (DL_FUNC) &_wellknown_wkt_wkb_, 4},
+    {"_wellknown_wkb_wkt_", (DL_FUNC) &_wellknown_wkb_wkt_, 4},
+    {"_wellknown_wkt2geojson_", (DL_FUNC) &_wellknown_wkt2geojson_, 5},
+    {"_wellknown_wkt_bounding", (DL_FUNC) &_wellknown_wkt_bounding, 4},
+    {"_wellknown_wkt_bounding_file_", (DL_FUNC) &_wellknown_wkt_bounding_file_, 8},
+    {"_wellknown_wkt_coords", (DL_FUNC) &_wellknown_wkt_coords, 3},
+    {"_wellknown_wkt_correct", (DL_FUNC) &_wellknown_wkt_correct, 2},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,223 @@
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#ifndef __WKT_ARENA__
+#define __WKT_ARENA__
+namespace wkt_utils {
+
+  /**
+   * A bump allocator: memory is handed out from large blocks by moving a
+   * pointer along, individual frees do nothing, and everything is given back
+   * at once by reset(). Blocks are kept between resets, so once an arena has
+   * grown to fit the largest row it sees, reading further rows allocates
+   * nothing at all.
+   *
+   * Each thread has its own arena (see thread_arena) which is only used
+   * while an arena_scope is open on that thread; outside of one, arena
+   * allocators fall through to the heap.
+   */
+  class arena {
+
+  public:
+
+    arena() : current(0), used(0), depth(0), allocation_count(0), block_count(0) {}
+
+    ~arena(){
+      for(unsigned int i = 0; i < blocks.size(); i++){
+        ::operator delete(blocks[i].data);
+      }
+    }
+
+    /**
+     * A function for getting memory, from the arena if a scope is open and
+     * from the heap if not
+     *
+     * @param bytes the number of bytes wanted
+     *
+     * @return a pointer to suitably aligned memory
+     */
+    inline void* allocate(size_t bytes){
+      allocation_count++;
+      if(!depth){
+        return ::operator new(bytes);
+      }
+      bytes = (bytes + alignment - 1) & ~(alignment - 1);
+      if(current < blocks.size() && used + bytes <= blocks[current].size){
+        void* out = blocks[current].data + used;
+        used += bytes;
+        return out;
+      }
+      return next_block(bytes);
+    }
+
+    /**
+     * A function for giving memory back. Memory from the arena is only
+     * reclaimed on reset, except that the most recent allocation is
+     * rolled back, which is what a growing vector does most.
+     *
+     * @param p a pointer returned by allocate
+     *
+     * @param bytes the number of bytes asked for
+     */
+    inline void deallocate(void* p, size_t bytes){
+      if(!owns(p)){
+        ::operator delete(p);
+        return;
+      }
+      bytes = (bytes + alignment - 1) & ~(alignment - 1);
+      if(current < blocks.size() && static_cast<char*>(p) + bytes == blocks[current].data + used){
+        used -= bytes;
+      }
+    }
+
+    /**
+     * Functions for counting the allocations the arena has served (from the
+     * heap or not) and the blocks it has taken from the heap, over its life
+     */
+    inline size_t allocations() const {
+      return allocation_count;
+    }
+
+    inline size_t heap_blocks() const {
+      return block_count;
+    }
+
+    inline void open(){
+      depth++;
+    }
+
+    /**
+     * A function for closing a scope, resetting the arena once the
+     * outermost one closes
+     */
+    inline void close(){
+      if(--depth == 0){
+        reset();
+      }
+    }
+
+  private:
+
+    struct block {
+      char* data;
+      size_t size;
+    };
+
+    static const size_t alignment = 16;
+    static const size_t block_size = 64 * 1024;
+    // Blocks beyond this many are given back to the heap on reset, so that
+    // one very large object doesn't pin memory for the rest of the session
+    static const unsigned int retained = 16;
+
+    std::vector < block > blocks;
+    size_t current;
+    size_t used;
+    unsigned int depth;
+    size_t allocation_count;
+    size_t block_count;
+
+    inline bool owns(void* p) const {
+      const char* x = static_cast<const char*>(p);
+      for(unsigned int i = 0; i < blocks.size(); i++){
+        if(x >= blocks[i].data && x < blocks[i].data + blocks[i].size){
+          return true;
+        }
+      }
+      return false;
+    }
+
+    void* next_block(size_t bytes){
+      while(++current < blocks.size()){
+        if(blocks[current].size >= bytes){
+          used = bytes;
+          return blocks[current].data;
+        }
+      }
+      block b = {static_cast<char*>(::operator new(bytes > block_size ? bytes : block_size)),
+                 bytes > block_size ? bytes : block_size};
+      blocks.push_back(b);
+      block_count++;
+      current = blocks.size() - 1;
+      used = bytes;
+      return b.data;
+    }
+
+    inline void reset(){
+      while(blocks.size() > retained){
+        ::operator delete(blocks.back().data);
+        blocks.pop_back();
+      }
+      current = 0;
+      used = 0;
+    }
+  };
+
+  /**
+   * A function for getting the calling thread's arena
+   */
+  inline arena& thread_arena(){
+    static thread_local arena out;
+    return out;
+  }
+
+  /**
+   * Opens the calling thread's arena for as long as it is in scope; when
+   * the outermost scope closes, everything allocated in it is released at
+   * once. Anything allocated from the arena must therefore be destroyed
+   * before the scope that was open when it was allocated - declare the
+   * scope first.
+   */
+  class arena_scope {
+  public:
+    arena_scope() : a(thread_arena()) {
+      a.open();
+    }
+    ~arena_scope(){
+      a.close();
+    }
+  private:
+    arena& a;
+    arena_scope(const arena_scope&);
+    arena_scope& operator=(const arena_scope&);
+  };
+
+  /**
+   * A standard allocator over the calling thread's arena, for use as the
+   * allocator of the boost::geometry model types in def.h
+   */
+  template <typename T>
+  struct arena_allocator {
+
+    typedef T value_type;
+
+    arena_allocator() {}
+
+    template <typename U>
+    arena_allocator(const arena_allocator<U>&) {}
+
+    inline T* allocate(size_t n){
+      return static_cast<T*>(thread_arena().allocate(n * sizeof(T)));
+    }
+
+    inline void deallocate(T* p, size_t n){
+      thread_arena().deallocate(p, n * sizeof(T));
+    }
+
+    template <typename U>
+    struct rebind {
+      typedef arena_allocator<U> other;
+    };
+  };
+
+  template <typename T, typename U>
+  inline bool operator==(const arena_allocator<T>&, const arena_allocator<U>&){
+    return true;
+  }
+
+  template <typename T, typename U>
+  inline bool operator!=(const arena_allocator<T>&, const arena_allocator<U>&){
+    return false;
+  }
+}
+#endif
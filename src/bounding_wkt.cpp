@@ -1,65 +1,104 @@
 #include <Rcpp.h>
 using namespace Rcpp;
 #include "utils.h"
+#include "writer.h"
 using namespace wkt_utils;
 //[[Rcpp::depends(BH)]]
 
-//[[Rcpp::export]]
-CharacterVector bounding_wkt_points(NumericVector min_x, NumericVector max_x, NumericVector min_y, NumericVector max_y){
-
-  signed int input_size = min_x.size();
-  if(max_x.size() != input_size || min_y.size() != input_size || max_y.size() != input_size){
-    Rcpp::stop("All input vectors must be the same length");
+/**
+ * Writes one box, or NA if any of its values are
+ */
+inline void set_box(CharacterVector& output, R_xlen_t i, std::string& holding,
+                    geometry_text_writer& writer, double min_x, double min_y,
+                    double max_x, double max_y){
+  if(ISNAN(min_x) || ISNAN(min_y) || ISNAN(max_x) || ISNAN(max_y)){
+    SET_STRING_ELT(output, i, NA_STRING);
+    return;
   }
+  holding.clear();
+  writer.write_box(min_x, min_y, max_x, max_y);
+  SET_STRING_ELT(output, i, Rf_mkCharLenCE(holding.data(), holding.size(), CE_UTF8));
+}
+
+/**
+ * Writes a box for each row of four columns of doubles
+ */
+CharacterVector write_boxes(const double* min_x, const double* min_y, const double* max_x,
+                            const double* max_y, R_xlen_t input_size){
 
   CharacterVector output(input_size);
-  box_type bx;
-  polygon_type poly;
+  // One buffer for every row; each CHARSXP is made straight from it
+  std::string holding;
+  geometry_text_writer writer(holding);
 
-  for(signed int i = 0; i < input_size; i++){
+  for(R_xlen_t i = 0; i < input_size; i++){
     if((i % 10000) == 0){
       Rcpp::checkUserInterrupt();
     }
-    if(NumericVector::is_na(min_x[i]) || NumericVector::is_na(max_x[i]) ||
-       NumericVector::is_na(min_y[i]) || NumericVector::is_na(max_y[i])){
-      output[i] = NA_STRING;
-    } else {
-      bx = boost::geometry::make<box_type>(min_x[i], min_y[i], max_x[i], max_y[i]);
-      boost::geometry::convert(bx, poly);
-      output[i] = wkt_utils::make_wkt_poly(poly);
-    }
+    set_box(output, i, holding, writer, min_x[i], min_y[i], max_x[i], max_y[i]);
   }
   return output;
 }
 
+//[[Rcpp::export]]
+CharacterVector bounding_wkt_points(NumericVector min_x, NumericVector max_x, NumericVector min_y, NumericVector max_y){
+
+  R_xlen_t input_size = min_x.size();
+  if(max_x.size() != input_size || min_y.size() != input_size || max_y.size() != input_size){
+    Rcpp::stop("All input vectors must be the same length");
+  }
+  return write_boxes(REAL(min_x), REAL(min_y), REAL(max_x), REAL(max_y), input_size);
+}
+
+//[[Rcpp::export]]
+CharacterVector bounding_wkt_matrix(NumericMatrix x){
+
+  if(x.ncol() != 4){
+    Rcpp::stop("A matrix of bounding boxes must have four columns");
+  }
+  R_xlen_t input_size = x.nrow();
+  const double* cols = REAL(x);
+  return write_boxes(cols, cols + input_size, cols + 2 * input_size, cols + 3 * input_size,
+                     input_size);
+}
+
 //[[Rcpp::export]]
 CharacterVector bounding_wkt_list(List x){
 
-  unsigned int input_size = x.size();
+  R_xlen_t input_size = x.size();
   CharacterVector output(input_size);
-  box_type bx;
-  polygon_type poly;
-  NumericVector holding;
+  std::string holding;
+  geometry_text_writer writer(holding);
 
-  for(unsigned int i = 0; i < input_size; i++){
+  for(R_xlen_t i = 0; i < input_size; i++){
     if((i % 10000) == 0){
       Rcpp::checkUserInterrupt();
     }
-    try {
-      holding = Rcpp::as<NumericVector>(x[i]);
-    } catch(...){
-      output[i] = NA_STRING;
+    SEXP values = VECTOR_ELT(x, i);
+    if(Rf_xlength(values) != 4){
+      SET_STRING_ELT(output, i, NA_STRING);
+      continue;
     }
-    if(holding.size() != 4 || NumericVector::is_na(holding[0]) || NumericVector::is_na(holding[1]) ||
-      NumericVector::is_na(holding[2]) || NumericVector::is_na(holding[3])){
-      output[i] = NA_STRING;
-    } else {
-      bx = boost::geometry::make<box_type>(holding[0], holding[1], holding[2], holding[3]);
-      boost::geometry::convert(bx, poly);
-      std::stringstream ss;
-      ss << boost::geometry::wkt(poly);
-      output[i] = ss.str();
+    // Doubles are read where they are; anything else that can be made
+    // into them is converted, and anything that can't is NA
+    double box[4];
+    switch(TYPEOF(values)){
+    case REALSXP:
+      std::copy(REAL(values), REAL(values) + 4, box);
+      break;
+    case LGLSXP:
+    case INTSXP:
+    case CPLXSXP:
+    case RAWSXP:
+      values = PROTECT(Rf_coerceVector(values, REALSXP));
+      std::copy(REAL(values), REAL(values) + 4, box);
+      UNPROTECT(1);
+      break;
+    default:
+      SET_STRING_ELT(output, i, NA_STRING);
+      continue;
     }
+    set_box(output, i, holding, writer, box[0], box[1], box[2], box[3]);
   }
   return output;
 }
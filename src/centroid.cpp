@@ -1,94 +1,132 @@
 #include <Rcpp.h>
 using namespace Rcpp;
 #include "utils.h"
+#include "parallel.h"
+#include "streaming.h"
+#include "stats.h"
+#include "memo.h"
+#include "geodesic.h"
 using namespace wkt_utils;
 
-template <typename T>
-void centroid_single(std::string wkt, T& geom_obj,
-                     unsigned int& outlength,
-                     NumericVector& lat,
-                     NumericVector& lng){
-  
-  point_type p;
-  // point_type p(0,0,0)
-  // boost::geometry::set<0>(point_type,0);
-  // boost::geometry::set<1>(point_type,0);
-  try{
-    boost::geometry::read_wkt(wkt, geom_obj);
-    boost::geometry::centroid(geom_obj, p);
-  } catch(...){
-    lat[outlength] = NA_REAL;
-    lng[outlength] = NA_REAL;
-    return;
+template <typename Handler>
+struct centroid_worker {
+
+  const wkt_input& wkt;
+  double* lat;
+  double* lng;
+  call_stats& stats;
+  Handler prototype;
+
+  centroid_worker(const wkt_input& wkt, double* lat, double* lng, call_stats& stats,
+                  const Handler& prototype = Handler())
+    : wkt(wkt), lat(lat), lng(lng), stats(stats), prototype(prototype) {}
+
+  void operator()(unsigned int i){
+    double x, y;
+    row_stats row(stats.local());
+    if(wkt.is_na(i)){
+      row.row(-1);
+      lat[i] = NA_REAL;
+      lng[i] = NA_REAL;
+      return;
+    }
+    row.row(wkt.size(i));
+    Handler centroid(prototype);
+    try{
+      wkt.read(i, centroid);
+    } catch(boost::geometry::read_wkt_exception &e){
+      lat[i] = NA_REAL;
+      lng[i] = NA_REAL;
+      row.lap(parse_phase);
+      row.failed(wkt, i);
+      return;
+    }
+    row.lap(parse_phase);
+    if(!centroid.result(x, y)){
+      lat[i] = NA_REAL;
+      lng[i] = NA_REAL;
+      return;
+    }
+    lat[i] = y;
+    lng[i] = x;
   }
+};
 
-  lat[outlength] = boost::geometry::get<1>(p);
-  lng[outlength] = boost::geometry::get<0>(p);
-}
+// Centroids of repeated objects, kept between calls if the wellknown.cache
+// option is set; one cache for each geodesic
+static result_cache centroid_cache(2);
+static result_cache spherical_centroid_cache(2);
+static result_cache ellipsoidal_centroid_cache(2);
 
 //' @title Extract Centroid
 //' @description `get_centroid` identifies the 2D centroid
-//' in a WKT object (or vector of WKT objects). Note that it assumes
-//' cartesian values.
+//' in a WKT object (or vector of WKT objects). By default it assumes
+//' cartesian values; see `geodesic` for longitudes and latitudes. The
+//' centroid of a GeometryCollection is that of its members of the highest
+//' dimension: its polygons, if it has any with an area, otherwise its
+//' lines, otherwise its points.
 //' @export
-//' @param wkt a character vector of WKT objects, represented as strings
+//' @param wkt a character vector of WKT objects, represented as strings, or
+//' a list of raw vectors of WKB objects (or a single raw vector), or a
+//' `wkt_parsed` object from [wkt_parse()]
+//' @param geodesic how to find the centroid: `"none"` (the default), on
+//' the plane; `"spherical"`, on the sphere, taking coordinates to be
+//' longitudes and latitudes in degrees, which is right across the
+//' antimeridian and around the poles; or `"ellipsoidal"`, as for
+//' `"spherical"` but with the latitudes taken to be geodetic ones on the
+//' WGS84 ellipsoid. On the sphere, each ring is taken to enclose the
+//' smaller of the two areas it divides the sphere into.
+//' @template nthreads
 //' @return a data.frame of two columns, `lat` and `lng`,
 //' with each row containing the centroid from the corresponding wkt
 //' object. In the case that the object is NA (or cannot be decoded)
 //' the resulting values will also be NA
+//' @details Identical WKT strings are only read once per call, and with
+//' the `wellknown.cache` option set, centroids are remembered between calls
+//' too; see the Caching section of [wellknown-package].
 //' @seealso [wkt_coords()] to extract all coordinates, and
-//' [wkt_bounding()] to extract a bounding box.
+//' [wkt_bounding()] to extract a bounding box, and [wkt_area()] to
+//' measure areas on the earth.
 //' @examples
 //' wkt_centroid("POLYGON((2 1.3,2.4 1.7))")
+//' wkt_centroid("LINESTRING (179 10, -179 10)", geodesic = "spherical")
 // [[Rcpp::export]]
-DataFrame wkt_centroid(CharacterVector wkt){
+DataFrame wkt_centroid(SEXP wkt, std::string geodesic = "none", SEXP nthreads = R_NilValue){
 
-  point_type pt;
-  linestring_type ls;
-  polygon_type poly;
-  multipoint_type multip;
-  multilinestring_type multil;
-  multipolygon_type multipoly;
-  std::string holding;
-  unsigned int input_size = wkt.size();
+  geodesic_mode mode = get_geodesic_mode(geodesic);
+  int threads = resolve_threads(nthreads);
+  call_stats stats("wkt_centroid", threads);
+  wkt_input input(wkt);
+  unsigned int input_size = input.length();
   NumericVector lat(input_size);
   NumericVector lng(input_size);
 
-  for(unsigned int i = 0; i < input_size; i++){
-    if((i % 10000) == 0){
-      Rcpp::checkUserInterrupt();
-    }
-    if(wkt[i] == NA_STRING){
-      lat[i] = NA_REAL;
-      lng[i] = NA_REAL;
-    } else {
-      holding = as<std::string>(wkt[i]);
-      switch(id_type(holding)){
-      case point:
-        centroid_single(holding, pt, i, lat, lng);
-        break;
-      case line_string:
-        centroid_single(holding, ls, i, lat, lng);
-        break;
-      case polygon:
-        centroid_single(holding, poly, i, lat, lng);
-        break;
-      case multi_point:
-        centroid_single(holding, multip, i, lat, lng);
-        break;
-      case multi_line_string:
-        centroid_single(holding, multil, i, lat, lng);
-        break;
-      case multi_polygon:
-        centroid_single(holding, multipoly, i, lat, lng);
-        break;
-      default:
-        lat[i] = NA_REAL;
-        lng[i] = NA_REAL;
-      }
-    }
+  double* cols[] = {REAL(lng), REAL(lat)};
+  switch(mode){
+  case planar_mode: {
+    row_memo memo(input, cols, 2, centroid_cache);
+    memo.run(threads, centroid_worker<centroid_handler>(input, REAL(lat), REAL(lng), stats));
+    memo.finish();
+    break;
+  }
+  case spherical_mode: {
+    row_memo memo(input, cols, 2, spherical_centroid_cache);
+    memo.run(threads, centroid_worker<spherical_centroid_handler>(input, REAL(lat), REAL(lng), stats));
+    memo.finish();
+    break;
+  }
+  default: {
+    row_memo memo(input, cols, 2, ellipsoidal_centroid_cache);
+    memo.run(threads, centroid_worker<spherical_centroid_handler>(input, REAL(lat), REAL(lng), stats,
+                                                                  spherical_centroid_handler(true)));
+    memo.finish();
+  }
   }
 
-  return DataFrame::create(_["lng"] = lng,
-                           _["lat"] = lat);
+  row_stats row(stats.local());
+  DataFrame result = DataFrame::create(_["lng"] = lng,
+                                       _["lat"] = lat);
+  row.lap(output_phase);
+  stats.finish();
+  return result;
 }
@@ -1,16 +1,18 @@
-#include <Rcpp.h>
 //[[Rcpp::depends(BH)]]
 #include <boost/geometry.hpp>
 #include <boost/geometry/geometries/point_xy.hpp>
+#include "arena.h"
 
-using namespace Rcpp;
-
+// The cartesian containers take their memory from the calling thread's arena
+// when an arena_scope is open (and from the heap otherwise); see arena.h
 typedef boost::geometry::model::point<double, 2, boost::geometry::cs::cartesian> point_type;
 typedef boost::geometry::model::point<double, 2, boost::geometry::cs::spherical_equatorial<boost::geometry::degree> > s_point_type;
-typedef boost::geometry::model::linestring<point_type> linestring_type;
-typedef boost::geometry::model::polygon<point_type> polygon_type;
+typedef boost::geometry::model::point<double, 2, boost::geometry::cs::geographic<boost::geometry::degree> > g_point_type;
+typedef boost::geometry::model::linestring<point_type, std::vector, wkt_utils::arena_allocator> linestring_type;
+typedef boost::geometry::model::polygon<point_type, true, true, std::vector, std::vector,
+                                        wkt_utils::arena_allocator, wkt_utils::arena_allocator> polygon_type;
 typedef boost::geometry::model::box<point_type> box_type;
-typedef boost::geometry::model::multi_point<point_type> multipoint_type;
-typedef boost::geometry::model::multi_linestring<linestring_type> multilinestring_type;
-typedef boost::geometry::model::multi_polygon<polygon_type> multipolygon_type;
+typedef boost::geometry::model::multi_point<point_type, std::vector, wkt_utils::arena_allocator> multipoint_type;
+typedef boost::geometry::model::multi_linestring<linestring_type, std::vector, wkt_utils::arena_allocator> multilinestring_type;
+typedef boost::geometry::model::multi_polygon<polygon_type, std::vector, wkt_utils::arena_allocator> multipolygon_type;
 typedef boost::geometry::model::polygon<s_point_type> s_polygon_type;
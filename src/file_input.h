@@ -0,0 +1,412 @@
+#include <Rcpp.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "json.h"
+#include "utils.h"
+
+#ifndef __WKT_FILE_INPUT__
+#define __WKT_FILE_INPUT__
+namespace wkt_utils {
+
+  enum file_format { text_format, csv_format, ndjson_format };
+
+  /**
+   * A function for identifying a file format from its name, as passed
+   * down from R
+   */
+  inline file_format get_file_format(const std::string& name){
+    if(name == "text"){
+      return text_format;
+    }
+    if(name == "csv"){
+      return csv_format;
+    }
+    if(name == "ndjson"){
+      return ndjson_format;
+    }
+    Rcpp::stop("'format' must be one of \"text\", \"csv\" or \"ndjson\"");
+  }
+
+  /**
+   * A json_handler that picks a single top-level string field out of an
+   * object
+   */
+  struct field_handler : json_handler {
+
+    const std::string& name;
+    std::string& value;
+    bool found;
+    bool wanted;
+    unsigned int depth;
+
+    field_handler(const std::string& name, std::string& value)
+      : name(name), value(value), found(false), wanted(false), depth(0) {}
+
+    inline void begin_object(){
+      depth++;
+      wanted = false;
+    }
+
+    inline void end_object(){
+      depth--;
+    }
+
+    inline void begin_array(){
+      depth++;
+      wanted = false;
+    }
+
+    inline void end_array(){
+      depth--;
+    }
+
+    inline void key(const std::string& x){
+      wanted = (depth == 1 && x == name);
+    }
+
+    inline void string(const std::string& x){
+      if(wanted){
+        value = x;
+        found = true;
+        wanted = false;
+      }
+    }
+
+    inline void number(double){
+      wanted = false;
+    }
+
+    inline void boolean(bool){
+      wanted = false;
+    }
+
+    inline void null(){
+      wanted = false;
+    }
+  };
+
+  /**
+   * WKT read from a file a chunk of rows at a time, so that files far larger
+   * than memory can be run through the same kernels as character vectors.
+   * Only the current chunk (and a read buffer) is ever held: each call to
+   * next() replaces it with the following rows.
+   *
+   * Files can hold one WKT object per line (text), a column of a CSV file
+   * with a header row (where WKT, which contains commas, is quoted in the
+   * usual way - doubled quotes within a quoted field, which may also span
+   * lines), or a string field of newline-delimited JSON objects. Empty
+   * lines and fields, unquoted NA in CSV, and missing or null JSON fields
+   * give NA rows; so do JSON lines that can't be parsed.
+   */
+  class wkt_file {
+
+  public:
+
+    /**
+     * @param path the path to the file
+     *
+     * @param format the file's format
+     *
+     * @param column_name the name of the CSV column or JSON field holding the
+     * WKT; for CSV, may be empty if column_index is given instead
+     *
+     * @param column_index the 0-based position of the CSV column, or -1
+     *
+     * @param chunk_size the maximum number of rows in a chunk
+     */
+    wkt_file(const std::string& path, file_format format, const std::string& column_name,
+             int column_index, unsigned int chunk_size)
+      : format(format), column_name(column_name), column_index(column_index),
+        chunk_size(chunk_size), start(0), filled(0), at_eof(false), header(format == csv_format),
+        offset(0) {
+      file = std::fopen(path.c_str(), "rb");
+      if(file == NULL){
+        Rcpp::stop("Cannot open file '" + path + "'");
+      }
+      buffer.resize(initial_buffer);
+    }
+
+    ~wkt_file(){
+      std::fclose(file);
+    }
+
+    /**
+     * A function for reading the next chunk of rows
+     *
+     * @return whether there were any rows left to read
+     */
+    bool next(){
+      offset += data.size();
+      values.clear();
+      ends.clear();
+      missing.clear();
+
+      while(missing.size() < chunk_size){
+        size_t used = read_record();
+        if(used == 0){
+          if(at_eof){
+            break;
+          }
+          refill();
+          continue;
+        }
+        start += used;
+      }
+
+      // values only stops growing once the chunk is complete, so the
+      // pointers into it are taken at the end
+      data.resize(missing.size());
+      sizes.resize(missing.size());
+      for(unsigned int i = 0; i < missing.size(); i++){
+        size_t from = i ? ends[i - 1] : 0;
+        data[i] = missing[i] ? NULL : values.data() + from;
+        sizes[i] = ends[i] - from;
+      }
+      return !data.empty();
+    }
+
+    /**
+     * A function for getting the current chunk, ready for a kernel
+     */
+    inline wkt_input input() const {
+      return wkt_input(data, sizes);
+    }
+
+    inline unsigned int rows() const {
+      return data.size();
+    }
+
+    /**
+     * A function for getting the number of rows read before the current
+     * chunk
+     */
+    inline size_t first_row() const {
+      return offset;
+    }
+
+  private:
+
+    static const size_t initial_buffer = 4 * 1024 * 1024;
+
+    std::FILE* file;
+    file_format format;
+    std::string column_name;
+    int column_index;
+    unsigned int chunk_size;
+
+    std::vector < char > buffer;
+    size_t start;
+    size_t filled;
+    bool at_eof;
+    bool header;
+    size_t offset;
+
+    std::string values;
+    std::vector < size_t > ends;
+    std::vector < char > missing;
+    std::vector < const char* > data;
+    std::vector < R_xlen_t > sizes;
+    std::string field;
+    std::string json_value;
+
+    wkt_file(const wkt_file&);
+    wkt_file& operator=(const wkt_file&);
+
+    /**
+     * A function for moving what's left of the buffer to its front and
+     * reading more of the file in after it, growing the buffer if a single
+     * record fills it
+     */
+    void refill(){
+      if(start > 0){
+        std::copy(buffer.begin() + start, buffer.begin() + filled, buffer.begin());
+        filled -= start;
+        start = 0;
+      }
+      if(filled == buffer.size()){
+        buffer.resize(buffer.size() * 2);
+      }
+      size_t got = std::fread(&buffer[filled], 1, buffer.size() - filled, file);
+      if(got == 0){
+        if(std::ferror(file)){
+          Rcpp::stop("Error reading from file");
+        }
+        at_eof = true;
+      }
+      filled += got;
+    }
+
+    inline void add_na(){
+      ends.push_back(values.size());
+      missing.push_back(true);
+    }
+
+    inline void add_value(const char* x, size_t size){
+      if(size == 0){
+        add_na();
+        return;
+      }
+      values.append(x, size);
+      ends.push_back(values.size());
+      missing.push_back(false);
+    }
+
+    /**
+     * A function for finding the end of the record starting at the front of
+     * the buffer - the next newline, or for CSV the next one outside quotes
+     *
+     * @return a pointer to the newline (or the end of the file's last
+     * record), or NULL if more of the file is needed to tell
+     */
+    const char* record_end(const char* p, const char* end) const {
+      if(format == csv_format){
+        bool quoted = false;
+        for(; p < end; p++){
+          if(*p == '"'){
+            quoted = !quoted;
+          } else if(*p == '\n' && !quoted){
+            return p;
+          }
+        }
+      } else {
+        const char* found = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        if(found != NULL){
+          return found;
+        }
+      }
+      return at_eof ? end : NULL;
+    }
+
+    /**
+     * A function for reading one record from the front of the buffer
+     *
+     * @return the number of bytes used, or 0 if the buffer doesn't hold a
+     * complete record
+     */
+    size_t read_record(){
+      const char* begin = buffer.data() + start;
+      const char* end = buffer.data() + filled;
+      if(begin == end){
+        return 0;
+      }
+      const char* stop = record_end(begin, end);
+      if(stop == NULL){
+        return 0;
+      }
+      size_t used = (stop - begin) + (stop < end ? 1 : 0);
+      if(stop > begin && stop[-1] == '\r'){
+        stop--;
+      }
+
+      switch(format){
+      case text_format:
+        add_value(begin, stop - begin);
+        break;
+      case csv_format:
+        csv_record(begin, stop);
+        break;
+      default:
+        json_record(begin, stop);
+      }
+      return used;
+    }
+
+    /**
+     * A function for reading one CSV field, unquoting it into `field`
+     *
+     * @return whether the field was quoted
+     */
+    bool csv_field(const char*& p, const char* end){
+      field.clear();
+      if(p < end && *p == '"'){
+        p++;
+        while(p < end){
+          if(*p == '"'){
+            if(p + 1 < end && p[1] == '"'){
+              field += '"';
+              p += 2;
+              continue;
+            }
+            p++;
+            break;
+          }
+          field += *p++;
+        }
+        // Anything between the closing quote and the comma is dropped
+        while(p < end && *p != ','){
+          p++;
+        }
+        return true;
+      }
+      const char* from = p;
+      while(p < end && *p != ','){
+        p++;
+      }
+      field.assign(from, p - from);
+      return false;
+    }
+
+    void csv_record(const char* p, const char* end){
+      int index = 0;
+      if(header){
+        header = false;
+        bool found = column_index >= 0;
+        while(!found && p <= end){
+          csv_field(p, end);
+          if(field == column_name){
+            column_index = index;
+            found = true;
+          }
+          index++;
+          p++;
+        }
+        if(!found){
+          Rcpp::stop("Column '" + column_name + "' was not found in the file's header");
+        }
+        return;
+      }
+
+      while(p <= end){
+        bool quoted = csv_field(p, end);
+        if(index == column_index){
+          if(!quoted && field == "NA"){
+            add_na();
+          } else {
+            add_value(field.data(), field.size());
+          }
+          return;
+        }
+        index++;
+        p++;
+      }
+      // The record is short of the column
+      add_na();
+    }
+
+    void json_record(const char* p, const char* end){
+      while(p < end && (*p == ' ' || *p == '\t')){
+        p++;
+      }
+      // Blank lines, such as one after the last record, aren't rows at all
+      if(p == end){
+        return;
+      }
+      field_handler handler(column_name, json_value);
+      try {
+        read_json(p, end - p, handler);
+      } catch (json_exception &e){
+        add_na();
+        return;
+      }
+      if(handler.found){
+        add_value(json_value.data(), json_value.size());
+      } else {
+        add_na();
+      }
+    }
+  };
+}
+#endif
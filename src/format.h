@@ -0,0 +1,192 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <boost/cstdint.hpp>
+
+#ifndef __WKT_FORMAT__
+#define __WKT_FORMAT__
+namespace wkt_utils {
+
+  namespace detail {
+
+    static const double exact_powers[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    static const boost::uint64_t integer_powers[] = {
+      1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+      100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+      1000000000000ULL, 10000000000000ULL, 100000000000000ULL, 1000000000000000ULL
+    };
+
+    /**
+     * A function for rounding a positive, finite number to a given number of
+     * significant digits, without going through printf
+     *
+     * @param x the number
+     *
+     * @param digits the number of significant digits, at most 15
+     *
+     * @param mantissa the digits, as an integer of exactly `digits` digits
+     *
+     * @param exponent the power of ten of the first digit
+     *
+     * @return whether the result is certain to be what printf would give;
+     * if not, the caller should fall back to printf
+     */
+    inline bool round_digits(double x, int digits, boost::uint64_t& mantissa, int& exponent){
+      exponent = static_cast<int>(std::floor(std::log10(x)));
+      int shift = digits - 1 - exponent;
+      if(shift > 22 || shift < -22){
+        return false;
+      }
+      // One correctly rounded operation, so scaled is within half an ulp of
+      // the exact product
+      double scaled = shift >= 0 ? x * exact_powers[shift] : x / exact_powers[-shift];
+      double whole = std::floor(scaled);
+      double fraction = scaled - whole;
+      // Too close to halfway to be sure which way the exact value rounds
+      if(std::fabs(fraction - 0.5) <= scaled * 2.3e-16 + 1e-300){
+        return false;
+      }
+      mantissa = static_cast<boost::uint64_t>(whole) + (fraction > 0.5);
+      if(mantissa == integer_powers[digits]){
+        mantissa = integer_powers[digits - 1];
+        exponent++;
+      } else if(mantissa < integer_powers[digits - 1] || mantissa > integer_powers[digits]){
+        // log10 put the first digit in the wrong place
+        return false;
+      }
+      return true;
+    }
+
+    /**
+     * A function for writing digits out the way printf's %g does: plain
+     * notation unless the exponent is below -4 or at least `precision`,
+     * and without trailing zeros
+     */
+    inline int write_digits(char* out, bool negative, boost::uint64_t mantissa, int digits,
+                            int exponent, int precision){
+      while(digits > 1 && mantissa % 10 == 0){
+        mantissa /= 10;
+        digits--;
+      }
+      char text[24];
+      for(int i = digits - 1; i >= 0; i--){
+        text[i] = '0' + (mantissa % 10);
+        mantissa /= 10;
+      }
+
+      char* start = out;
+      if(negative){
+        *out++ = '-';
+      }
+      if(exponent < -4 || exponent >= precision){
+        *out++ = text[0];
+        if(digits > 1){
+          *out++ = '.';
+          for(int i = 1; i < digits; i++){
+            *out++ = text[i];
+          }
+        }
+        *out++ = 'e';
+        *out++ = exponent < 0 ? '-' : '+';
+        int power = exponent < 0 ? -exponent : exponent;
+        if(power >= 100){
+          *out++ = '0' + power / 100;
+        }
+        *out++ = '0' + (power / 10) % 10;
+        *out++ = '0' + power % 10;
+      } else if(exponent < 0){
+        *out++ = '0';
+        *out++ = '.';
+        for(int i = -1; i > exponent; i--){
+          *out++ = '0';
+        }
+        for(int i = 0; i < digits; i++){
+          *out++ = text[i];
+        }
+      } else {
+        for(int i = 0; i < digits; i++){
+          if(i == exponent + 1){
+            *out++ = '.';
+          }
+          *out++ = text[i];
+        }
+        for(int i = digits; i <= exponent; i++){
+          *out++ = '0';
+        }
+      }
+      return out - start;
+    }
+  }
+
+  /**
+   * A function for writing a number as text, as printf's "%.*g" would but
+   * several times faster. Most numbers are rounded with integer arithmetic;
+   * the few that land too close to a tie, or that need more than 15 digits,
+   * go through printf.
+   *
+   * @param out a buffer of at least 32 characters to write to
+   *
+   * @param x the number
+   *
+   * @param digits the number of significant digits to write (as with
+   * "%.*g"), or 0 for the fewest digits that read back as exactly x
+   *
+   * @return the number of characters written; out is not NUL-terminated
+   */
+  inline int format_double(char* out, double x, int digits){
+    if(x == 0 && digits >= 0 && digits <= 17){
+      if(std::signbit(x)){
+        out[0] = '-';
+        out[1] = '0';
+        return 2;
+      }
+      out[0] = '0';
+      return 1;
+    }
+
+    boost::uint64_t mantissa;
+    int exponent;
+    bool finite = std::isfinite(x);
+    double magnitude = std::fabs(x);
+
+    if(digits == 0){
+      if(finite && detail::round_digits(magnitude, 15, mantissa, exponent)){
+        // Fewer than 16 digits read back exactly if the (exactly representable)
+        // mantissa, scaled by an exact power of ten, is x again
+        boost::uint64_t trimmed = mantissa;
+        int trimmed_digits = 15;
+        while(trimmed % 10 == 0){
+          trimmed /= 10;
+          trimmed_digits--;
+        }
+        int shift = trimmed_digits - 1 - exponent;
+        if(shift <= 22 && shift >= -22){
+          double back = shift >= 0 ? static_cast<double>(trimmed) / detail::exact_powers[shift] :
+            static_cast<double>(trimmed) * detail::exact_powers[-shift];
+          if(back == magnitude){
+            return detail::write_digits(out, x < 0, trimmed, trimmed_digits, exponent, 17);
+          }
+        }
+      }
+      int size = 0;
+      for(int precision = 15; precision <= 17; precision++){
+        size = snprintf(out, 32, "%.*g", precision, x);
+        if(!finite || std::strtod(out, NULL) == x){
+          break;
+        }
+      }
+      return size;
+    }
+
+    if(finite && digits > 0 && digits <= 15 &&
+       detail::round_digits(magnitude, digits, mantissa, exponent)){
+      return detail::write_digits(out, x < 0, mantissa, digits, exponent, digits);
+    }
+    return snprintf(out, 32, "%.*g", digits, x);
+  }
+}
+#endif
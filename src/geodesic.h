@@ -0,0 +1,24 @@
+#include <Rcpp.h>
+#include <string>
+
+#ifndef __WKT_GEODESIC__
+#define __WKT_GEODESIC__
+namespace wkt_utils {
+
+  /**
+   * How the kernels that take a geodesic argument treat coordinates: as
+   * cartesian, or as longitudes and latitudes in degrees on a sphere or
+   * on the WGS84 ellipsoid
+   */
+  enum geodesic_mode { planar_mode, spherical_mode, ellipsoidal_mode };
+
+  /**
+   * A function for reading a geodesic argument
+   *
+   * @param geodesic "none", "spherical" or "ellipsoidal"
+   *
+   * @return the mode; anything else is an error
+   */
+  geodesic_mode get_geodesic_mode(std::string geodesic);
+}
+#endif
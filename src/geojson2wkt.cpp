@@ -0,0 +1,791 @@
+#include <Rcpp.h>
+using namespace Rcpp;
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include "json.h"
+using namespace wkt_utils;
+
+/**
+ * How a group of numbers is laid out: the field width, the number of digits
+ * after the decimal point, and whether scientific notation is used
+ */
+struct number_layout {
+  int width;
+  int digits;
+  bool scientific;
+};
+
+/**
+ * Formats numbers the way R's format(x, nsmall = fmt) does, so that JSON
+ * converted here comes out exactly as lists converted by the R dumpers do.
+ * A group of numbers shares a single layout: enough significant digits (up
+ * to getOption("digits")) for every member, fixed notation unless it is
+ * wider than scientific notation by more than getOption("scipen"), and at
+ * least nsmall digits after the decimal point in fixed notation. Each
+ * number's digits are taken from printf's own rounding of it.
+ */
+class r_formatter {
+
+public:
+
+  r_formatter(int digits, int scipen, int nsmall) : digits(digits), scipen(scipen), nsmall(nsmall) {}
+
+  /**
+   * A function for working out the layout format() would give a group
+   *
+   * @param x a pointer to the numbers in the group
+   *
+   * @param n the number of numbers in the group
+   *
+   * @return the layout to format each member of the group with
+   */
+  number_layout layout(const double* x, size_t n) const {
+
+    bool any = false;
+    bool negative = false;
+    // Over the finite members: the widest sign and whole part, the most
+    // digits after the point and significant digits, and whether any
+    // exponent needs three digits
+    int whole_width = 0, decimals = 0, significant = 0;
+    bool long_exponent = false;
+
+    for(size_t i = 0; i < n; i++){
+      if(!R_FINITE(x[i])){
+        continue;
+      }
+      number_digits d = describe(x[i]);
+      any = true;
+      negative = negative || d.negative;
+      whole_width = std::max(whole_width, d.negative + std::max(d.whole, 1));
+      decimals = std::max(decimals, d.significant - d.whole);
+      significant = std::max(significant, d.significant);
+      long_exponent = long_exponent || d.whole > 100 || d.whole <= -99;
+    }
+
+    number_layout out = {0, 0, false};
+    if(!any){
+      return out;
+    }
+
+    // d.ddde+xx, with no point for a single digit
+    int scientific_width = negative + significant + (significant > 1) + (long_exponent ? 5 : 4);
+    int fixed_width = whole_width + decimals + (decimals > 0);
+
+    if(fixed_width > scientific_width + scipen){
+      out.width = scientific_width;
+      out.digits = significant - 1;
+      out.scientific = true;
+      return out;
+    }
+    if(nsmall > decimals){
+      decimals = nsmall;
+      fixed_width = whole_width + decimals + 1;
+    }
+    out.width = fixed_width;
+    out.digits = decimals;
+    return out;
+  }
+
+  /**
+   * A function for appending a formatted number to a string
+   *
+   * @param out the string to append to
+   *
+   * @param x the number
+   *
+   * @param layout the layout of x's group, from layout()
+   *
+   * @param pad whether to pad x to the group's width, as R does, or to trim it
+   */
+  inline void append(std::string& out, double x, const number_layout& layout, bool pad){
+    int width = pad ? layout.width : 0;
+    int size;
+    if(!R_FINITE(x)){
+      size = snprintf(buffer, sizeof(buffer), "%*s", width, ISNAN(x) ? "NaN" : (x > 0 ? "Inf" : "-Inf"));
+    } else if(!layout.scientific){
+      size = snprintf(buffer, sizeof(buffer), "%*.*f", width, layout.digits, x);
+    } else if(layout.digits){
+      size = snprintf(buffer, sizeof(buffer), "%#*.*e", width, layout.digits, x);
+    } else {
+      size = snprintf(buffer, sizeof(buffer), "%*.*e", width, layout.digits, x);
+    }
+    out.append(buffer, size);
+  }
+
+private:
+
+  // What one number needs: its sign, the number of significant digits
+  // (at most `digits`), and the number of digits before the point in fixed
+  // notation (0 or less for numbers below 0.1, one less per leading zero)
+  struct number_digits {
+    bool negative;
+    int significant;
+    int whole;
+  };
+
+  int digits;
+  int scipen;
+  int nsmall;
+  // Room for "%.*f" of DBL_MAX at 20 decimal places, as allowed for nsmall
+  char buffer[400];
+
+  number_digits describe(double x) const {
+    number_digits d = {x < 0, 1, 1};
+    if(x == 0){
+      d.negative = false;
+      return d;
+    }
+    double r = std::fabs(x);
+
+    // Rounded to `digits` significant digits, as "d.ddddde+xx"
+    char text[64];
+    snprintf(text, sizeof(text), "%.*e", digits - 1, r);
+    const char* e = std::strchr(text, 'e');
+    int exponent = std::atoi(e + 1);
+    d.significant = digits;
+    for(const char* p = e - 1; d.significant > 1 && *p == '0'; p--){
+      d.significant--;
+    }
+    d.whole = exponent + 1;
+
+    // Rounding a large number to `digits` significant digits can carry into
+    // a new leading digit that rounding to a whole number doesn't, as with
+    // 99999999.3 at 7 digits; format() counts the whole digits fixed
+    // notation would really show (for numbers below 1e28, at up to 15 digits)
+    if(exponent >= digits && exponent <= 27 && digits <= DBL_DIG){
+      char whole[32];
+      int size = snprintf(whole, sizeof(whole), "%.0f", r);
+      if(size == exponent){
+        d.whole = exponent;
+      }
+    }
+    return d;
+  }
+};
+
+/**
+ * A json_handler that writes WKT as GeoJSON is read. Geometries, Features
+ * and FeatureCollections are all understood, giving one WKT object per
+ * geometry or Feature; everything else (properties, bbox, foreign members)
+ * is skipped without being stored.
+ *
+ * Members of an object can come in any order, so the coordinates of each
+ * geometry are held until the object closes and its type is certain - but
+ * only one geometry's worth at a time, and each Feature is written out as
+ * soon as it has been read, however large the collection holding it.
+ */
+struct wkt_writer : json_handler {
+
+  // What the next value is, going by where it sits in the document
+  enum slots {
+    slot_root,
+    slot_ignore,
+    slot_type,
+    slot_coordinates,
+    slot_geometries,
+    slot_member,
+    slot_geometry,
+    slot_features,
+    slot_feature
+  };
+
+  // Markers for where arrays open and close among the captured coordinates
+  enum markers {
+    open = -1,
+    close = -2
+  };
+
+  struct object_frame {
+    slots slot;
+    std::string type;
+    bool has_type;
+    supported_types alias;
+    // The coordinates, as open/close markers and indices into numbers
+    std::vector < int > tokens;
+    std::vector < double > numbers;
+    bool has_coordinates;
+    std::string members;
+    unsigned int member_count;
+    bool has_geometries;
+    std::string geometry;
+    bool has_geometry;
+  };
+
+  struct container {
+    bool object;
+    slots elements;
+  };
+
+  r_formatter formatter;
+  std::string third;
+
+  // Every WKT object written, back to back, with where each one ends
+  std::string text;
+  std::vector < size_t > ends;
+  std::vector < bool > missing;
+
+  std::vector < object_frame > frames;
+  unsigned int depth;
+  std::vector < container > containers;
+  slots pending;
+  unsigned int skip_depth;
+  unsigned int capture_depth;
+  std::vector < double > group;
+
+  wkt_writer(const r_formatter& formatter, const std::string& third)
+    : formatter(formatter), third(third) {}
+
+  /**
+   * A function for reading one JSON document, appending whatever WKT it holds
+   *
+   * @param x a pointer to the document
+   *
+   * @param size the number of bytes in x
+   */
+  void read(const char* x, size_t size){
+    depth = 0;
+    containers.clear();
+    skip_depth = 0;
+    capture_depth = 0;
+    read_json(x, size, *this);
+  }
+
+  inline void add_missing(){
+    ends.push_back(text.size());
+    missing.push_back(true);
+  }
+
+  inline void begin_object(){
+    if(skip_depth){
+      skip_depth++;
+      return;
+    }
+    if(capture_depth){
+      bad_coordinates();
+    }
+    slots slot = value_slot();
+    switch(slot){
+    case slot_root:
+    case slot_member:
+    case slot_geometry:
+    case slot_feature: {
+      if(depth == frames.size()){
+        frames.push_back(object_frame());
+      }
+      object_frame& f = frames[depth++];
+      f.slot = slot;
+      f.has_type = false;
+      f.alias = unsupported_type;
+      f.has_coordinates = false;
+      f.members.clear();
+      f.member_count = 0;
+      f.has_geometries = false;
+      f.has_geometry = false;
+      container c = {true, slot_ignore};
+      containers.push_back(c);
+      break;
+    }
+    case slot_ignore:
+      skip_depth = 1;
+      break;
+    default:
+      bad_value(slot);
+    }
+  }
+
+  inline void key(const std::string& x){
+    if(skip_depth){
+      return;
+    }
+    object_frame& f = frames[depth - 1];
+    supported_types alias;
+    if(same(x, "type")){
+      pending = slot_type;
+    } else if(same(x, "coordinates")){
+      pending = slot_coordinates;
+    } else if(same(x, "geometries")){
+      pending = slot_geometries;
+    } else if(same(x, "geometry")){
+      pending = slot_geometry;
+    } else if(same(x, "features")){
+      pending = slot_features;
+    } else if((alias = geometry_type(x)) != unsupported_type){
+      // The shorthand list(Point = c(1, 2)) form geojson2wkt also takes
+      f.alias = alias;
+      pending = (alias == geometry_collection) ? slot_geometries : slot_coordinates;
+    } else {
+      pending = slot_ignore;
+    }
+  }
+
+  inline void end_object(){
+    if(skip_depth){
+      skip_depth--;
+      return;
+    }
+    containers.pop_back();
+    depth--;
+    finish(frames[depth]);
+  }
+
+  inline void begin_array(){
+    if(skip_depth){
+      skip_depth++;
+      return;
+    }
+    if(capture_depth){
+      frames[depth - 1].tokens.push_back(open);
+      capture_depth++;
+      return;
+    }
+    slots slot = value_slot();
+    switch(slot){
+    case slot_coordinates: {
+      object_frame& f = frames[depth - 1];
+      f.tokens.clear();
+      f.numbers.clear();
+      f.tokens.push_back(open);
+      f.has_coordinates = true;
+      capture_depth = 1;
+      break;
+    }
+    case slot_geometries: {
+      frames[depth - 1].has_geometries = true;
+      container c = {false, slot_member};
+      containers.push_back(c);
+      break;
+    }
+    case slot_features: {
+      container c = {false, slot_feature};
+      containers.push_back(c);
+      break;
+    }
+    case slot_ignore:
+      skip_depth = 1;
+      break;
+    default:
+      bad_value(slot);
+    }
+  }
+
+  inline void end_array(){
+    if(skip_depth){
+      skip_depth--;
+    } else if(capture_depth){
+      frames[depth - 1].tokens.push_back(close);
+      capture_depth--;
+    } else {
+      containers.pop_back();
+    }
+  }
+
+  inline void number(double x){
+    if(skip_depth){
+      return;
+    }
+    if(capture_depth){
+      object_frame& f = frames[depth - 1];
+      f.tokens.push_back(f.numbers.size());
+      f.numbers.push_back(x);
+      return;
+    }
+    scalar();
+  }
+
+  inline void string(const std::string& x){
+    if(skip_depth){
+      return;
+    }
+    if(!capture_depth && value_slot() == slot_type){
+      object_frame& f = frames[depth - 1];
+      f.type = x;
+      f.has_type = true;
+      return;
+    }
+    scalar();
+  }
+
+  inline void boolean(bool){
+    if(!skip_depth){
+      scalar();
+    }
+  }
+
+  inline void null(){
+    // A Feature with a null geometry is allowed, and gives NA
+    if(!skip_depth && (capture_depth || value_slot() != slot_geometry)){
+      scalar();
+    }
+  }
+
+  inline void scalar(){
+    if(capture_depth){
+      bad_coordinates();
+    }
+    slots slot = value_slot();
+    if(slot != slot_ignore){
+      bad_value(slot);
+    }
+  }
+
+  inline slots value_slot() const {
+    if(containers.empty()){
+      return slot_root;
+    }
+    return containers.back().object ? pending : containers.back().elements;
+  }
+
+  // Writes out a closed object, or hands it to the object holding it
+  void finish(object_frame& f){
+
+    supported_types type = f.alias;
+    if(f.has_type){
+      if(same(f.type, "featurecollection")){
+        if(f.slot != slot_root){
+          throw json_exception("a FeatureCollection can only appear at the top level");
+        }
+        return;
+      }
+      if(same(f.type, "feature")){
+        if(f.slot != slot_root && f.slot != slot_feature){
+          throw json_exception("expecting a geometry, got a Feature");
+        }
+        if(f.has_geometry){
+          text += f.geometry;
+          ends.push_back(text.size());
+          missing.push_back(false);
+        } else {
+          add_missing();
+        }
+        return;
+      }
+      type = geometry_type(f.type);
+      if(type == unsupported_type){
+        throw json_exception("type " + f.type + " not supported");
+      }
+    } else if(type == unsupported_type){
+      throw json_exception("expecting a 'type' for every GeoJSON object");
+    }
+
+    switch(f.slot){
+    case slot_geometry: {
+      object_frame& parent = frames[depth - 1];
+      parent.geometry.clear();
+      write_geometry(f, type, parent.geometry);
+      parent.has_geometry = true;
+      break;
+    }
+    case slot_member: {
+      object_frame& parent = frames[depth - 1];
+      if(parent.member_count++){
+        parent.members += ", ";
+      }
+      write_geometry(f, type, parent.members);
+      break;
+    }
+    default:
+      write_geometry(f, type, text);
+      ends.push_back(text.size());
+      missing.push_back(false);
+    }
+  }
+
+  void write_geometry(object_frame& f, supported_types type, std::string& out){
+
+    static const char* names[] = {
+      "", "POINT", "MULTIPOINT", "LINESTRING", "MULTILINESTRING", "POLYGON",
+      "GEOMETRYCOLLECTION", "MULTIPOLYGON"
+    };
+    out += names[type];
+
+    if(type == geometry_collection){
+      if(!f.has_geometries){
+        throw json_exception("expecting an array of geometries in 'geometries'");
+      }
+      if(f.member_count){
+        out += " (";
+        out += f.members;
+        out += ')';
+      } else {
+        out += " EMPTY";
+      }
+      return;
+    }
+    if(!f.has_coordinates){
+      throw json_exception("expecting an array in 'coordinates'");
+    }
+
+    unsigned int dims = check_coordinates(f, type);
+    if(dims == 0){
+      out += " EMPTY";
+      return;
+    }
+    if(dims == 3){
+      out += ' ';
+      out += third;
+      out += '(';
+    } else if(dims == 4){
+      out += " ZM(";
+    } else {
+      out += " (";
+    }
+
+    // The grouping follows the R dumpers, which format() a point as a whole,
+    // each row of a (multi)point, linestring or polygon matrix on its own,
+    // and each multilinestring or multipolygon matrix as a whole
+    switch(type){
+    case point: {
+      double position[4];
+      read_position(f, 0, dims, position);
+      number_layout layout = formatter.layout(position, dims);
+      for(unsigned int i = 0; i < dims; i++){
+        if(i){
+          out += ' ';
+        }
+        formatter.append(out, position[i], layout, true);
+      }
+      break;
+    }
+    case multi_point:
+      write_positions(f, 0, dims, false, true, out);
+      break;
+    case line_string:
+      write_positions(f, 0, dims, false, false, out);
+      break;
+    case multi_line_string:
+      write_nested(f, 0, 1, dims, true, out);
+      break;
+    case polygon:
+      write_nested(f, 0, 1, dims, false, out);
+      break;
+    default:
+      write_nested(f, 0, 2, dims, true, out);
+    }
+    out += ')';
+  }
+
+  // Checks the coordinates are nested as deep as the type needs, with 2 to 4
+  // values per position; returns the most values any position has, or 0 if
+  // there are no positions at all
+  unsigned int check_coordinates(const object_frame& f, supported_types type){
+
+    unsigned int levels;
+    const char* message;
+    switch(type){
+    case point:
+      levels = 1;
+      message = "expecting a vector in 'coordinates'";
+      break;
+    case multi_point:
+    case line_string:
+      levels = 2;
+      message = "expecting a matrix in 'coordinates'";
+      break;
+    case multi_line_string:
+    case polygon:
+      levels = 3;
+      message = "expecting matrices for all 'coordinates' elements";
+      break;
+    default:
+      levels = 4;
+      message = "one or more of your rings is not a matrix";
+    }
+
+    unsigned int children[5];
+    unsigned int level = 0;
+    unsigned int dims = 0;
+    for(size_t i = 0; i < f.tokens.size(); i++){
+      int token = f.tokens[i];
+      if(token == open){
+        if(level){
+          children[level]++;
+        }
+        if(++level > levels){
+          throw json_exception(message);
+        }
+        children[level] = 0;
+      } else if(token == close){
+        if(level == 1 && children[level] == 0){
+          return 0;
+        }
+        if(level == levels){
+          if(children[level] < 2 || children[level] > 4){
+            throw json_exception("only 2D, 3D, and 4D supported");
+          }
+          if(children[level] > dims){
+            dims = children[level];
+          }
+        } else if(children[level] == 0){
+          throw json_exception(message);
+        }
+        level--;
+      } else {
+        if(level != levels){
+          throw json_exception(message);
+        }
+        children[level]++;
+      }
+    }
+    return dims;
+  }
+
+  // Reads the position opening at token t, padding missing values with 0;
+  // returns the token after it
+  inline size_t read_position(const object_frame& f, size_t t, unsigned int dims, double* position){
+    unsigned int n = 0;
+    for(t++; f.tokens[t] != close; t++){
+      position[n++] = f.numbers[f.tokens[t]];
+    }
+    for(; n < dims; n++){
+      position[n] = 0;
+    }
+    return t + 1;
+  }
+
+  // Writes the array of positions opening at token t; returns the token after it
+  size_t write_positions(const object_frame& f, size_t t, unsigned int dims, bool grouped,
+                         bool wrap, std::string& out){
+    double position[4];
+    number_layout layout;
+
+    if(grouped){
+      group.clear();
+      for(size_t i = t + 1; f.tokens[i] != close; ){
+        i = read_position(f, i, dims, position);
+        group.insert(group.end(), position, position + dims);
+      }
+      layout = formatter.layout(group.data(), group.size());
+    }
+
+    bool first = true;
+    for(t++; f.tokens[t] != close; first = false){
+      t = read_position(f, t, dims, position);
+      if(!grouped){
+        layout = formatter.layout(position, dims);
+      }
+      if(!first){
+        out += ", ";
+      }
+      if(wrap){
+        out += '(';
+      }
+      for(unsigned int i = 0; i < dims; i++){
+        if(i){
+          out += ' ';
+        }
+        formatter.append(out, position[i], layout, false);
+      }
+      if(wrap){
+        out += ')';
+      }
+    }
+    return t + 1;
+  }
+
+  // Writes the array opening at token t, which holds `levels` more levels of
+  // arrays above its arrays of positions; returns the token after it
+  size_t write_nested(const object_frame& f, size_t t, unsigned int levels, unsigned int dims,
+                      bool grouped, std::string& out){
+    if(levels == 0){
+      return write_positions(f, t, dims, grouped, false, out);
+    }
+    bool first = true;
+    for(t++; f.tokens[t] != close; first = false){
+      if(!first){
+        out += ", ";
+      }
+      out += '(';
+      t = write_nested(f, t, levels - 1, dims, grouped, out);
+      out += ')';
+    }
+    return t + 1;
+  }
+
+  void bad_coordinates() const {
+    throw json_exception("expecting only arrays and numbers in 'coordinates'");
+  }
+
+  void bad_value(slots slot) const {
+    switch(slot){
+    case slot_type:
+      throw json_exception("expecting a string in 'type'");
+    case slot_coordinates:
+      throw json_exception("expecting an array in 'coordinates'");
+    case slot_geometries:
+      throw json_exception("expecting an array of geometries in 'geometries'");
+    case slot_features:
+      throw json_exception("expecting an array of Features in 'features'");
+    default:
+      throw json_exception("expecting a GeoJSON object");
+    }
+  }
+
+  // Case-insensitive comparison against a lower-case name
+  static inline bool same(const std::string& x, const char* lower){
+    size_t i = 0;
+    for(; i < x.size() && lower[i]; i++){
+      char c = x[i];
+      if(c >= 'A' && c <= 'Z'){
+        c += 'a' - 'A';
+      }
+      if(c != lower[i]){
+        return false;
+      }
+    }
+    return i == x.size() && !lower[i];
+  }
+
+  static inline supported_types geometry_type(const std::string& x){
+    if(same(x, "point")) return point;
+    if(same(x, "multipoint")) return multi_point;
+    if(same(x, "linestring")) return line_string;
+    if(same(x, "multilinestring")) return multi_line_string;
+    if(same(x, "polygon")) return polygon;
+    if(same(x, "multipolygon")) return multi_polygon;
+    if(same(x, "geometrycollection")) return geometry_collection;
+    return unsupported_type;
+  }
+};
+
+// [[Rcpp::export]]
+CharacterVector geojson2wkt_(CharacterVector json, int fmt, std::string third, int digits, int scipen){
+
+  if(fmt < 0 || fmt > 20){
+    Rcpp::stop("'fmt' must be between 0 and 20");
+  }
+
+  unsigned int input_size = json.size();
+  wkt_writer writer(r_formatter(digits, scipen, fmt), third);
+
+  for(unsigned int i = 0; i < input_size; i++){
+    if((i % 10000) == 0){
+      Rcpp::checkUserInterrupt();
+    }
+    SEXP holding = json[i];
+    if(holding == NA_STRING){
+      writer.add_missing();
+      continue;
+    }
+    try {
+      writer.read(CHAR(holding), LENGTH(holding));
+    } catch (json_exception &e){
+      Rcpp::stop(e.what());
+    }
+  }
+
+  unsigned int output_size = writer.ends.size();
+  CharacterVector output(output_size);
+  size_t start = 0;
+  for(unsigned int i = 0; i < output_size; i++){
+    if(writer.missing[i]){
+      output[i] = NA_STRING;
+    } else {
+      output[i] = Rf_mkCharLen(writer.text.data() + start, writer.ends[i] - start);
+    }
+    start = writer.ends[i];
+  }
+  return output;
+}
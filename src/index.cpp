@@ -0,0 +1,209 @@
+#include <Rcpp.h>
+#include <algorithm>
+using namespace Rcpp;
+#include "utils.h"
+#include "parallel.h"
+#include "streaming.h"
+#include "index.h"
+using namespace wkt_utils;
+
+namespace bgi = boost::geometry::index;
+
+struct index_worker {
+
+  const wkt_input& wkt;
+  std::vector < bounds >& boxes;
+
+  index_worker(const wkt_input& wkt, std::vector < bounds >& boxes) : wkt(wkt), boxes(boxes) {}
+
+  void operator()(unsigned int i){
+    if(wkt.is_na(i)){
+      return;
+    }
+    envelope_handler envelope;
+    try {
+      wkt.read(i, envelope);
+    } catch (boost::geometry::read_wkt_exception &e){
+      return;
+    }
+    boxes[i] = envelope.box;
+  }
+};
+
+static void finalize_index(SEXP x){
+  spatial_index* index = static_cast<spatial_index*>(R_ExternalPtrAddr(x));
+  if(index != NULL){
+    delete index;
+    R_ClearExternalPtr(x);
+  }
+}
+
+static const spatial_index* get_index(SEXP x){
+  if(TYPEOF(x) != EXTPTRSXP || !Rf_inherits(x, "wkt_index")){
+    Rcpp::stop("Expecting a wkt_index object, as returned by wkt_index()");
+  }
+  spatial_index* out = static_cast<spatial_index*>(R_ExternalPtrAddr(x));
+  if(out == NULL){
+    Rcpp::stop("This wkt_index object is no longer valid (indices can't be saved and reloaded); call wkt_index() again");
+  }
+  return out;
+}
+
+/**
+ * Per-query results from worker threads: the matching rows for each query,
+ * 1-based, turned into a list of integer vectors on the main thread
+ */
+struct query_results {
+
+  std::vector < std::vector < int > > rows;
+
+  query_results(unsigned int size) : rows(size) {}
+
+  List to_r(){
+    unsigned int input_size = rows.size();
+    List out(input_size);
+    for(unsigned int i = 0; i < input_size; i++){
+      IntegerVector holding(rows[i].size());
+      std::copy(rows[i].begin(), rows[i].end(), holding.begin());
+      out[i] = holding;
+    }
+    return out;
+  }
+};
+
+struct intersects_worker {
+
+  const index_tree& tree;
+  const double* min_x;
+  const double* min_y;
+  const double* max_x;
+  const double* max_y;
+  query_results& output;
+  std::vector < index_value > hits;
+
+  intersects_worker(const index_tree& tree, const double* min_x, const double* min_y,
+                    const double* max_x, const double* max_y, query_results& output)
+    : tree(tree), min_x(min_x), min_y(min_y), max_x(max_x), max_y(max_y), output(output) {}
+
+  void operator()(unsigned int i){
+    if(ISNAN(min_x[i]) || ISNAN(min_y[i]) || ISNAN(max_x[i]) || ISNAN(max_y[i])){
+      return;
+    }
+    hits.clear();
+    box_type query(point_type(min_x[i], min_y[i]), point_type(max_x[i], max_y[i]));
+    tree.query(bgi::intersects(query), std::back_inserter(hits));
+
+    std::vector < int >& rows = output.rows[i];
+    rows.resize(hits.size());
+    for(unsigned int j = 0; j < hits.size(); j++){
+      rows[j] = hits[j].second + 1;
+    }
+    std::sort(rows.begin(), rows.end());
+  }
+};
+
+struct nearest_worker {
+
+  const index_tree& tree;
+  const double* x;
+  const double* y;
+  unsigned int k;
+  query_results& output;
+
+  nearest_worker(const index_tree& tree, const double* x, const double* y, unsigned int k,
+                 query_results& output)
+    : tree(tree), x(x), y(y), k(k), output(output) {}
+
+  void operator()(unsigned int i){
+    if(ISNAN(x[i]) || ISNAN(y[i])){
+      return;
+    }
+    std::vector < int >& rows = output.rows[i];
+    // The query iterator hands back the nearest boxes first
+    for(index_tree::const_query_iterator it = tree.qbegin(bgi::nearest(point_type(x[i], y[i]), k));
+        it != tree.qend(); ++it){
+      rows.push_back(it->second + 1);
+    }
+  }
+};
+
+//' @title Build a Spatial Index over WKT Objects
+//' @description `wkt_index` builds an R-tree over the bounding boxes of a
+//' vector of WKT objects (the boxes [wkt_bounding()] gives), which can then
+//' be queried for the objects whose boxes intersect a box
+//' ([wkt_index_box()]) or a point ([wkt_index_point()]), or for the objects
+//' whose boxes are nearest a point ([wkt_index_nearest()]). Queries are
+//' answered from the tree alone, without looking at the objects again.
+//' @export
+//' @param wkt a character vector of WKT objects, or a list of raw vectors
+//' of WKB objects (or a single raw vector), or a `wkt_parsed` object from
+//' [wkt_parse()].
+//' @template nthreads
+//' @return an object of class `wkt_index`. The tree is bulk-loaded from all
+//' of the boxes at once. Objects without a bounding box (`NA`s, empty
+//' objects, and objects that can't be read) are left out of it.
+//' @details Like [wkt_parse()] objects, indices live outside R's memory, and
+//' can't be saved and reloaded.
+//' @seealso [wkt_index_box()] to query an index
+//' @examples
+//' wkt <- c("POLYGON ((0 0, 0 10, 10 10, 10 0, 0 0))",
+//'          "POINT (20 20)",
+//'          "LINESTRING (5 5, 30 30)",
+//'          NA)
+//' index <- wkt_index(wkt)
+//' index
+//' wkt_index_box(index, c(0, 0, 1, 1))
+// [[Rcpp::export]]
+SEXP wkt_index(SEXP wkt, SEXP nthreads = R_NilValue){
+
+  wkt_input input(wkt);
+  unsigned int input_size = input.length();
+  std::vector < bounds > boxes(input_size);
+  parallel_for(input_size, resolve_threads(nthreads), index_worker(input, boxes));
+
+  std::vector < index_value > values;
+  values.reserve(input_size);
+  for(unsigned int i = 0; i < input_size; i++){
+    if(!boxes[i].is_empty()){
+      values.push_back(index_value(box_type(point_type(boxes[i].min_x, boxes[i].min_y),
+                                            point_type(boxes[i].max_x, boxes[i].max_y)), i));
+    }
+  }
+  std::vector < bounds >().swap(boxes);
+
+  SEXP out = PROTECT(R_MakeExternalPtr(new spatial_index(values, input_size), R_NilValue, R_NilValue));
+  R_RegisterCFinalizerEx(out, finalize_index, TRUE);
+  Rf_setAttrib(out, R_ClassSymbol, Rf_mkString("wkt_index"));
+  UNPROTECT(1);
+  return out;
+}
+
+// [[Rcpp::export]]
+List wkt_index_box_(SEXP index, NumericVector min_x, NumericVector min_y, NumericVector max_x,
+                    NumericVector max_y, SEXP nthreads = R_NilValue){
+
+  const spatial_index* tree = get_index(index);
+  unsigned int input_size = min_x.size();
+  query_results output(input_size);
+  parallel_for(input_size, resolve_threads(nthreads),
+               intersects_worker(tree->tree, REAL(min_x), REAL(min_y), REAL(max_x), REAL(max_y), output));
+  return output.to_r();
+}
+
+// [[Rcpp::export]]
+List wkt_index_nearest_(SEXP index, NumericVector x, NumericVector y, int k, SEXP nthreads = R_NilValue){
+
+  const spatial_index* tree = get_index(index);
+  unsigned int input_size = x.size();
+  query_results output(input_size);
+  parallel_for(input_size, resolve_threads(nthreads),
+               nearest_worker(tree->tree, REAL(x), REAL(y), k, output));
+  return output.to_r();
+}
+
+// [[Rcpp::export]]
+NumericVector wkt_index_info_(SEXP index){
+  const spatial_index* tree = get_index(index);
+  return NumericVector::create(_["objects"] = tree->size,
+                               _["indexed"] = tree->tree.size());
+}
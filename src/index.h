@@ -0,0 +1,39 @@
+#include <utility>
+#include <vector>
+#include <boost/geometry/index/rtree.hpp>
+#include "def.h"
+
+#ifndef __WKT_INDEX__
+#define __WKT_INDEX__
+namespace wkt_utils {
+
+  /**
+   * An entry in a spatial index: an object's bounding box and its (0-based)
+   * position in the vector the index was built from
+   */
+  typedef std::pair < box_type, unsigned int > index_value;
+
+  typedef boost::geometry::index::rtree < index_value, boost::geometry::index::quadratic < 16 > > index_tree;
+
+  /**
+   * An R-tree over the bounding boxes of a vector of objects, as built by
+   * wkt_index(). The tree is bulk-loaded (packed) from every box at once, which
+   * gives a better tree than inserting them one by one and takes a fraction
+   * of the time. Objects without a box - NA, empty or unreadable - are left
+   * out, but still count towards size.
+   */
+  struct spatial_index {
+
+    index_tree tree;
+    unsigned int size;
+
+    /**
+     * @param values the boxes to index, with their positions
+     *
+     * @param size the length of the vector the boxes came from
+     */
+    spatial_index(const std::vector < index_value >& values, unsigned int size)
+      : tree(values.begin(), values.end()), size(size) {}
+  };
+}
+#endif
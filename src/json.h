@@ -0,0 +1,308 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <boost/cstdint.hpp>
+#include "reader.h"
+
+#ifndef __WKT_JSON__
+#define __WKT_JSON__
+namespace wkt_utils {
+
+  /**
+   * The exception thrown when a JSON document can't be read
+   */
+  class json_exception : public std::runtime_error {
+  public:
+    json_exception(const std::string& message) : std::runtime_error(message) {}
+  };
+
+  /**
+   * The base class for anything that wants to be told about the contents of
+   * a JSON document as it is read. Events arrive in document order; object
+   * keys arrive through key() immediately before their values. Handlers
+   * hide whichever of these they care about.
+   */
+  struct json_handler {
+    inline void begin_object(){}
+    inline void end_object(){}
+    inline void key(const std::string&){}
+    inline void begin_array(){}
+    inline void end_array(){}
+    inline void number(double){}
+    inline void string(const std::string&){}
+    inline void boolean(bool){}
+    inline void null(){}
+  };
+
+  /**
+   * A single-pass scanner over a JSON document. Works directly on the
+   * character buffer; the only thing it copies is the string currently being
+   * read, into a buffer that is reused from one string to the next.
+   */
+  class json_scanner {
+
+  public:
+
+    json_scanner(const char* x, size_t size) : begin(x), cursor(x), end(x + size) {}
+
+    inline void skip_whitespace(){
+      while(cursor < end && (*cursor == ' ' || *cursor == '\n' || *cursor == '\r' || *cursor == '\t')){
+        cursor++;
+      }
+    }
+
+    inline bool at_end(){
+      skip_whitespace();
+      return cursor == end;
+    }
+
+    inline char peek(){
+      skip_whitespace();
+      if(cursor == end){
+        fail("unexpected end of input");
+      }
+      return *cursor;
+    }
+
+    inline bool accept(char c){
+      if(peek() == c){
+        cursor++;
+        return true;
+      }
+      return false;
+    }
+
+    inline void expect(char c){
+      if(!accept(c)){
+        std::string message = "expected '";
+        message += c;
+        fail(message + "'");
+      }
+    }
+
+    inline void expect_word(const char* word){
+      const char* p = cursor;
+      for(; *word; word++, p++){
+        if(p == end || *p != *word){
+          fail("unexpected character");
+        }
+      }
+      cursor = p;
+    }
+
+    inline double read_number(){
+      double out;
+      if(!(*cursor == '-' || (*cursor >= '0' && *cursor <= '9')) || !parse_double(cursor, end, out)){
+        fail("bad number");
+      }
+      return out;
+    }
+
+    /**
+     * A function for reading a string, unescaping it as it goes
+     *
+     * @param out a reference to a string to read into; cleared first
+     */
+    void read_string(std::string& out){
+      out.clear();
+      expect('"');
+      while(true){
+        const char* start = cursor;
+        while(cursor < end && *cursor != '"' && *cursor != '\\' && (unsigned char) *cursor >= 0x20){
+          cursor++;
+        }
+        out.append(start, cursor);
+        if(cursor == end){
+          fail("unterminated string");
+        }
+        if(*cursor == '"'){
+          cursor++;
+          return;
+        }
+        if(*cursor != '\\'){
+          fail("control character in string");
+        }
+        cursor++;
+        if(cursor == end){
+          fail("unterminated string");
+        }
+        switch(*cursor++){
+        case '"': out += '"'; break;
+        case '\\': out += '\\'; break;
+        case '/': out += '/'; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+          boost::uint32_t code = read_hex();
+          if(code >= 0xD800 && code < 0xDC00 && (end - cursor) >= 6 && cursor[0] == '\\' && cursor[1] == 'u'){
+            cursor += 2;
+            boost::uint32_t low = read_hex();
+            if(low < 0xDC00 || low > 0xDFFF){
+              fail("bad surrogate pair");
+            }
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+          }
+          append_utf8(out, code);
+          break;
+        }
+        default:
+          fail("bad escape");
+        }
+      }
+    }
+
+    /**
+     * A function for throwing a json_exception that says where reading stopped
+     *
+     * @param message what went wrong
+     */
+    void fail(const std::string& message) const {
+      char position[32];
+      snprintf(position, sizeof(position), "%lu", (unsigned long) (cursor - begin) + 1);
+      throw json_exception("Invalid JSON: " + message + " at character " + position);
+    }
+
+  private:
+
+    const char* begin;
+    const char* cursor;
+    const char* end;
+
+    inline boost::uint32_t read_hex(){
+      if((end - cursor) < 4){
+        fail("bad escape");
+      }
+      boost::uint32_t out = 0;
+      for(int i = 0; i < 4; i++, cursor++){
+        char c = *cursor;
+        out <<= 4;
+        if(c >= '0' && c <= '9'){
+          out += c - '0';
+        } else if(c >= 'a' && c <= 'f'){
+          out += c - 'a' + 10;
+        } else if(c >= 'A' && c <= 'F'){
+          out += c - 'A' + 10;
+        } else {
+          fail("bad escape");
+        }
+      }
+      return out;
+    }
+
+    static inline void append_utf8(std::string& out, boost::uint32_t code){
+      if(code < 0x80){
+        out += (char) code;
+      } else if(code < 0x800){
+        out += (char) (0xC0 | (code >> 6));
+        out += (char) (0x80 | (code & 0x3F));
+      } else if(code < 0x10000){
+        out += (char) (0xE0 | (code >> 12));
+        out += (char) (0x80 | ((code >> 6) & 0x3F));
+        out += (char) (0x80 | (code & 0x3F));
+      } else {
+        out += (char) (0xF0 | (code >> 18));
+        out += (char) (0x80 | ((code >> 12) & 0x3F));
+        out += (char) (0x80 | ((code >> 6) & 0x3F));
+        out += (char) (0x80 | (code & 0x3F));
+      }
+    }
+  };
+
+  /**
+   * A function for reading a JSON document, passing its contents to a handler
+   * as it goes rather than building it up in memory. Nesting is tracked with
+   * an explicit stack, so deeply nested documents can't exhaust the C stack.
+   *
+   * @param x a pointer to the document
+   *
+   * @param size the number of bytes in x
+   *
+   * @param handler the json_handler to send events to
+   */
+  template <typename Handler>
+  void read_json(const char* x, size_t size, Handler& handler){
+
+    json_scanner scanner(x, size);
+    std::vector < char > containers;
+    std::string buffer;
+    bool have_value = false;
+
+    while(true){
+
+      if(!have_value){
+        char c = scanner.peek();
+        if(c == '{'){
+          scanner.accept('{');
+          handler.begin_object();
+          if(scanner.accept('}')){
+            handler.end_object();
+            have_value = true;
+          } else {
+            containers.push_back('{');
+            scanner.read_string(buffer);
+            scanner.expect(':');
+            handler.key(buffer);
+          }
+          continue;
+        }
+        if(c == '['){
+          scanner.accept('[');
+          handler.begin_array();
+          if(scanner.accept(']')){
+            handler.end_array();
+            have_value = true;
+          } else {
+            containers.push_back('[');
+          }
+          continue;
+        }
+        if(c == '"'){
+          scanner.read_string(buffer);
+          handler.string(buffer);
+        } else if(c == 't'){
+          scanner.expect_word("true");
+          handler.boolean(true);
+        } else if(c == 'f'){
+          scanner.expect_word("false");
+          handler.boolean(false);
+        } else if(c == 'n'){
+          scanner.expect_word("null");
+          handler.null();
+        } else {
+          handler.number(scanner.read_number());
+        }
+        have_value = true;
+        continue;
+      }
+
+      if(containers.empty()){
+        if(!scanner.at_end()){
+          scanner.fail("unexpected content after the end of the document");
+        }
+        return;
+      }
+
+      if(scanner.accept(',')){
+        if(containers.back() == '{'){
+          scanner.read_string(buffer);
+          scanner.expect(':');
+          handler.key(buffer);
+        }
+        have_value = false;
+      } else if(containers.back() == '{'){
+        scanner.expect('}');
+        containers.pop_back();
+        handler.end_object();
+      } else {
+        scanner.expect(']');
+        containers.pop_back();
+        handler.end_array();
+      }
+    }
+  }
+}
+#endif
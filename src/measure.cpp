@@ -0,0 +1,239 @@
+#include <Rcpp.h>
+using namespace Rcpp;
+#include "def.h"
+#include "utils.h"
+#include "parallel.h"
+#include "stats.h"
+#include "geodesic.h"
+using namespace wkt_utils;
+
+// The mean radius of the earth, in metres, as used for spherical measures
+static const double earth_radius = 6371008.8;
+
+/**
+ * The point type and boost::geometry strategies for each way of measuring:
+ * on the plane, in the units of the coordinates; on a sphere the size of
+ * the earth; and on the WGS84 ellipsoid. The last two take longitudes and
+ * latitudes in degrees, and give metres and square metres.
+ */
+struct planar_measure {
+  typedef point_type point;
+  typedef boost::geometry::strategy::area::cartesian<> area_strategy;
+  typedef boost::geometry::strategy::distance::pythagoras<> length_strategy;
+  static area_strategy area(){
+    return area_strategy();
+  }
+  static length_strategy length(){
+    return length_strategy();
+  }
+};
+
+struct spherical_measure {
+  typedef s_point_type point;
+  typedef boost::geometry::strategy::area::spherical<> area_strategy;
+  typedef boost::geometry::strategy::distance::haversine<double> length_strategy;
+  static area_strategy area(){
+    return area_strategy(earth_radius);
+  }
+  static length_strategy length(){
+    return length_strategy(earth_radius);
+  }
+};
+
+struct ellipsoidal_measure {
+  typedef g_point_type point;
+  typedef boost::geometry::strategy::area::geographic<boost::geometry::strategy::vincenty> area_strategy;
+  typedef boost::geometry::strategy::distance::geographic<boost::geometry::strategy::vincenty> length_strategy;
+  static area_strategy area(){
+    return area_strategy();
+  }
+  static length_strategy length(){
+    return length_strategy();
+  }
+};
+
+geodesic_mode wkt_utils::get_geodesic_mode(std::string geodesic){
+  if(geodesic == "none"){
+    return planar_mode;
+  }
+  if(geodesic == "spherical"){
+    return spherical_mode;
+  }
+  if(geodesic != "ellipsoidal"){
+    Rcpp::stop("geodesic must be one of 'none', 'spherical' or 'ellipsoidal'");
+  }
+  return ellipsoidal_mode;
+}
+
+/**
+ * A handler that measures the area of the polygons in an object and the
+ * length of its linestrings, as it's read. Each ring or linestring is
+ * gathered into a reused buffer, then measured by boost::geometry. A
+ * polygon's area is that of its exterior ring less those of its holes,
+ * whichever way they wind, and points, and a polygon's boundary, have no
+ * length, as in boost::geometry and PostGIS. A GeometryCollection's
+ * measures are the sums of its members'.
+ */
+template <typename Measure>
+struct measure_handler : wkt_handler {
+
+  static const bool collections = true;
+
+  typedef typename Measure::point point_t;
+  typedef boost::geometry::model::ring<point_t> ring_t;
+  typedef boost::geometry::model::linestring<point_t> line_t;
+
+  typename Measure::area_strategy area_strategy;
+  typename Measure::length_strategy length_strategy;
+  double area;
+  double length;
+  supported_types type;
+  unsigned int ring;
+  ring_t ring_points;
+  line_t line_points;
+
+  measure_handler()
+    : area_strategy(Measure::area()), length_strategy(Measure::length()), area(0), length(0) {}
+
+  // Called before each object, as one that failed to parse part way
+  // through leaves its partial measures behind
+  inline void reset(){
+    area = 0;
+    length = 0;
+  }
+
+  inline void begin_geometry(const wkt_header& header){
+    type = header.type;
+  }
+
+  inline void begin_ring(unsigned int i){
+    ring = i;
+    ring_points.clear();
+    line_points.clear();
+  }
+
+  inline void end_ring(){
+    if(type == line_string || type == multi_line_string){
+      length += static_cast<double>(boost::geometry::length(line_points, length_strategy));
+      return;
+    }
+    if(ring_points.size() < 3){
+      return;
+    }
+    if(!boost::geometry::equals(ring_points.front(), ring_points.back())){
+      ring_points.push_back(ring_points.front());
+    }
+    double ring_area = std::fabs(static_cast<double>(boost::geometry::area(ring_points, area_strategy)));
+    area += ring == 0 ? ring_area : -ring_area;
+  }
+
+  inline void coord(const coordinate& c){
+    if(type == line_string || type == multi_line_string){
+      line_points.push_back(point_t(c.x, c.y));
+    } else if(type == polygon || type == multi_polygon){
+      ring_points.push_back(point_t(c.x, c.y));
+    }
+  }
+};
+
+/**
+ * Fills in one row of wkt_area() or wkt_length() output. Each thread keeps
+ * its own handler, and so its buffers, from row to row.
+ */
+template <typename Measure>
+struct measure_worker {
+
+  const wkt_input& wkt;
+  double* output;
+  bool areas;
+  call_stats& stats;
+  measure_handler<Measure> handler;
+
+  measure_worker(const wkt_input& wkt, double* output, bool areas, call_stats& stats)
+    : wkt(wkt), output(output), areas(areas), stats(stats) {}
+
+  void operator()(unsigned int i){
+    row_stats row(stats.local());
+    if(wkt.is_na(i)){
+      row.row(-1);
+      output[i] = NA_REAL;
+      return;
+    }
+    row.row(wkt.size(i));
+    handler.reset();
+    try {
+      wkt.read(i, handler);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output[i] = NA_REAL;
+      row.lap(parse_phase);
+      row.failed(wkt, i);
+      return;
+    }
+    output[i] = areas ? handler.area : handler.length;
+    row.lap(parse_phase);
+  }
+};
+
+NumericVector measure(SEXP wkt, std::string geodesic, SEXP nthreads, bool areas){
+
+  geodesic_mode mode = get_geodesic_mode(geodesic);
+  int threads = resolve_threads(nthreads);
+  call_stats stats(areas ? "wkt_area" : "wkt_length", threads);
+  wkt_input input(wkt);
+  unsigned int input_size = input.length();
+  NumericVector output(input_size);
+
+  switch(mode){
+  case planar_mode:
+    parallel_for(input_size, threads, measure_worker<planar_measure>(input, REAL(output), areas, stats));
+    break;
+  case spherical_mode:
+    parallel_for(input_size, threads, measure_worker<spherical_measure>(input, REAL(output), areas, stats));
+    break;
+  default:
+    parallel_for(input_size, threads, measure_worker<ellipsoidal_measure>(input, REAL(output), areas, stats));
+  }
+  stats.finish();
+  return output;
+}
+
+//' @title Measure WKT Objects
+//' @description `wkt_area` gives the area of each WKT object, and
+//' `wkt_length` the length, either on the plane or, for longitudes and
+//' latitudes in degrees, on the earth.
+//' @export
+//' @rdname wkt_measure
+//' @param wkt a character vector of WKT objects, or a list of raw vectors
+//' of WKB objects (or a single raw vector), or a `wkt_parsed` object from
+//' [wkt_parse()].
+//' @param geodesic how to measure: `"none"` (the default), on the plane,
+//' in the units of the coordinates; `"spherical"`, along great circles on
+//' a sphere of the earth's mean radius (6,371,008.8 metres); or
+//' `"ellipsoidal"`, along geodesics on the WGS84 ellipsoid, which is
+//' slower but accurate to within millimetres. The last two take
+//' coordinates to be longitudes and latitudes, in degrees, and give
+//' (square) metres.
+//' @template nthreads
+//' @return a numeric vector, with `NA` for objects that are `NA` or can't
+//' be parsed. The area of a polygon is that of its exterior ring less
+//' those of its interior rings, whichever way they are oriented (so it is
+//' never negative for a valid polygon); points and linestrings have none.
+//' Only linestrings have a length: points and polygons, whose boundaries
+//' are not counted, have a length of 0, as in PostGIS. Multi- objects and
+//' GeometryCollections sum their parts.
+//' @seealso [wkt_centroid()], which can also work on the sphere
+//' @examples
+//' wkt_area("POLYGON ((0 0, 0 1, 1 1, 1 0, 0 0))")
+//' wkt_area("POLYGON ((0 0, 0 1, 1 1, 1 0, 0 0))", geodesic = "ellipsoidal")
+//' wkt_length("LINESTRING (-0.1276 51.5072, 2.3522 48.8566)", geodesic = "spherical")
+// [[Rcpp::export]]
+NumericVector wkt_area(SEXP wkt, std::string geodesic = "none", SEXP nthreads = R_NilValue){
+  return measure(wkt, geodesic, nthreads, true);
+}
+
+//' @export
+//' @rdname wkt_measure
+// [[Rcpp::export]]
+NumericVector wkt_length(SEXP wkt, std::string geodesic = "none", SEXP nthreads = R_NilValue){
+  return measure(wkt, geodesic, nthreads, false);
+}
@@ -0,0 +1,120 @@
+#include "memo.h"
+using namespace wkt_utils;
+
+void wkt_utils::result_cache::resize(size_t size){
+  if(size == capacity){
+    return;
+  }
+  order.clear();
+  entries.clear();
+  std::vector < double >().swap(values);
+  if(keep != R_NilValue){
+    R_ReleaseObject(keep);
+    keep = R_NilValue;
+  }
+  capacity = size;
+  if(capacity){
+    keep = Rf_allocVector(VECSXP, capacity);
+    R_PreserveObject(keep);
+    values.resize(capacity * width);
+  }
+}
+
+const double* wkt_utils::result_cache::find(SEXP key){
+  std::unordered_map < SEXP, entry >::iterator found = entries.find(key);
+  if(found == entries.end()){
+    return NULL;
+  }
+  order.splice(order.begin(), order, found->second.position);
+  return &values[found->second.slot * width];
+}
+
+void wkt_utils::result_cache::insert(SEXP key, double* const* cols, unsigned int row){
+  if(!capacity || entries.count(key)){
+    return;
+  }
+  size_t slot = entries.size();
+  if(slot == capacity){
+    SEXP oldest = order.back();
+    slot = entries[oldest].slot;
+    entries.erase(oldest);
+    order.pop_back();
+  }
+  order.push_front(key);
+  entry e = {slot, order.begin()};
+  entries[key] = e;
+  SET_VECTOR_ELT(keep, slot, key);
+  for(unsigned int j = 0; j < width; j++){
+    values[slot * width + j] = cols[j][row];
+  }
+}
+
+size_t wkt_utils::cache_size(){
+  SEXP option = Rf_GetOption1(Rf_install("wellknown.cache"));
+  if(Rf_isNull(option)){
+    return 0;
+  }
+  double size = Rf_asReal(option);
+  if(ISNAN(size) || size < 0){
+    Rcpp::stop("The wellknown.cache option must be a non-negative number");
+  }
+  return static_cast<size_t>(size);
+}
+
+wkt_utils::row_memo::row_memo(const wkt_input& input, double* const* cols, unsigned int width,
+                              result_cache& cache)
+  : input(input), cols(cols), width(width), cache(cache), keyed(false) {
+
+  SEXP strings = input.source();
+  unsigned int input_size = input.length();
+  if(!input.is_text() || TYPEOF(strings) != STRSXP || Rf_xlength(strings) != static_cast<R_xlen_t>(input_size)){
+    return;
+  }
+  keyed = true;
+  cache.resize(cache_size());
+
+  std::unordered_map < SEXP, unsigned int > first;
+  compute.reserve(input_size);
+  for(unsigned int i = 0; i < input_size; i++){
+    if(input.is_na(i) || input.size(i) < memo_min_size){
+      compute.push_back(i);
+      continue;
+    }
+    SEXP key = STRING_ELT(strings, i);
+    std::pair < std::unordered_map < SEXP, unsigned int >::iterator, bool > seen =
+      first.insert(std::make_pair(key, i));
+    if(!seen.second){
+      copies.push_back(std::make_pair(i, seen.first->second));
+      continue;
+    }
+    const double* cached = cache.enabled() ? cache.find(key) : NULL;
+    if(cached == NULL){
+      compute.push_back(i);
+      continue;
+    }
+    for(unsigned int j = 0; j < width; j++){
+      cols[j][i] = cached[j];
+    }
+  }
+}
+
+void wkt_utils::row_memo::finish(){
+  if(!keyed){
+    return;
+  }
+  for(size_t k = 0; k < copies.size(); k++){
+    for(unsigned int j = 0; j < width; j++){
+      cols[j][copies[k].first] = cols[j][copies[k].second];
+    }
+  }
+  if(!cache.enabled()){
+    return;
+  }
+  SEXP strings = input.source();
+  for(size_t k = 0; k < compute.size(); k++){
+    unsigned int i = compute[k];
+    if(!input.is_na(i) && input.size(i) >= memo_min_size){
+      cache.insert(STRING_ELT(strings, i), cols, i);
+    }
+  }
+}
@@ -0,0 +1,156 @@
+#include <Rcpp.h>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "utils.h"
+#include "parallel.h"
+
+#ifndef __WKT_MEMO__
+#define __WKT_MEMO__
+namespace wkt_utils {
+
+  /**
+   * Results that outlast a call: the last so many objects a kernel computed,
+   * keyed by their CHARSXPs. R keeps one CHARSXP per distinct string, so an
+   * object seen again - in this call or a later one - has the same key. The
+   * keys are held in a list R can see, so that none of them is collected
+   * (and its address reused for some other string) while it's still cached.
+   * Only ever touched from the main thread.
+   */
+  class result_cache {
+
+  public:
+
+    /**
+     * @param width the number of doubles in each result
+     */
+    result_cache(unsigned int width) : width(width), capacity(0), keep(R_NilValue) {}
+
+    /**
+     * A function for setting how many results are kept. Changing it empties
+     * the cache; setting it to 0 frees it.
+     *
+     * @param size the number of results
+     */
+    void resize(size_t size);
+
+    inline bool enabled() const {
+      return capacity > 0;
+    }
+
+    /**
+     * A function for looking up a result, marking it as the most recently used
+     *
+     * @param key a CHARSXP
+     *
+     * @return a pointer to the result's values, or NULL if it isn't cached
+     */
+    const double* find(SEXP key);
+
+    /**
+     * A function for caching a result, in place of the least recently used
+     * if the cache is full
+     *
+     * @param key a CHARSXP
+     *
+     * @param values a pointer to the result's values, one per column
+     *
+     * @param row the row of each column to take them from
+     */
+    void insert(SEXP key, double* const* values, unsigned int row);
+
+  private:
+
+    struct entry {
+      size_t slot;
+      std::list < SEXP >::iterator position;
+    };
+
+    unsigned int width;
+    size_t capacity;
+    // Most recently used first
+    std::list < SEXP > order;
+    std::unordered_map < SEXP, entry > entries;
+    std::vector < double > values;
+    SEXP keep;
+  };
+
+  /**
+   * A function for getting the size of the persistent caches
+   *
+   * @return the wellknown.cache option, or 0 if it is unset
+   */
+  size_t cache_size();
+
+  // Objects shorter than this are quicker to compute than to look up
+  static const R_xlen_t memo_min_size = 64;
+
+  /**
+   * Works out, for one call, which rows of a character vector need computing:
+   * only the first of each set of identical objects, and then only if it
+   * isn't in the cache. The rest are copied, once the kernel has run, from
+   * the row (or cache entry) that has their result. Inputs that aren't
+   * character vectors - WKB, wkt_parse() stores and file chunks - are
+   * computed in full.
+   */
+  class row_memo {
+
+  public:
+
+    /**
+     * @param input the input
+     *
+     * @param cols the output columns, already allocated
+     *
+     * @param width the number of columns
+     *
+     * @param cache the kernel's persistent cache
+     */
+    row_memo(const wkt_input& input, double* const* cols, unsigned int width, result_cache& cache);
+
+    /**
+     * A function for running a worker over the rows that need computing;
+     * see parallel_for
+     */
+    template <typename Worker>
+    void run(int nthreads, const Worker& worker){
+      if(!keyed){
+        parallel_for(input.length(), nthreads, worker);
+      } else {
+        parallel_for(compute.size(), nthreads, subset_worker<Worker>(worker, compute));
+      }
+    }
+
+    /**
+     * A function for filling in the rows that weren't computed, and caching
+     * those that were. Must be called on the main thread, after run().
+     */
+    void finish();
+
+  private:
+
+    template <typename Worker>
+    struct subset_worker {
+
+      Worker worker;
+      const std::vector < unsigned int >& rows;
+
+      subset_worker(const Worker& worker, const std::vector < unsigned int >& rows)
+        : worker(worker), rows(rows) {}
+
+      inline void operator()(unsigned int i){
+        worker(rows[i]);
+      }
+    };
+
+    const wkt_input& input;
+    double* const* cols;
+    unsigned int width;
+    result_cache& cache;
+    bool keyed;
+    std::vector < unsigned int > compute;
+    // Rows to copy, and the rows to copy them from
+    std::vector < std::pair < unsigned int, unsigned int > > copies;
+  };
+}
+#endif
@@ -0,0 +1,20 @@
+#include "parallel.h"
+
+int wkt_utils::resolve_threads(SEXP nthreads){
+
+  if(Rf_isNull(nthreads)){
+    nthreads = Rf_GetOption1(Rf_install("wellknown.nthreads"));
+    if(Rf_isNull(nthreads)){
+      return 1;
+    }
+  }
+  int out = Rf_asInteger(nthreads);
+  if(out == NA_INTEGER || out < 1){
+    Rcpp::stop("nthreads must be a positive integer");
+  }
+#ifdef _OPENMP
+  return out;
+#else
+  return 1;
+#endif
+}
@@ -0,0 +1,104 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifndef __WKT_PARALLEL__
+#define __WKT_PARALLEL__
+namespace wkt_utils {
+
+  /**
+   * A function for working out how many threads a kernel should use
+   *
+   * @param nthreads the user-supplied nthreads argument. If NULL, the
+   * wellknown.nthreads option is used instead, and if that is unset, 1.
+   *
+   * @return a positive number of threads (always 1 when built without OpenMP)
+   */
+  int resolve_threads(SEXP nthreads);
+
+  /**
+   * A function for keeping the exception being handled, if it's the first
+   * one thrown in a parallel_for(). Must be called from a catch block.
+   */
+  inline void keep_first(std::exception_ptr& failure, std::atomic < bool >& failed){
+#ifdef _OPENMP
+#pragma omp critical(wkt_parallel_failure)
+#endif
+    {
+      if(!failed){
+        failure = std::current_exception();
+        failed = true;
+      }
+    }
+  }
+
+  /**
+   * A function for running a worker over every row of an input, split across
+   * threads. Rows are handed out in blocks; between blocks, on the main thread,
+   * the user is given the chance to interrupt. Each thread gets its own copy of
+   * the worker, so workers can keep holding objects around - but they must not
+   * call into R.
+   *
+   * Workers catch the exceptions they expect (read_wkt_exception, mostly);
+   * anything else thrown on a worker thread - std::bad_alloc, say - must not
+   * escape the parallel region, where it would terminate R. The first is
+   * kept, the rows not yet started are skipped, and it is rethrown on the
+   * main thread once the threads have joined, for Rcpp to turn into an R
+   * error.
+   *
+   * @param input_size the number of rows
+   *
+   * @param nthreads the number of threads, as returned by resolve_threads
+   *
+   * @param worker a worker whose operator()(unsigned int) processes one row
+   *
+   * @return nothing
+   */
+  template <typename Worker>
+  void parallel_for(unsigned int input_size, int nthreads, const Worker& worker){
+
+    const unsigned int step = 10000 * nthreads;
+    std::exception_ptr failure;
+    std::atomic < bool > failed(false);
+    for(unsigned int start = 0; start < input_size; start += step){
+      Rcpp::checkUserInterrupt();
+      int stop = std::min(input_size, start + step);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nthreads)
+#endif
+      {
+        // Every thread must reach the loop, even if its copy of the worker
+        // couldn't be made, or the others wait for it forever
+        std::unique_ptr < Worker > local;
+        try {
+          local.reset(new Worker(worker));
+        } catch (...){
+          keep_first(failure, failed);
+        }
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+        for(int i = start; i < stop; i++){
+          if(failed.load(std::memory_order_relaxed)){
+            continue;
+          }
+          try {
+            (*local)(i);
+          } catch (...){
+            keep_first(failure, failed);
+          }
+        }
+      }
+      if(failed){
+        std::rethrow_exception(failure);
+      }
+    }
+  }
+}
+#endif
@@ -0,0 +1,89 @@
+#include <Rcpp.h>
+using namespace Rcpp;
+#include "utils.h"
+using namespace wkt_utils;
+
+static void finalize_store(SEXP x){
+  wkt_store* store = static_cast<wkt_store*>(R_ExternalPtrAddr(x));
+  if(store != NULL){
+    delete store;
+    R_ClearExternalPtr(x);
+  }
+}
+
+//' @title Parse WKT Objects Once
+//' @description `wkt_parse` reads a vector of WKT (or WKB) objects into a
+//' compact store held in memory - a flat buffer of coordinates, with tables
+//' recording where each ring, part and object starts - which [validate_wkt()],
+//' [wkt_correct()], [wkt_reverse()], [wkt_bounding()], [wkt_centroid()],
+//' [wkt_coords()], [wkt2geojson()] and [wkt_wkb()] all accept in place of the
+//' original vector. Objects are then parsed once, rather than once per call.
+//' @export
+//' @param x a character vector of WKT objects, or a list of raw vectors of
+//' WKB objects (or a single raw vector).
+//' @return an object of class `wkt_parsed`. Objects that couldn't be parsed
+//' are kept as such, and give the same results (`NA`, or the parse error from
+//' [validate_wkt()]) as the unparsed object would.
+//' @details The store lives outside R's memory, so it can't be saved and
+//' reloaded with [saveRDS()] or [save()]; parse the original vector again
+//' instead. Functions that return WKT pass objects they leave unchanged
+//' through from the original vector, which the store keeps a reference to.
+//' @examples
+//' wkt <- c("POLYGON ((30 10, 40 40, 20 40, 10 20, 30 10))",
+//'          "POLYGON ((30 20, 10 40, 45 40, 30 20))",
+//'          NA)
+//' parsed <- wkt_parse(wkt)
+//' parsed
+//' validate_wkt(parsed)
+//' wkt_correct(parsed)
+//' wkt_bounding(parsed)
+//' wkt_centroid(parsed)
+// [[Rcpp::export]]
+SEXP wkt_parse(SEXP x){
+
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  wkt_store* store = new wkt_store();
+  wkt_store::builder builder(*store);
+
+  // Owned by the external pointer from here on, so that an interrupt
+  // doesn't leak it
+  SEXP out = PROTECT(R_MakeExternalPtr(store, R_NilValue, input.source()));
+  R_RegisterCFinalizerEx(out, finalize_store, TRUE);
+
+  for(unsigned int i = 0; i < input_size; i++){
+    if((i % 10000) == 0){
+      Rcpp::checkUserInterrupt();
+    }
+    if(input.is_na(i)){
+      store->missing_row();
+      continue;
+    }
+    try {
+      input.read(i, builder);
+      store->end_row();
+    } catch (boost::geometry::read_wkt_exception &e){
+      builder.open.clear();
+      store->fail_row(e.what());
+    }
+  }
+
+  Rf_setAttrib(out, R_ClassSymbol, Rf_mkString("wkt_parsed"));
+  UNPROTECT(1);
+  return out;
+}
+
+// [[Rcpp::export]]
+NumericVector wkt_parsed_info_(SEXP x){
+  const wkt_store* store = get_store(x);
+  unsigned int input_size = store->length();
+  double na = 0, failed = 0;
+  for(unsigned int i = 0; i < input_size; i++){
+    na += store->is_na(i);
+    failed += store->is_failed(i);
+  }
+  return NumericVector::create(_["objects"] = input_size,
+                               _["missing"] = na,
+                               _["failed"] = failed,
+                               _["bytes"] = store->memory_size());
+}
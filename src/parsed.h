@@ -0,0 +1,334 @@
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include "reader.h"
+
+#ifndef __WKT_PARSED__
+#define __WKT_PARSED__
+namespace wkt_utils {
+
+  /**
+   * The exception thrown when a stored object is read back but couldn't be
+   * parsed in the first place. Carries the message from the original parse.
+   */
+  class stored_exception : public boost::geometry::read_wkt_exception {
+  public:
+    stored_exception(const std::string& message)
+      : boost::geometry::read_wkt_exception(message, ""), message(message) {}
+    virtual ~stored_exception() throw() {}
+    virtual const char* what() const throw() {
+      return message.c_str();
+    }
+  private:
+    std::string message;
+  };
+
+  /**
+   * Parsed objects, held column-wise so that they can be read again without
+   * going back to the text. Every coordinate lives in one flat buffer; the
+   * structure above it is a set of offset tables:
+   *
+   * - rows index into the geometry table (one geometry per row, plus the
+   *   members of any GeometryCollection, in the order they were read);
+   * - geometries hold their header and index into the part table;
+   * - parts index into the ring table;
+   * - rings index into the coordinate buffer.
+   *
+   * Points and multipoint members are stored as single-coordinate rings, and
+   * the single types as a single part, so that everything has the same shape.
+   * Coordinates take two, three or four slots depending on their geometry's
+   * dimensions. Objects are read back with replay(), which sends a handler
+   * exactly the events the WKT reader would have.
+   */
+  class wkt_store {
+
+  public:
+
+    wkt_store() : row_geometry(1, 0) {}
+
+    /**
+     * The handler a row is read into. Adds to the store as it goes; a row
+     * that fails partway through is rolled back by fail_row.
+     */
+    struct builder : wkt_handler {
+
+      static const bool collections = true;
+
+      wkt_store& store;
+      std::vector < boost::uint32_t > open;
+
+      builder(wkt_store& store) : store(store) {}
+
+      inline void begin_geometry(const wkt_header& header){
+        if(!open.empty() && store.headers[open.back()].type == geometry_collection){
+          store.members[open.back()]++;
+        }
+        open.push_back(store.headers.size());
+        store.headers.push_back(header);
+        store.geometry_part.push_back(store.part_ring.size());
+        store.members.push_back(0);
+
+        switch(header.type){
+        case point:
+          store.part_ring.push_back(store.ring_coord.size());
+          store.ring_coord.push_back(store.coords.size());
+          break;
+        case line_string:
+        case polygon:
+          store.part_ring.push_back(store.ring_coord.size());
+          break;
+        default:
+          break;
+        }
+      }
+
+      inline void end_geometry(){
+        open.pop_back();
+      }
+
+      inline void begin_part(unsigned int){
+        supported_types type = store.headers[open.back()].type;
+        if(type == geometry_collection){
+          return;
+        }
+        store.part_ring.push_back(store.ring_coord.size());
+        if(type == multi_point){
+          store.ring_coord.push_back(store.coords.size());
+        }
+      }
+
+      inline void begin_ring(unsigned int){
+        store.ring_coord.push_back(store.coords.size());
+      }
+
+      inline void coord(const coordinate& c){
+        const wkt_header& header = store.headers[open.back()];
+        store.coords.push_back(c.x);
+        store.coords.push_back(c.y);
+        if(header.has_z){
+          store.coords.push_back(c.z);
+        }
+        if(header.has_m){
+          store.coords.push_back(c.m);
+        }
+      }
+    };
+
+    /**
+     * A function for finishing a row that was read into a builder
+     */
+    inline void end_row(){
+      row_geometry.push_back(headers.size());
+      state.push_back(parsed);
+    }
+
+    /**
+     * A function for adding an NA row
+     */
+    inline void missing_row(){
+      row_geometry.push_back(headers.size());
+      state.push_back(missing);
+    }
+
+    /**
+     * A function for abandoning a row that failed partway through being read
+     * into a builder, keeping what went wrong for when it is read back
+     *
+     * @param message the reason the row couldn't be read
+     */
+    void fail_row(const std::string& message){
+      boost::uint32_t first = row_geometry.back();
+      failure f = {first < headers.size() ? headers[first].type : unsupported_type, message};
+      failures[state.size()] = f;
+
+      if(first < headers.size()){
+        size_t first_part = geometry_part[first];
+        size_t first_ring = first_part < part_ring.size() ? part_ring[first_part] : ring_coord.size();
+        size_t first_coord = first_ring < ring_coord.size() ? ring_coord[first_ring] : coords.size();
+        headers.resize(first);
+        geometry_part.resize(first);
+        members.resize(first);
+        part_ring.resize(first_part);
+        ring_coord.resize(first_ring);
+        coords.resize(first_coord);
+      }
+      row_geometry.push_back(headers.size());
+      state.push_back(failed);
+    }
+
+    inline unsigned int length() const {
+      return state.size();
+    }
+
+    inline bool is_na(unsigned int i) const {
+      return state[i] == missing;
+    }
+
+    inline bool is_failed(unsigned int i) const {
+      return state[i] == failed;
+    }
+
+    /**
+     * A function for working out roughly how much memory the store takes up
+     *
+     * @return a number of bytes, not counting failure messages
+     */
+    inline size_t memory_size() const {
+      return sizeof(boost::uint32_t) * (row_geometry.size() + geometry_part.size() +
+                                        members.size() + part_ring.size()) +
+        state.size() + (sizeof(wkt_header) * headers.size()) +
+        (sizeof(size_t) * ring_coord.size()) + (sizeof(double) * coords.size());
+    }
+
+    /**
+     * A function for identifying the type of a stored object
+     *
+     * @param i the row
+     *
+     * @return a value from the supported_types enum. Rows that failed to
+     * parse report the type their header gave, as id_type would.
+     */
+    inline supported_types type(unsigned int i) const {
+      if(state[i] == failed){
+        return failures.find(i)->second.type;
+      }
+      if(state[i] == missing){
+        return unsupported_type;
+      }
+      return headers[row_geometry[i]].type;
+    }
+
+    /**
+     * A function for reading a stored object back into a handler. Rows that
+     * failed to parse throw the exception they originally threw.
+     *
+     * @param i the row
+     *
+     * @param handler a reference to a handler to report to
+     */
+    template <typename Handler>
+    inline void replay(unsigned int i, Handler& handler) const {
+      if(state[i] == failed){
+        throw stored_exception(failures.find(i)->second.message);
+      }
+      replay_geometry(row_geometry[i], handler);
+    }
+
+    /**
+     * A function for reading a stored object into a boost::geometry object;
+     * the stored counterpart to read_wkt
+     *
+     * @param i the row
+     *
+     * @param geom a reference to the boost::geometry object to fill in
+     */
+    template <typename Geometry>
+    void replay_into(unsigned int i, Geometry& geom) const {
+      typedef geometry_builder<Geometry> builder_type;
+      builder_type builder(geom);
+      if(state[i] != failed && type(i) != builder_type::type){
+        boost::geometry::clear(geom);
+        throw stored_exception("Object does not match the expected WKT type");
+      }
+      replay(i, builder);
+    }
+
+  private:
+
+    enum row_state { parsed, missing, failed };
+
+    struct failure {
+      supported_types type;
+      std::string message;
+    };
+
+    // Per row
+    std::vector < boost::uint32_t > row_geometry;
+    std::vector < char > state;
+    std::map < unsigned int, failure > failures;
+
+    // Per geometry
+    std::vector < wkt_header > headers;
+    std::vector < boost::uint32_t > geometry_part;
+    std::vector < boost::uint32_t > members;
+
+    // Per part, then per ring
+    std::vector < boost::uint32_t > part_ring;
+    std::vector < size_t > ring_coord;
+
+    std::vector < double > coords;
+
+    template <typename Handler>
+    boost::uint32_t replay_geometry(boost::uint32_t g, Handler& handler) const {
+
+      const wkt_header& header = headers[g];
+      handler.begin_geometry(header);
+      if(header.is_empty){
+        handler.end_geometry();
+        return g + 1;
+      }
+
+      boost::uint32_t next = g + 1;
+      if(header.type == geometry_collection){
+        if(!Handler::collections){
+          throw stored_exception("Object could not be recognised as a supported WKT type");
+        }
+        for(boost::uint32_t k = 0; k < members[g]; k++){
+          handler.begin_part(k);
+          next = replay_geometry(next, handler);
+          handler.end_part();
+        }
+        handler.end_geometry();
+        return next;
+      }
+
+      bool multi = header.type == multi_point || header.type == multi_line_string ||
+        header.type == multi_polygon;
+      bool bare = header.type == point || header.type == multi_point;
+      unsigned int stride = 2 + header.has_z + header.has_m;
+      coordinate c;
+      c.z = c.m = std::numeric_limits<double>::quiet_NaN();
+
+      boost::uint32_t part_end = end_of(geometry_part, g, part_ring.size());
+      for(boost::uint32_t p = geometry_part[g]; p < part_end; p++){
+        if(multi){
+          handler.begin_part(p - geometry_part[g]);
+        }
+        size_t ring_end = end_of(part_ring, p, ring_coord.size());
+        for(size_t r = part_ring[p]; r < ring_end; r++){
+          if(!bare){
+            handler.begin_ring(r - part_ring[p]);
+          }
+          size_t coord_end = end_of(ring_coord, r, coords.size());
+          for(size_t j = ring_coord[r]; j < coord_end; j += stride){
+            const double* values = &coords[j];
+            c.x = values[0];
+            c.y = values[1];
+            if(header.has_z){
+              c.z = values[2];
+            }
+            if(header.has_m){
+              c.m = values[2 + header.has_z];
+            }
+            handler.coord(c);
+          }
+          if(!bare){
+            handler.end_ring();
+          }
+        }
+        if(multi){
+          handler.end_part();
+        }
+      }
+      handler.end_geometry();
+      return next;
+    }
+
+    template <typename T>
+    static inline size_t end_of(const std::vector < T >& starts, size_t i, size_t total){
+      return i + 1 < starts.size() ? starts[i + 1] : total;
+    }
+  };
+}
+#endif
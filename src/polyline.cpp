@@ -0,0 +1,102 @@
+#include <Rcpp.h>
+using namespace Rcpp;
+#include "utils.h"
+#include "parallel.h"
+#include "writer.h"
+#include "polyline.h"
+using namespace wkt_utils;
+
+struct polyline_encode_worker {
+
+  const wkt_input& x;
+  translation& output;
+  int precision;
+
+  polyline_encode_worker(const wkt_input& x, translation& output, int precision)
+    : x(x), output(output), precision(precision) {}
+
+  void operator()(unsigned int i){
+    if(x.is_na(i)){
+      return;
+    }
+    polyline_writer writer(output.values[i], precision);
+    try {
+      x.read(i, writer);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.errors[i] = e.what();
+    }
+  }
+};
+
+struct polyline_decode_worker {
+
+  const wkt_input& x;
+  translation& output;
+  int precision;
+
+  polyline_decode_worker(const wkt_input& x, translation& output, int precision)
+    : x(x), output(output), precision(precision) {}
+
+  void operator()(unsigned int i){
+    if(x.is_na(i)){
+      return;
+    }
+    wkt_text_writer writer(output.values[i], 0, true);
+    try {
+      read_polyline(x.get(i), x.size(i), precision, writer);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.errors[i] = e.what();
+    }
+  }
+};
+
+inline void check_polyline_precision(int precision){
+  if(precision == NA_INTEGER || precision < 0 || precision > 10){
+    Rcpp::stop("'precision' must be a whole number between 0 and 10");
+  }
+}
+
+// [[Rcpp::export]]
+CharacterVector wkt_polyline_(SEXP x, int precision, SEXP nthreads = R_NilValue){
+
+  check_polyline_precision(precision);
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  translation output(input_size);
+  parallel_for(input_size, resolve_threads(nthreads),
+               polyline_encode_worker(input, output, precision));
+  output.check();
+
+  CharacterVector out(input_size);
+  for(unsigned int i = 0; i < input_size; i++){
+    if(input.is_na(i)){
+      out[i] = NA_STRING;
+    } else {
+      out[i] = Rf_mkCharLenCE(output.values[i].data(), output.values[i].size(), CE_UTF8);
+    }
+  }
+  return out;
+}
+
+// [[Rcpp::export]]
+CharacterVector polyline_wkt_(CharacterVector x, int precision, SEXP nthreads = R_NilValue){
+
+  check_polyline_precision(precision);
+  // Polylines are text, so the input holds them as it would WKT
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  translation output(input_size);
+  parallel_for(input_size, resolve_threads(nthreads),
+               polyline_decode_worker(input, output, precision));
+  output.check();
+
+  CharacterVector out(input_size);
+  for(unsigned int i = 0; i < input_size; i++){
+    if(input.is_na(i)){
+      out[i] = NA_STRING;
+    } else {
+      out[i] = Rf_mkCharLenCE(output.values[i].data(), output.values[i].size(), CE_UTF8);
+    }
+  }
+  return out;
+}
@@ -0,0 +1,130 @@
+#include <string>
+#include <boost/cstdint.hpp>
+#include "twkb.h"
+
+#ifndef __WKT_POLYLINE__
+#define __WKT_POLYLINE__
+namespace wkt_utils {
+
+  /**
+   * A handler that writes an object as a Google encoded polyline as it is
+   * read: latitude then longitude (y then x) of each point, stored as
+   * integers at a number of decimal places (5 in Google's own, 6 in OSRM's
+   * and Valhalla's), each as the difference from the point before, in
+   * zigzag-encoded groups of five bits shifted into printable ASCII.
+   * Polylines have no types, rings or parts, so only points, multipoints
+   * and linestrings can be written; Z and M values are dropped.
+   */
+  struct polyline_writer : wkt_handler {
+
+    // So that collections reach begin_geometry, to be refused there
+    static const bool collections = true;
+
+    std::string& out;
+    double scale;
+    boost::int64_t last[2];
+
+    /**
+     * @param out a reference to the string to append the polyline to
+     *
+     * @param precision the number of decimal places to store coordinates to
+     */
+    polyline_writer(std::string& out, int precision)
+      : out(out), scale(std::pow(10.0, precision)) {
+      last[0] = last[1] = 0;
+    }
+
+    inline void begin_geometry(const wkt_header& header){
+      if(header.type != point && header.type != multi_point && header.type != line_string){
+        throw read_wkb_exception("Only POINT, MULTIPOINT and LINESTRING objects can be written as polylines");
+      }
+    }
+
+    inline void coord(const coordinate& c){
+      boost::int64_t lat = quantize(c.y, scale);
+      boost::int64_t lng = quantize(c.x, scale);
+      write(lat - last[0]);
+      write(lng - last[1]);
+      last[0] = lat;
+      last[1] = lng;
+    }
+
+    inline void write(boost::int64_t delta){
+      boost::uint64_t x = zigzag(delta);
+      while(x >= 0x20){
+        out += (char) (((x & 0x1F) | 0x20) + 63);
+        x >>= 5;
+      }
+      out += (char) (x + 63);
+    }
+  };
+
+  /**
+   * A function for reading a Google encoded polyline into a handler, as a
+   * LINESTRING - or a POINT, if it has only one point, and LINESTRING EMPTY
+   * if it has none
+   *
+   * @param x a pointer to the polyline
+   *
+   * @param size the number of characters in x
+   *
+   * @param precision the number of decimal places it was written to
+   *
+   * @param handler a reference to a handler to report to
+   */
+  template <typename Handler>
+  void read_polyline(const char* x, size_t size, int precision, Handler& handler){
+
+    const char* cursor = x;
+    const char* end = x + size;
+    boost::int64_t last[2] = {0, 0};
+    unsigned long points = 0;
+    coordinate c;
+    c.z = c.m = std::numeric_limits<double>::quiet_NaN();
+
+    // Counted first, for the header
+    for(const char* p = x; p != end; p++){
+      if(*p < 63 || *p > 126){
+        throw read_wkb_exception("Polylines may only contain the characters '?' to '~'");
+      }
+      points += *p < 95;
+    }
+    if(points % 2){
+      throw read_wkb_exception("Unexpected end of polyline");
+    }
+    points /= 2;
+
+    wkt_header header = {points == 1 ? point : line_string, false, false, points == 0};
+    handler.begin_geometry(header);
+    if(header.type == line_string && points){
+      handler.begin_ring(0);
+    }
+    while(cursor != end){
+      for(unsigned int k = 0; k < 2; k++){
+        boost::uint64_t value = 0;
+        unsigned int shift = 0;
+        unsigned char chunk;
+        do {
+          if(cursor == end){
+            throw read_wkb_exception("Unexpected end of polyline");
+          }
+          if(shift > 60){
+            throw read_wkb_exception("Malformed polyline");
+          }
+          chunk = *cursor++ - 63;
+          value |= (boost::uint64_t) (chunk & 0x1F) << shift;
+          shift += 5;
+        } while(chunk & 0x20);
+        last[k] += unzigzag(value);
+      }
+      c.y = unquantize(last[0], precision);
+      c.x = unquantize(last[1], precision);
+      handler.coord(c);
+    }
+    if(header.type == line_string && points){
+      handler.end_ring();
+    }
+    handler.end_geometry();
+  }
+}
+#endif
@@ -0,0 +1,305 @@
+#include <Rcpp.h>
+#include <algorithm>
+using namespace Rcpp;
+#include "utils.h"
+#include "parallel.h"
+#include "shape.h"
+#include "index.h"
+using namespace wkt_utils;
+
+namespace bgi = boost::geometry::index;
+
+enum predicate_type { intersects_predicate, within_predicate, contains_predicate };
+
+static predicate_type get_predicate(std::string name){
+  if(name == "intersects"){
+    return intersects_predicate;
+  }
+  if(name == "within"){
+    return within_predicate;
+  }
+  if(name == "contains"){
+    return contains_predicate;
+  }
+  Rcpp::stop("'predicate' must be one of \"intersects\", \"within\" or \"contains\"");
+}
+
+// boost::geometry has no within() for an object of a higher dimension than
+// the one it might be within - a polygon within a line, say - and the answer
+// is always false, so those pairs never reach it
+template <typename A, typename B,
+          bool possible = (boost::geometry::topological_dimension<A>::value <=
+                           boost::geometry::topological_dimension<B>::value)>
+struct within_impl {
+  static inline bool apply(const A& a, const B& b){
+    return boost::geometry::within(a, b);
+  }
+};
+
+template <typename A, typename B>
+struct within_impl<A, B, false> {
+  static inline bool apply(const A&, const B&){
+    return false;
+  }
+};
+
+struct intersects_op {
+  template <typename A, typename B>
+  inline bool operator()(const A& a, const B& b) const {
+    return boost::geometry::intersects(a, b);
+  }
+};
+
+struct within_op {
+  template <typename A, typename B>
+  inline bool operator()(const A& a, const B& b) const {
+    return within_impl<A, B>::apply(a, b);
+  }
+};
+
+/**
+ * A function for testing a predicate between two shapes, checking their
+ * bounding boxes first so that the exact test only runs on pairs that could
+ * pass it. Empty objects intersect, and are within, nothing.
+ *
+ * GeometryCollections are tested member by member: a collection intersects
+ * whatever any of its members intersects, is within whatever all of its
+ * non-empty members are within, and has within it whatever is within one of
+ * its members.
+ */
+static bool test_predicate(const shape& a, const shape& b, predicate_type predicate){
+  if(a.is_empty || b.is_empty){
+    return false;
+  }
+  switch(predicate){
+  case intersects_predicate:
+    if(!boost::geometry::intersects(a.envelope, b.envelope)){
+      return false;
+    }
+    if(a.type == geometry_collection){
+      for(unsigned int i = 0; i < a.members.size(); i++){
+        if(test_predicate(a.members[i], b, predicate)){
+          return true;
+        }
+      }
+      return false;
+    }
+    if(b.type == geometry_collection){
+      for(unsigned int i = 0; i < b.members.size(); i++){
+        if(test_predicate(a, b.members[i], predicate)){
+          return true;
+        }
+      }
+      return false;
+    }
+    return apply_shapes(a, b, intersects_op());
+  case within_predicate:
+    if(!boost::geometry::covered_by(a.envelope, b.envelope)){
+      return false;
+    }
+    if(a.type == geometry_collection){
+      for(unsigned int i = 0; i < a.members.size(); i++){
+        if(!a.members[i].is_empty && !test_predicate(a.members[i], b, predicate)){
+          return false;
+        }
+      }
+      return true;
+    }
+    if(b.type == geometry_collection){
+      for(unsigned int i = 0; i < b.members.size(); i++){
+        if(test_predicate(a, b.members[i], predicate)){
+          return true;
+        }
+      }
+      return false;
+    }
+    return apply_shapes(a, b, within_op());
+  default:
+    return test_predicate(b, a, within_predicate);
+  }
+}
+
+/**
+ * A function for reading an object into a shape, for the predicates
+ *
+ * @return whether the object could be read
+ */
+static inline bool read_shape(const wkt_input& x, unsigned int i, shape& out){
+  if(x.is_na(i)){
+    return false;
+  }
+  try {
+    return out.read(x, i);
+  } catch (boost::geometry::read_wkt_exception &e){
+    return false;
+  }
+}
+
+struct predicate_worker {
+
+  const wkt_input& x;
+  const wkt_input& y;
+  const shape* fixed_x;
+  const shape* fixed_y;
+  predicate_type predicate;
+  int* output;
+
+  predicate_worker(const wkt_input& x, const wkt_input& y, const shape* fixed_x,
+                   const shape* fixed_y, predicate_type predicate, int* output)
+    : x(x), y(y), fixed_x(fixed_x), fixed_y(fixed_y), predicate(predicate), output(output) {}
+
+  void operator()(unsigned int i){
+    arena_scope scope;
+    shape read_x, read_y;
+
+    // A length-one side was read once up front, rather than once per row
+    const shape* a = fixed_x;
+    if(a == NULL){
+      if(!read_shape(x, i, read_x)){
+        output[i] = NA_LOGICAL;
+        return;
+      }
+      a = &read_x;
+    }
+    const shape* b = fixed_y;
+    if(b == NULL){
+      if(!read_shape(y, i, read_y)){
+        output[i] = NA_LOGICAL;
+        return;
+      }
+      b = &read_y;
+    }
+    output[i] = test_predicate(*a, *b, predicate);
+  }
+};
+
+// [[Rcpp::export]]
+LogicalVector wkt_predicate_(SEXP x, SEXP y, std::string predicate, SEXP nthreads = R_NilValue){
+
+  predicate_type type = get_predicate(predicate);
+  wkt_input input_x(x);
+  wkt_input input_y(y);
+  unsigned int size_x = input_x.length();
+  unsigned int size_y = input_y.length();
+  if(size_x != size_y && size_x != 1 && size_y != 1){
+    Rcpp::stop("'x' and 'y' must be the same length, or one of them must be of length 1");
+  }
+  unsigned int input_size = (size_x == 0 || size_y == 0) ? 0 : std::max(size_x, size_y);
+  LogicalVector output(input_size);
+
+  shape fixed_x, fixed_y;
+  bool recycle_x = size_x == 1 && input_size > 1;
+  bool recycle_y = size_y == 1 && input_size > 1;
+  if((recycle_x && !read_shape(input_x, 0, fixed_x)) ||
+     (recycle_y && !read_shape(input_y, 0, fixed_y))){
+    std::fill(output.begin(), output.end(), NA_LOGICAL);
+    return output;
+  }
+
+  parallel_for(input_size, resolve_threads(nthreads),
+               predicate_worker(input_x, input_y, recycle_x ? &fixed_x : NULL,
+                                recycle_y ? &fixed_y : NULL, type, LOGICAL(output)));
+  return output;
+}
+
+struct shape_worker {
+
+  const wkt_input& x;
+  std::vector < shape >& shapes;
+  std::vector < char >& readable;
+
+  shape_worker(const wkt_input& x, std::vector < shape >& shapes, std::vector < char >& readable)
+    : x(x), shapes(shapes), readable(readable) {}
+
+  // No arena scope is opened: these shapes are kept for the whole join
+  void operator()(unsigned int i){
+    readable[i] = read_shape(x, i, shapes[i]);
+  }
+};
+
+struct join_worker {
+
+  const wkt_input& x;
+  const std::vector < shape >& y;
+  const index_tree& tree;
+  predicate_type predicate;
+  std::vector < std::vector < int > >& matches;
+  std::vector < index_value > candidates;
+
+  join_worker(const wkt_input& x, const std::vector < shape >& y, const index_tree& tree,
+              predicate_type predicate, std::vector < std::vector < int > >& matches)
+    : x(x), y(y), tree(tree), predicate(predicate), matches(matches) {}
+
+  void operator()(unsigned int i){
+    arena_scope scope;
+    shape a;
+    if(!read_shape(x, i, a) || a.is_empty){
+      return;
+    }
+
+    // Only objects whose boxes could satisfy the predicate come out of the
+    // tree; the exact test is run on those alone
+    candidates.clear();
+    switch(predicate){
+    case intersects_predicate:
+      tree.query(bgi::intersects(a.envelope), std::back_inserter(candidates));
+      break;
+    case within_predicate:
+      tree.query(bgi::covers(a.envelope), std::back_inserter(candidates));
+      break;
+    default:
+      tree.query(bgi::covered_by(a.envelope), std::back_inserter(candidates));
+    }
+
+    std::vector < int >& rows = matches[i];
+    for(unsigned int j = 0; j < candidates.size(); j++){
+      if(test_predicate(a, y[candidates[j].second], predicate)){
+        rows.push_back(candidates[j].second + 1);
+      }
+    }
+    std::sort(rows.begin(), rows.end());
+  }
+};
+
+// [[Rcpp::export]]
+DataFrame wkt_join_(SEXP x, SEXP y, std::string predicate, SEXP nthreads = R_NilValue){
+
+  predicate_type type = get_predicate(predicate);
+  int threads = resolve_threads(nthreads);
+  wkt_input input_x(x);
+  wkt_input input_y(y);
+  unsigned int size_x = input_x.length();
+  unsigned int size_y = input_y.length();
+
+  std::vector < shape > shapes(size_y);
+  std::vector < char > readable(size_y);
+  parallel_for(size_y, threads, shape_worker(input_y, shapes, readable));
+
+  std::vector < index_value > values;
+  values.reserve(size_y);
+  for(unsigned int i = 0; i < size_y; i++){
+    if(readable[i] && !shapes[i].is_empty){
+      values.push_back(index_value(shapes[i].envelope, i));
+    }
+  }
+  spatial_index index(values, size_y);
+
+  std::vector < std::vector < int > > matches(size_x);
+  parallel_for(size_x, threads, join_worker(input_x, shapes, index.tree, type, matches));
+
+  size_t total = 0;
+  for(unsigned int i = 0; i < size_x; i++){
+    total += matches[i].size();
+  }
+  IntegerVector out_x(total);
+  IntegerVector out_y(total);
+  size_t k = 0;
+  for(unsigned int i = 0; i < size_x; i++){
+    for(unsigned int j = 0; j < matches[i].size(); j++, k++){
+      out_x[k] = i + 1;
+      out_y[k] = matches[i][j];
+    }
+  }
+  return DataFrame::create(_["x"] = out_x,
+                           _["y"] = out_y);
+}
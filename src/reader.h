@@ -0,0 +1,807 @@
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <limits>
+#include <boost/cstdint.hpp>
+#include <boost/geometry.hpp>
+
+#ifndef __WKT_READER__
+#define __WKT_READER__
+namespace wkt_utils {
+
+  /**
+   * An enum of supported types: exists to make switch statements easier
+   */
+  enum supported_types {
+    point               = 1,
+    multi_point         = 2,
+    line_string         = 3,
+    multi_line_string   = 4,
+    polygon             = 5,
+    geometry_collection = 6,
+    multi_polygon       = 7,
+    unsupported_type    = 8
+  };
+
+  /**
+   * A single coordinate as it appears in a WKT object. z and m are NaN
+   * when the object does not carry them.
+   */
+  struct coordinate {
+    double x;
+    double y;
+    double z;
+    double m;
+  };
+
+  /**
+   * A function for checking whether two consecutive points of a linestring
+   * or ring are duplicates, as boost::geometry::is_valid has it: in the same
+   * place in x and y, whatever their Z or M values
+   */
+  inline bool duplicate_points(const coordinate& a, const coordinate& b){
+    return a.x == b.x && a.y == b.y;
+  }
+
+  /**
+   * The leading part of a WKT object: its type, whether it has Z and/or M
+   * values, and whether it is EMPTY.
+   */
+  struct wkt_header {
+    supported_types type;
+    bool has_z;
+    bool has_m;
+    bool is_empty;
+  };
+
+  /**
+   * A function for parsing a decimal number. Numbers that can be represented
+   * exactly (up to 19 significant digits with a power-of-ten exponent of at most 22,
+   * which covers practically all coordinates) are assembled directly;
+   * anything else falls back to strtod.
+   *
+   * @param cursor a reference to a pointer to the first character of the number;
+   * advanced past the number on success
+   *
+   * @param end a pointer to the end of the buffer
+   *
+   * @param out a reference to the double to write the result into
+   *
+   * @return whether a number could be read
+   */
+  inline bool parse_double(const char*& cursor, const char* end, double& out){
+
+    static const double powers[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* p = cursor;
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')){
+      negative = (*p == '-');
+      p++;
+    }
+
+    boost::uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any_digits = false;
+    bool truncated = false;
+
+    while(p < end && *p >= '0' && *p <= '9'){
+      any_digits = true;
+      if(digits < 19){
+        mantissa = (mantissa * 10) + (*p - '0');
+        if(mantissa){
+          digits++;
+        }
+      } else {
+        exponent++;
+        truncated = true;
+      }
+      p++;
+    }
+    if(p < end && *p == '.'){
+      p++;
+      while(p < end && *p >= '0' && *p <= '9'){
+        any_digits = true;
+        if(digits < 19){
+          mantissa = (mantissa * 10) + (*p - '0');
+          if(mantissa){
+            digits++;
+          }
+          exponent--;
+        } else {
+          truncated = true;
+        }
+        p++;
+      }
+    }
+    if(!any_digits){
+      return false;
+    }
+    if(p < end && (*p == 'e' || *p == 'E')){
+      const char* e = p + 1;
+      bool exp_negative = false;
+      if(e < end && (*e == '-' || *e == '+')){
+        exp_negative = (*e == '-');
+        e++;
+      }
+      if(e == end || *e < '0' || *e > '9'){
+        return false;
+      }
+      int exp_value = 0;
+      while(e < end && *e >= '0' && *e <= '9'){
+        if(exp_value < 10000){
+          exp_value = (exp_value * 10) + (*e - '0');
+        }
+        e++;
+      }
+      exponent += exp_negative ? -exp_value : exp_value;
+      p = e;
+    }
+
+    if(!truncated && mantissa <= (boost::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22){
+      double value = static_cast<double>(mantissa);
+      if(exponent < 0){
+        value /= powers[-exponent];
+      } else {
+        value *= powers[exponent];
+      }
+      out = negative ? -value : value;
+    } else if(p - cursor < 64){
+      // strtod needs a terminated string; copy to the stack rather than the heap
+      char holding[64];
+      std::memcpy(holding, cursor, p - cursor);
+      holding[p - cursor] = '\0';
+      out = std::strtod(holding, NULL);
+    } else {
+      std::string holding(cursor, p);
+      out = std::strtod(holding.c_str(), NULL);
+    }
+    cursor = p;
+    return true;
+  }
+
+  /**
+   * A single-pass scanner over a WKT object. Works directly on the
+   * character buffer (no copying or lower-casing) and reports
+   * problems by throwing boost::geometry::read_wkt_exception, the same
+   * exception boost::geometry::read_wkt would throw.
+   *
+   * A lenient scanner also accepts the sloppier WKT that wkt2geojson has
+   * always taken: closing brackets missing from the end of the object, missing
+   * commas between bracketed members ("(1 2, 3 4)(5 6, 7 8)") and tuples with
+   * more values than the rest of the object.
+   */
+  class wkt_scanner {
+
+  public:
+
+    wkt_scanner(const char* x, size_t size, bool lenient = false)
+      : begin(x), cursor(x), end(x + size), lenient(lenient) {}
+
+    /**
+     * A function for skipping whitespace
+     */
+    inline void skip_whitespace(){
+      while(cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')){
+        cursor++;
+      }
+    }
+
+    /**
+     * A function for checking whether the next non-whitespace character is c
+     */
+    inline bool peek(char c){
+      skip_whitespace();
+      return cursor < end && *cursor == c;
+    }
+
+    /**
+     * A function for consuming the next non-whitespace character if it is c
+     *
+     * @return whether c was consumed
+     */
+    inline bool accept(char c){
+      if(peek(c)){
+        cursor++;
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * A function for consuming the next non-whitespace character, failing if it is not c
+     */
+    inline void expect(char c){
+      if(!accept(c)){
+        if(lenient && c == ')' && cursor == end){
+          return;
+        }
+        if(c == '('){
+          fail("Expected '('");
+        }
+        if(c == ')'){
+          fail("Expected ')'");
+        }
+        fail(std::string("Expected '") + c + "'");
+      }
+    }
+
+    /**
+     * A function for moving on to the next member of a list, if there is one
+     *
+     * @return whether there is another member to read
+     */
+    inline bool next_item(){
+      return accept(',') || (lenient && peek('('));
+    }
+
+    /**
+     * A function for reading a number, failing if there is none or if it runs
+     * straight into something that is not a delimiter
+     */
+    inline double read_number(){
+      double out;
+      skip_whitespace();
+      if(!parse_double(cursor, end, out)){
+        fail("Expected a number");
+      }
+      if(cursor < end && !is_delimiter(*cursor)){
+        fail("Bad number");
+      }
+      return out;
+    }
+
+    /**
+     * A function for checking whether the next token is a number
+     */
+    inline bool at_number(){
+      skip_whitespace();
+      return cursor < end && ((*cursor >= '0' && *cursor <= '9') || *cursor == '-' ||
+                              *cursor == '+' || *cursor == '.');
+    }
+
+    /**
+     * A function for consuming the keyword EMPTY (in any case) if it is next
+     *
+     * @return whether EMPTY was consumed
+     */
+    inline bool accept_empty(){
+      skip_whitespace();
+      const char* word_end = word();
+      if(matches(cursor, word_end, "empty")){
+        cursor = word_end;
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * A function for reading the type of a WKT object, without consuming anything else.
+     * Dimension suffixes glued onto the type ("POINTZ") are recognised.
+     *
+     * @return a value from the supported_types enum
+     */
+    inline supported_types read_type(){
+      bool has_z, has_m;
+      return read_type(has_z, has_m);
+    }
+
+    /**
+     * A function for reading the header of a WKT object - the type, any Z/M/ZM marker
+     * and EMPTY.
+     *
+     * @param header a reference to a wkt_header to fill in
+     */
+    inline void read_header(wkt_header& header){
+      header.type = read_type(header.has_z, header.has_m);
+      if(header.type == unsupported_type){
+        fail("Object could not be recognised as a supported WKT type");
+      }
+      skip_whitespace();
+      const char* word_end = word();
+      if(matches(cursor, word_end, "z")){
+        header.has_z = true;
+        cursor = word_end;
+      } else if(matches(cursor, word_end, "m")){
+        header.has_m = true;
+        cursor = word_end;
+      } else if(matches(cursor, word_end, "zm")){
+        header.has_z = true;
+        header.has_m = true;
+        cursor = word_end;
+      }
+      header.is_empty = accept_empty();
+      if(!header.is_empty && !header.has_z && !header.has_m){
+        infer_dimensions(header);
+      }
+    }
+
+    /**
+     * A function for reading a single coordinate tuple ("x y", "x y z", ...)
+     *
+     * @param header the header of the object being read, which fixes how many values
+     * a tuple must have
+     *
+     * @param c a reference to the coordinate to fill in
+     */
+    inline void read_coordinate(const wkt_header& header, coordinate& c){
+      c.x = read_number();
+      c.y = read_number();
+      c.z = std::numeric_limits<double>::quiet_NaN();
+      c.m = std::numeric_limits<double>::quiet_NaN();
+      if(header.has_z){
+        c.z = read_number();
+      }
+      if(header.has_m){
+        c.m = read_number();
+      }
+      if(lenient && !header.has_z && !header.has_m && at_number()){
+        c.z = read_number();
+        if(at_number()){
+          c.m = read_number();
+        }
+      }
+      if(at_number()){
+        fail("Too many coordinates");
+      }
+    }
+
+    /**
+     * A function for checking that nothing but whitespace remains
+     */
+    inline void finish(){
+      skip_whitespace();
+      if(cursor != end){
+        fail("Too many tokens");
+      }
+    }
+
+    /**
+     * A function for reporting a parsing problem
+     *
+     * @param message a description of the problem
+     */
+    void fail(const std::string& message) const {
+      size_t size = end - begin;
+      throw boost::geometry::read_wkt_exception(message, std::string(begin, size > 100 ? 100 : size));
+    }
+
+    const char* position() const {
+      return cursor;
+    }
+
+  private:
+
+    static inline bool is_delimiter(char c){
+      return c == ' ' || c == ',' || c == ')' || c == '(' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static inline bool is_alpha(char c){
+      return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+    }
+
+    static inline bool matches(const char* x, const char* x_end, const char* lower){
+      size_t size = x_end - x;
+      if(size != std::strlen(lower)){
+        return false;
+      }
+      for(size_t i = 0; i < size; i++){
+        if((x[i] | 0x20) != lower[i]){
+          return false;
+        }
+      }
+      return true;
+    }
+
+    inline const char* word() const {
+      const char* p = cursor;
+      while(p < end && is_alpha(*p)){
+        p++;
+      }
+      return p;
+    }
+
+    inline supported_types read_type(bool& has_z, bool& has_m){
+      has_z = false;
+      has_m = false;
+      skip_whitespace();
+      const char* word_end = word();
+      const char* type_end = word_end;
+
+      // Allow for ISO-style names such as POINTZ or LINESTRINGZM. No
+      // type name ends in 'z' or 'm' so this is unambiguous.
+      if(type_end - cursor > 2 && matches(type_end - 2, type_end, "zm")){
+        has_z = true;
+        has_m = true;
+        type_end -= 2;
+      } else if(type_end - cursor > 1 && matches(type_end - 1, type_end, "z")){
+        has_z = true;
+        type_end--;
+      } else if(type_end - cursor > 1 && matches(type_end - 1, type_end, "m")){
+        has_m = true;
+        type_end--;
+      }
+
+      supported_types out = unsupported_type;
+      if(matches(cursor, type_end, "point")){
+        out = point;
+      } else if(matches(cursor, type_end, "multipoint")){
+        out = multi_point;
+      } else if(matches(cursor, type_end, "linestring")){
+        out = line_string;
+      } else if(matches(cursor, type_end, "multilinestring")){
+        out = multi_line_string;
+      } else if(matches(cursor, type_end, "polygon")){
+        out = polygon;
+      } else if(matches(cursor, type_end, "multipolygon")){
+        out = multi_polygon;
+      } else if(matches(cursor, type_end, "geometrycollection")){
+        out = geometry_collection;
+      }
+      if(out != unsupported_type){
+        cursor = word_end;
+      }
+      return out;
+    }
+
+    // Untagged objects may still carry a third and fourth value; look ahead to
+    // the first tuple and count. Three values are taken to be XYZ, four XYZM.
+    inline void infer_dimensions(wkt_header& header) const {
+      const char* p = cursor;
+      while(p < end && !(*p >= '0' && *p <= '9') && *p != '-' && *p != '+' && *p != '.'){
+        if(is_alpha(*p)){
+          return;
+        }
+        p++;
+      }
+      unsigned int values = 0;
+      while(p < end && *p != ',' && *p != ')'){
+        while(p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')){
+          p++;
+        }
+        if(p == end || *p == ',' || *p == ')'){
+          break;
+        }
+        values++;
+        while(p < end && !is_delimiter(*p)){
+          p++;
+        }
+      }
+      if(values >= 3){
+        header.has_z = true;
+      }
+      if(values >= 4){
+        header.has_m = true;
+      }
+    }
+
+    const char* begin;
+    const char* cursor;
+    const char* end;
+    bool lenient;
+  };
+
+  /**
+   * A no-op base for the handlers that read_body and read_geometry report to.
+   * Handlers override whichever of these events they care about:
+   *
+   * - begin_geometry/end_geometry around each object;
+   * - begin_part/end_part around each member of a multi- type or
+   *   GeometryCollection (whose members report their own begin_geometry and
+   *   end_geometry in between);
+   * - begin_ring/end_ring around each coordinate sequence (a linestring,
+   *   or one ring of a polygon);
+   * - coord for each coordinate.
+   */
+  struct wkt_handler {
+    // Whether the handler can follow GeometryCollections
+    static const bool collections = false;
+    inline void begin_geometry(const wkt_header&){}
+    inline void end_geometry(){}
+    inline void begin_part(unsigned int){}
+    inline void end_part(){}
+    inline void begin_ring(unsigned int){}
+    inline void end_ring(){}
+    inline void coord(const coordinate&){}
+  };
+
+  /**
+   * A function for reading a parenthesised, comma-separated coordinate sequence
+   */
+  template <typename Handler>
+  inline void read_sequence(wkt_scanner& scanner, const wkt_header& header, Handler& handler, unsigned int ring){
+    coordinate c;
+    handler.begin_ring(ring);
+    if(!scanner.accept_empty()){
+      scanner.expect('(');
+      do {
+        scanner.read_coordinate(header, c);
+        handler.coord(c);
+      } while(scanner.next_item());
+      scanner.expect(')');
+    }
+    handler.end_ring();
+  }
+
+  /**
+   * A function for reading a parenthesised list of rings
+   */
+  template <typename Handler>
+  inline void read_rings(wkt_scanner& scanner, const wkt_header& header, Handler& handler){
+    if(scanner.accept_empty()){
+      return;
+    }
+    scanner.expect('(');
+    unsigned int ring = 0;
+    do {
+      read_sequence(scanner, header, handler, ring++);
+    } while(scanner.next_item());
+    scanner.expect(')');
+  }
+
+  // The deepest GeometryCollections may be nested in one another. Readers
+  // recurse into each member, as do the shapes built from them, so without
+  // a limit a well-formed but deeply nested object would overflow the
+  // stack - which is far smaller on worker threads than on the main one.
+  static const unsigned int max_nesting = 1000;
+
+  /**
+   * A function for reading everything in a WKT object after its header
+   *
+   * @param scanner a reference to a wkt_scanner positioned after the header
+   *
+   * @param header the header, as read by wkt_scanner::read_header
+   *
+   * @param handler a reference to a handler to report to
+   *
+   * @param depth the number of GeometryCollections the object is inside
+   */
+  template <typename Handler>
+  void read_body(wkt_scanner& scanner, const wkt_header& header, Handler& handler,
+                 unsigned int depth = 0){
+
+    handler.begin_geometry(header);
+    if(header.is_empty){
+      handler.end_geometry();
+      return;
+    }
+
+    coordinate c;
+    unsigned int part = 0;
+    switch(header.type){
+    case point:
+      scanner.expect('(');
+      scanner.read_coordinate(header, c);
+      handler.coord(c);
+      scanner.expect(')');
+      break;
+    case line_string:
+      read_sequence(scanner, header, handler, 0);
+      break;
+    case polygon:
+      read_rings(scanner, header, handler);
+      break;
+    case multi_point:
+      scanner.expect('(');
+      do {
+        handler.begin_part(part++);
+        if(!scanner.accept_empty()){
+          // Both MULTIPOINT ((1 2), (3 4)) and MULTIPOINT (1 2, 3 4) are common
+          bool bracketed = scanner.accept('(');
+          scanner.read_coordinate(header, c);
+          handler.coord(c);
+          if(bracketed){
+            scanner.expect(')');
+          }
+        }
+        handler.end_part();
+      } while(scanner.next_item());
+      scanner.expect(')');
+      break;
+    case multi_line_string:
+      scanner.expect('(');
+      do {
+        handler.begin_part(part++);
+        read_sequence(scanner, header, handler, 0);
+        handler.end_part();
+      } while(scanner.next_item());
+      scanner.expect(')');
+      break;
+    case multi_polygon:
+      scanner.expect('(');
+      do {
+        handler.begin_part(part++);
+        read_rings(scanner, header, handler);
+        handler.end_part();
+      } while(scanner.next_item());
+      scanner.expect(')');
+      break;
+    case geometry_collection:
+      if(!Handler::collections){
+        scanner.fail("Object could not be recognised as a supported WKT type");
+      }
+      if(depth == max_nesting){
+        scanner.fail("GeometryCollections are too deeply nested");
+      }
+      scanner.expect('(');
+      do {
+        wkt_header member;
+        handler.begin_part(part++);
+        scanner.read_header(member);
+        read_body(scanner, member, handler, depth + 1);
+        handler.end_part();
+      } while(scanner.next_item());
+      scanner.expect(')');
+      break;
+    default:
+      scanner.fail("Object could not be recognised as a supported WKT type");
+    }
+    handler.end_geometry();
+  }
+
+  /**
+   * A function for reading a complete WKT object into a handler
+   *
+   * @param x a pointer to the (not necessarily null-terminated) WKT object
+   *
+   * @param size the number of bytes in x
+   *
+   * @param handler a reference to a handler to report to
+   *
+   * @param lenient whether to accept sloppy WKT; see wkt_scanner
+   */
+  template <typename Handler>
+  void read_geometry(const char* x, size_t size, Handler& handler, bool lenient = false){
+    wkt_scanner scanner(x, size, lenient);
+    wkt_header header;
+    scanner.read_header(header);
+    read_body(scanner, header, handler);
+    scanner.finish();
+  }
+
+  /**
+   * Handlers that fill in a boost::geometry object, used by read_wkt.
+   * Specialised on the boost::geometry tag of the target.
+   */
+  template <typename Geometry, typename Tag = typename boost::geometry::tag<Geometry>::type>
+  struct geometry_builder;
+
+  template <typename Geometry>
+  struct geometry_builder<Geometry, boost::geometry::point_tag> : wkt_handler {
+    static const supported_types type = point;
+    Geometry& geom;
+    geometry_builder(Geometry& g) : geom(g) {}
+    inline void coord(const coordinate& c){
+      boost::geometry::set<0>(geom, c.x);
+      boost::geometry::set<1>(geom, c.y);
+    }
+  };
+
+  template <typename Geometry>
+  struct geometry_builder<Geometry, boost::geometry::linestring_tag> : wkt_handler {
+    static const supported_types type = line_string;
+    typedef typename boost::geometry::point_type<Geometry>::type point_t;
+    Geometry& geom;
+    geometry_builder(Geometry& g) : geom(g) {}
+    inline void begin_geometry(const wkt_header&){
+      boost::geometry::clear(geom);
+    }
+    inline void coord(const coordinate& c){
+      geom.push_back(point_t(c.x, c.y));
+    }
+  };
+
+  template <typename Geometry>
+  struct geometry_builder<Geometry, boost::geometry::polygon_tag> : wkt_handler {
+    static const supported_types type = polygon;
+    typedef typename boost::geometry::point_type<Geometry>::type point_t;
+    typedef typename boost::geometry::ring_type<Geometry>::type ring_t;
+    Geometry& geom;
+    ring_t* ring;
+    geometry_builder(Geometry& g) : geom(g), ring(NULL) {}
+    inline void begin_geometry(const wkt_header&){
+      boost::geometry::clear(geom);
+    }
+    inline void begin_ring(unsigned int i){
+      if(i == 0){
+        ring = &geom.outer();
+      } else {
+        geom.inners().resize(geom.inners().size() + 1);
+        ring = &geom.inners().back();
+      }
+    }
+    inline void coord(const coordinate& c){
+      ring->push_back(point_t(c.x, c.y));
+    }
+  };
+
+  template <typename Geometry>
+  struct geometry_builder<Geometry, boost::geometry::multi_point_tag> : wkt_handler {
+    static const supported_types type = multi_point;
+    typedef typename boost::geometry::point_type<Geometry>::type point_t;
+    Geometry& geom;
+    geometry_builder(Geometry& g) : geom(g) {}
+    inline void begin_geometry(const wkt_header&){
+      boost::geometry::clear(geom);
+    }
+    inline void coord(const coordinate& c){
+      geom.push_back(point_t(c.x, c.y));
+    }
+  };
+
+  template <typename Geometry>
+  struct geometry_builder<Geometry, boost::geometry::multi_linestring_tag> : wkt_handler {
+    static const supported_types type = multi_line_string;
+    typedef typename boost::geometry::point_type<Geometry>::type point_t;
+    Geometry& geom;
+    geometry_builder(Geometry& g) : geom(g) {}
+    inline void begin_geometry(const wkt_header&){
+      boost::geometry::clear(geom);
+    }
+    inline void begin_part(unsigned int){
+      geom.resize(geom.size() + 1);
+    }
+    inline void coord(const coordinate& c){
+      geom.back().push_back(point_t(c.x, c.y));
+    }
+  };
+
+  template <typename Geometry>
+  struct geometry_builder<Geometry, boost::geometry::multi_polygon_tag> : wkt_handler {
+    static const supported_types type = multi_polygon;
+    typedef typename boost::geometry::point_type<Geometry>::type point_t;
+    typedef typename boost::geometry::ring_type<Geometry>::type ring_t;
+    Geometry& geom;
+    ring_t* ring;
+    geometry_builder(Geometry& g) : geom(g), ring(NULL) {}
+    inline void begin_geometry(const wkt_header&){
+      boost::geometry::clear(geom);
+    }
+    inline void begin_part(unsigned int){
+      geom.resize(geom.size() + 1);
+    }
+    inline void begin_ring(unsigned int i){
+      if(i == 0){
+        ring = &geom.back().outer();
+      } else {
+        geom.back().inners().resize(geom.back().inners().size() + 1);
+        ring = &geom.back().inners().back();
+      }
+    }
+    inline void coord(const coordinate& c){
+      ring->push_back(point_t(c.x, c.y));
+    }
+  };
+
+  /**
+   * A function for reading a WKT object into a boost::geometry object. A drop-in
+   * replacement for boost::geometry::read_wkt that works on a raw buffer.
+   *
+   * @param x a pointer to the (not necessarily null-terminated) WKT object
+   *
+   * @param size the number of bytes in x
+   *
+   * @param geom a reference to the boost::geometry object to fill in
+   */
+  template <typename Geometry>
+  void read_wkt(const char* x, size_t size, Geometry& geom){
+    typedef geometry_builder<Geometry> builder_type;
+    wkt_scanner scanner(x, size);
+    wkt_header header;
+    builder_type builder(geom);
+
+    scanner.read_header(header);
+    if(header.type != builder_type::type){
+      boost::geometry::clear(geom);
+      scanner.fail("Object does not match the expected WKT type");
+    }
+    read_body(scanner, header, builder);
+    scanner.finish();
+  }
+}
+#endif
@@ -1,80 +1,141 @@
 #include <Rcpp.h>
 using namespace Rcpp;
 #include "utils.h"
+#include "parallel.h"
+#include "shape.h"
+#include "stats.h"
 using namespace wkt_utils;
 
-template <typename T>
-std::string reverse_single(std::string wkt, T& obj){
-  try{
-    boost::geometry::read_wkt(wkt, obj);
+struct reverse_op {
+  template <typename T>
+  inline void operator()(T& obj){
     boost::geometry::reverse(obj);
-  } catch (boost::geometry::read_wkt_exception &e){
-    return wkt;
   }
+};
 
-  std::stringstream ss;
-  ss << boost::geometry::wkt(obj);
-  return ss.str();
-}
+struct reverse_worker {
+
+  const wkt_input& x;
+  wkt_output& output;
+  call_stats& stats;
+
+  reverse_worker(const wkt_input& x, wkt_output& output, call_stats& stats)
+    : x(x), output(output), stats(stats) {}
+
+  template <typename T>
+  inline void single(unsigned int i, row_stats& row){
+    T obj;
+    try{
+      x.read_into(i, obj);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.set_unchanged(i);
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+    boost::geometry::reverse(obj);
+    row.lap(compute_phase);
+
+    geometry_text_writer writer(output.open(i));
+    writer.write(obj);
+    row.lap(output_phase);
+  }
+
+  // Each member of a collection is reversed in place; the order of the
+  // members themselves is kept
+  inline void collection(unsigned int i, row_stats& row){
+    shape gc;
+    try{
+      gc.read(x, i);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.set_unchanged(i);
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+    if(gc.members.empty()){
+      output.set_unchanged(i);
+      return;
+    }
+    reverse_op op;
+    visit_shape(gc, op);
+    row.lap(compute_phase);
+    geometry_text_writer writer(output.open(i));
+    write_shape(writer, gc);
+    row.lap(output_phase);
+  }
+
+  void operator()(unsigned int i){
+    // Each row's geometry is built in, and released with, the arena
+    arena_scope scope;
+    row_stats row(stats.local());
+    if(x.is_na(i)){
+      row.row(-1);
+      output.set_na(i);
+      return;
+    }
+    row.row(x.size(i));
+    supported_types type = x.type(i);
+    row.lap(dispatch_phase);
+    switch(type){
+    case point:
+      single<point_type>(i, row);
+      break;
+    case line_string:
+      single<linestring_type>(i, row);
+      break;
+    case polygon:
+      single<polygon_type>(i, row);
+      break;
+    case multi_point:
+      single<multipoint_type>(i, row);
+      break;
+    case multi_line_string:
+      single<multilinestring_type>(i, row);
+      break;
+    case multi_polygon:
+      single<multipolygon_type>(i, row);
+      break;
+    case geometry_collection:
+      collection(i, row);
+      break;
+    default:
+      output.set_unchanged(i);
+      row.failed(x, i);
+    }
+  }
+};
 
 //' @title Reverses the points within a geometry.
 //' @description `wkt_reverse` reverses the points in any of
-//' point, multipoint, linestring, multilinestring, polygon, or
-//' multipolygon
+//' point, multipoint, linestring, multilinestring, polygon,
+//' multipolygon or geometrycollection (whose members are each reversed,
+//' in their original order)
 //' @export
-//' @param x a character vector of WKT objects, represented as strings
+//' @param x a character vector of WKT objects, represented as strings, or
+//' a `wkt_parsed` object from [wkt_parse()]
+//' @template nthreads
 //' @return a string, same length as given
 //' @details segment, box, and ring types not supported
 //' @examples
 //' wkt_reverse("POLYGON((42 -26,42 -13,52 -13,52 -26,42 -26))")
 // [[Rcpp::export]]
-CharacterVector wkt_reverse(CharacterVector x){
-
-  // Create instances of each type
-  point_type pt;
-  linestring_type ls;
-  polygon_type poly;
-  multipoint_type multip;
-  multilinestring_type multil;
-  multipolygon_type multipoly;
+CharacterVector wkt_reverse(SEXP x, SEXP nthreads = R_NilValue){
 
   // Generate output objects
-  unsigned int input_size = x.size();
-  CharacterVector output(input_size);
-  std::string holding;
+  int threads = resolve_threads(nthreads);
+  call_stats stats("wkt_reverse", threads);
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  wkt_output output(input_size);
 
-  for(unsigned int i = 0; i < input_size; i++){
-    if((i % 10000) == 0){
-      Rcpp::checkUserInterrupt();
-    }
-    if(x[i] == NA_STRING){
-      output[i] = NA_STRING;
-    } else {
-      holding = Rcpp::as<std::string>(x[i]);
-      switch(id_type(holding)){
-      case point:
-        output[i] = reverse_single(holding, pt);
-        break;
-      case line_string:
-        output[i] = reverse_single(holding, ls);
-        break;
-      case polygon:
-        output[i] = reverse_single(holding, poly);
-        break;
-      case multi_point:
-        output[i] = reverse_single(holding, multip);
-        break;
-      case multi_line_string:
-        output[i] = reverse_single(holding, multil);
-        break;
-      case multi_polygon:
-        output[i] = reverse_single(holding, multipoly);
-        break;
-      default:
-        output[i] = x[i];
-      }
-    }
-  }
+  parallel_for(input_size, threads, reverse_worker(input, output, stats));
 
-  return output;
+  row_stats row(stats.local());
+  CharacterVector result = output.to_r(input);
+  row.lap(output_phase);
+  stats.finish();
+  return result;
 }
@@ -0,0 +1,102 @@
+#include <Rcpp.h>
+using namespace Rcpp;
+#include "utils.h"
+#include "parallel.h"
+#include "writer.h"
+#include "stats.h"
+using namespace wkt_utils;
+
+struct snap_worker {
+
+  const wkt_input& x;
+  wkt_output& output;
+  double step;
+  bool snap_zm;
+  call_stats& stats;
+
+  snap_worker(const wkt_input& x, wkt_output& output, double step, bool snap_zm, call_stats& stats)
+    : x(x), output(output), step(step), snap_zm(snap_zm), stats(stats) {}
+
+  void operator()(unsigned int i){
+    row_stats row(stats.local());
+    if(x.is_na(i)){
+      row.row(-1);
+      output.set_na(i);
+      return;
+    }
+    row.row(x.size(i));
+    snapping_writer writer(output.open(i), step, snap_zm);
+    try {
+      x.read(i, writer);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.set_unchanged(i);
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+  }
+};
+
+CharacterVector snap(SEXP x, double step, bool snap_zm, SEXP nthreads, const char* kernel){
+
+  int threads = resolve_threads(nthreads);
+  call_stats stats(kernel, threads);
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  wkt_output output(input_size);
+
+  parallel_for(input_size, threads, snap_worker(input, output, step, snap_zm, stats));
+
+  row_stats row(stats.local());
+  CharacterVector result = output.to_r(input);
+  row.lap(output_phase);
+  stats.finish();
+  return result;
+}
+
+//' @title Reduce the Precision of WKT Objects
+//' @description `wkt_round` rounds every coordinate to a number of decimal
+//' places, and `wkt_snap` moves every point to the nearest point of a
+//' regular grid. Both rewrite each object in one pass, and drop any
+//' consecutive points of a linestring or ring left in the same place -
+//' the duplicate points [validate_wkt()] reports - keeping the first.
+//' @export
+//' @rdname wkt_round
+//' @param x a character vector of WKT objects, or a list of raw vectors
+//' of WKB objects (or a single raw vector), or a `wkt_parsed` object from
+//' [wkt_parse()].
+//' @param digits the number of decimal places to round to. Negative
+//' values round to tens, hundreds and so on. Z and M values are rounded
+//' too.
+//' @template nthreads
+//' @return a character vector of WKT, the same length as `x`, with numbers
+//' written with no more digits than they need. Objects that are `NA` are
+//' `NA`, and those that can't be parsed are returned as they were.
+//' @details Dropping duplicate points can leave a linestring with a
+//' single point, or a ring with fewer than four; these are written as
+//' they are, and [validate_wkt()] will report them. Points in
+//' multipoints are never dropped.
+//' @seealso [wkt_simplify()] to remove points that add little to a shape
+//' @examples
+//' wkt_round("LINESTRING (30.123456789 10.987654321, 30.12349 10.98761, 40 40)", 3)
+//' wkt_snap("POLYGON ((0.02 0.01, 0.98 0.03, 1.01 0.99, 0.05 1.02, 0.02 0.01))", 0.5)
+// [[Rcpp::export]]
+CharacterVector wkt_round(SEXP x, int digits = 6, SEXP nthreads = R_NilValue){
+  if(digits == NA_INTEGER || digits > 300 || digits < -300){
+    Rcpp::stop("digits must be a whole number between -300 and 300");
+  }
+  return snap(x, std::pow(10.0, -digits), true, nthreads, "wkt_round");
+}
+
+//' @export
+//' @rdname wkt_round
+//' @param grid the spacing of the grid, in the units of the coordinates. Z
+//' and M values are left as they are.
+// [[Rcpp::export]]
+CharacterVector wkt_snap(SEXP x, double grid, SEXP nthreads = R_NilValue){
+  if(!(grid > 0) || !std::isfinite(grid)){
+    Rcpp::stop("grid must be a positive number");
+  }
+  return snap(x, grid, false, nthreads, "wkt_snap");
+}
@@ -0,0 +1,345 @@
+#include <limits>
+#include <vector>
+#include <boost/geometry.hpp>
+#include "def.h"
+#include "utils.h"
+#include "writer.h"
+
+#ifndef __WKT_SHAPE__
+#define __WKT_SHAPE__
+namespace wkt_utils {
+
+  /**
+   * An object read into whichever def.h type matches it, along with its
+   * bounding box, for algorithms that take objects of arbitrary types. Only
+   * the member matching type is filled in; a GeometryCollection holds its
+   * members as shapes of their own.
+   *
+   * Like any def.h geometry, a shape read while an arena_scope is open must
+   * not outlive the scope; shapes kept across rows should be read outside
+   * of one, on the heap.
+   */
+  struct shape {
+
+    supported_types type;
+    bool is_empty;
+    box_type envelope;
+
+    point_type point_geom;
+    multipoint_type multipoint_geom;
+    linestring_type linestring_geom;
+    multilinestring_type multilinestring_geom;
+    polygon_type polygon_geom;
+    multipolygon_type multipolygon_geom;
+    std::vector < shape > members;
+
+    shape() : type(unsupported_type), is_empty(true) {}
+
+    /**
+     * A function for reading an object into the shape
+     *
+     * @param x the input to read from
+     *
+     * @param i the index of the object
+     *
+     * @return true; throws a read_wkt_exception if the object couldn't be
+     * read, or isn't of a supported type
+     */
+    bool read(const wkt_input& x, unsigned int i);
+
+    /**
+     * A function for working out the shape's emptiness and bounding box once
+     * its geometry (or its members) have been filled in
+     */
+    inline void finish(){
+      switch(type){
+      case point:
+        // POINT EMPTY leaves the point as the NaN it starts out as
+        is_empty = ISNAN(boost::geometry::get<0>(point_geom));
+        break;
+      case multi_point:
+        set_envelope(multipoint_geom);
+        return;
+      case line_string:
+        set_envelope(linestring_geom);
+        return;
+      case multi_line_string:
+        set_envelope(multilinestring_geom);
+        return;
+      case polygon:
+        set_envelope(polygon_geom);
+        return;
+      case multi_polygon:
+        set_envelope(multipolygon_geom);
+        return;
+      default:
+        // A collection's box covers its non-empty members' boxes
+        is_empty = true;
+        for(unsigned int i = 0; i < members.size(); i++){
+          if(members[i].is_empty){
+            continue;
+          }
+          if(is_empty){
+            envelope = members[i].envelope;
+            is_empty = false;
+          } else {
+            boost::geometry::expand(envelope, members[i].envelope);
+          }
+        }
+        return;
+      }
+      if(!is_empty){
+        boost::geometry::envelope(point_geom, envelope);
+      }
+    }
+
+  private:
+
+    template <typename T>
+    inline void set_envelope(const T& geom){
+      is_empty = boost::geometry::is_empty(geom);
+      if(!is_empty){
+        boost::geometry::envelope(geom, envelope);
+      }
+    }
+  };
+
+  /**
+   * The handler a shape is read through: fills in the geometry matching
+   * each object's type, descending into GeometryCollections
+   */
+  struct shape_builder : wkt_handler {
+
+    static const bool collections = true;
+
+    shape& root;
+    // The shapes being read, innermost last
+    std::vector < shape* > open;
+    polygon_type::ring_type* ring;
+
+    shape_builder(shape& root) : root(root), ring(NULL) {}
+
+    inline void begin_geometry(const wkt_header& header){
+      shape* s = &root;
+      if(!open.empty()){
+        open.back()->members.push_back(shape());
+        s = &open.back()->members.back();
+      }
+      s->type = header.type;
+      s->members.clear();
+      switch(header.type){
+      case point:
+        boost::geometry::assign_values(s->point_geom, std::numeric_limits<double>::quiet_NaN(),
+                                       std::numeric_limits<double>::quiet_NaN());
+        break;
+      case multi_point:
+        boost::geometry::clear(s->multipoint_geom);
+        break;
+      case line_string:
+        boost::geometry::clear(s->linestring_geom);
+        break;
+      case multi_line_string:
+        boost::geometry::clear(s->multilinestring_geom);
+        break;
+      case polygon:
+        boost::geometry::clear(s->polygon_geom);
+        break;
+      case multi_polygon:
+        boost::geometry::clear(s->multipolygon_geom);
+        break;
+      default:
+        break;
+      }
+      open.push_back(s);
+    }
+
+    inline void end_geometry(){
+      open.back()->finish();
+      open.pop_back();
+    }
+
+    inline void begin_part(unsigned int){
+      shape* s = open.back();
+      if(s->type == multi_line_string){
+        s->multilinestring_geom.resize(s->multilinestring_geom.size() + 1);
+      } else if(s->type == multi_polygon){
+        s->multipolygon_geom.resize(s->multipolygon_geom.size() + 1);
+      }
+    }
+
+    inline void begin_ring(unsigned int i){
+      shape* s = open.back();
+      if(s->type != polygon && s->type != multi_polygon){
+        return;
+      }
+      polygon_type& poly = s->type == polygon ? s->polygon_geom : s->multipolygon_geom.back();
+      if(i == 0){
+        ring = &poly.outer();
+      } else {
+        poly.inners().resize(poly.inners().size() + 1);
+        ring = &poly.inners().back();
+      }
+    }
+
+    inline void coord(const coordinate& c){
+      shape* s = open.back();
+      switch(s->type){
+      case point:
+        boost::geometry::assign_values(s->point_geom, c.x, c.y);
+        break;
+      case multi_point:
+        s->multipoint_geom.push_back(point_type(c.x, c.y));
+        break;
+      case line_string:
+        s->linestring_geom.push_back(point_type(c.x, c.y));
+        break;
+      case multi_line_string:
+        s->multilinestring_geom.back().push_back(point_type(c.x, c.y));
+        break;
+      default:
+        ring->push_back(point_type(c.x, c.y));
+      }
+    }
+  };
+
+  inline bool shape::read(const wkt_input& x, unsigned int i){
+    shape_builder builder(*this);
+    x.read(i, builder);
+    return true;
+  }
+
+  /**
+   * A function for applying an operation to every geometry in a shape,
+   * descending into GeometryCollections
+   *
+   * @param s the shape (or a const shape)
+   *
+   * @param op a function object with a templated operator() taking a
+   * geometry of any of the def.h types
+   */
+  template <typename Shape, typename Op>
+  inline void visit_shape(Shape& s, Op& op){
+    switch(s.type){
+    case point:
+      op(s.point_geom);
+      break;
+    case multi_point:
+      op(s.multipoint_geom);
+      break;
+    case line_string:
+      op(s.linestring_geom);
+      break;
+    case multi_line_string:
+      op(s.multilinestring_geom);
+      break;
+    case polygon:
+      op(s.polygon_geom);
+      break;
+    case multi_polygon:
+      op(s.multipolygon_geom);
+      break;
+    default:
+      for(unsigned int i = 0; i < s.members.size(); i++){
+        visit_shape(s.members[i], op);
+      }
+    }
+  }
+
+  /**
+   * A function for writing a shape as WKT, in geometry_text_writer's layout
+   *
+   * @param writer the writer to write with
+   *
+   * @param s the shape
+   */
+  inline void write_shape(geometry_text_writer& writer, const shape& s){
+    switch(s.type){
+    case point:
+      if(s.is_empty){
+        writer.out += "POINT EMPTY";
+      } else {
+        writer.write(s.point_geom);
+      }
+      break;
+    case multi_point:
+      writer.write(s.multipoint_geom);
+      break;
+    case line_string:
+      writer.write(s.linestring_geom);
+      break;
+    case multi_line_string:
+      writer.write(s.multilinestring_geom);
+      break;
+    case polygon:
+      writer.write(s.polygon_geom);
+      break;
+    case multi_polygon:
+      writer.write(s.multipolygon_geom);
+      break;
+    default:
+      if(s.members.empty()){
+        writer.out += "GEOMETRYCOLLECTION EMPTY";
+        return;
+      }
+      writer.out += "GEOMETRYCOLLECTION(";
+      for(unsigned int i = 0; i < s.members.size(); i++){
+        if(i){
+          writer.out += ',';
+        }
+        write_shape(writer, s.members[i]);
+      }
+      writer.out += ')';
+    }
+  }
+
+  template <typename Geometry, typename Op>
+  inline bool apply_second(const Geometry& a, const shape& b, const Op& op){
+    switch(b.type){
+    case point:
+      return op(a, b.point_geom);
+    case multi_point:
+      return op(a, b.multipoint_geom);
+    case line_string:
+      return op(a, b.linestring_geom);
+    case multi_line_string:
+      return op(a, b.multilinestring_geom);
+    case polygon:
+      return op(a, b.polygon_geom);
+    default:
+      return op(a, b.multipolygon_geom);
+    }
+  }
+
+  /**
+   * A function for applying a binary operation to the geometries held by
+   * two shapes, whatever their types
+   *
+   * @param a the first shape, which must have been read successfully and
+   * can't be a GeometryCollection
+   *
+   * @param b the second shape, likewise
+   *
+   * @param op a function object with a templated operator() taking the two
+   * geometries
+   *
+   * @return the result of op
+   */
+  template <typename Op>
+  inline bool apply_shapes(const shape& a, const shape& b, const Op& op){
+    switch(a.type){
+    case point:
+      return apply_second(a.point_geom, b, op);
+    case multi_point:
+      return apply_second(a.multipoint_geom, b, op);
+    case line_string:
+      return apply_second(a.linestring_geom, b, op);
+    case multi_line_string:
+      return apply_second(a.multilinestring_geom, b, op);
+    case polygon:
+      return apply_second(a.polygon_geom, b, op);
+    default:
+      return apply_second(a.multipolygon_geom, b, op);
+    }
+  }
+}
+#endif
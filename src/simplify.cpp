@@ -0,0 +1,250 @@
+#include <Rcpp.h>
+using namespace Rcpp;
+#include "utils.h"
+#include "parallel.h"
+#include "shape.h"
+#include "simplify.h"
+#include "stats.h"
+using namespace wkt_utils;
+
+/**
+ * Simplifies each geometry in a shape in place, descending into
+ * GeometryCollections, whose members are dropped if nothing of them is left
+ */
+struct simplify_op {
+
+  simplifier& simplify;
+  double tolerance;
+
+  simplify_op(simplifier& simplify, double tolerance)
+    : simplify(simplify), tolerance(tolerance) {}
+
+  template <typename T>
+  inline void operator()(T& obj){
+    T out;
+    simplify.simplify(obj, out, tolerance);
+    obj = out;
+  }
+
+  inline void members(shape& gc){
+    unsigned int kept = 0;
+    for(unsigned int i = 0; i < gc.members.size(); i++){
+      shape& member = gc.members[i];
+      if(member.type == geometry_collection){
+        members(member);
+      } else {
+        visit_shape(member, *this);
+      }
+      if(!empty(member)){
+        if(kept != i){
+          std::swap(gc.members[kept], member);
+        }
+        kept++;
+      }
+    }
+    gc.members.resize(kept);
+  }
+
+  static inline bool empty(const shape& s){
+    switch(s.type){
+    case point:
+      return s.is_empty;
+    case multi_point:
+      return boost::geometry::is_empty(s.multipoint_geom);
+    case line_string:
+      return boost::geometry::is_empty(s.linestring_geom);
+    case multi_line_string:
+      return boost::geometry::is_empty(s.multilinestring_geom);
+    case polygon:
+      return boost::geometry::is_empty(s.polygon_geom);
+    case multi_polygon:
+      return boost::geometry::is_empty(s.multipolygon_geom);
+    default:
+      return s.members.empty();
+    }
+  }
+};
+
+struct simplify_worker {
+
+  const wkt_input& x;
+  const double* tolerance;
+  bool recycle;
+  wkt_output& output;
+  call_stats& stats;
+  simplifier simplify;
+
+  simplify_worker(const wkt_input& x, const double* tolerance, bool recycle, simplify_method method,
+                  bool preserve_topology, wkt_output& output, call_stats& stats)
+    : x(x), tolerance(tolerance), recycle(recycle), output(output), stats(stats),
+      simplify(method, preserve_topology) {}
+
+  // Objects left with nothing are written as empty ones of the same type,
+  // which boost::geometry can't write
+  template <typename T>
+  inline void write(unsigned int i, const T& obj, const char* name){
+    if(boost::geometry::is_empty(obj)){
+      output.set(i, std::string(name) + " EMPTY");
+      return;
+    }
+    geometry_text_writer writer(output.open(i));
+    writer.write(obj);
+  }
+
+  inline void write(unsigned int i, const point_type& obj, const char*){
+    geometry_text_writer writer(output.open(i));
+    writer.write(obj);
+  }
+
+  template <typename T>
+  inline void single(unsigned int i, const char* name, row_stats& row){
+    T obj;
+    try{
+      x.read_into(i, obj);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.set_unchanged(i);
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+    T simplified;
+    simplify.simplify(obj, simplified, tolerance[recycle ? 0 : i]);
+    row.lap(compute_phase);
+    write(i, simplified, name);
+    row.lap(output_phase);
+  }
+
+  inline void collection(unsigned int i, row_stats& row){
+    shape gc;
+    try{
+      gc.read(x, i);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.set_unchanged(i);
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+    simplify_op op(simplify, tolerance[recycle ? 0 : i]);
+    op.members(gc);
+    row.lap(compute_phase);
+    if(gc.members.empty()){
+      output.set(i, "GEOMETRYCOLLECTION EMPTY");
+      return;
+    }
+    geometry_text_writer writer(output.open(i));
+    write_shape(writer, gc);
+    row.lap(output_phase);
+  }
+
+  void operator()(unsigned int i){
+    // Each row's geometry is built in, and released with, the arena
+    arena_scope scope;
+    row_stats row(stats.local());
+    if(x.is_na(i)){
+      row.row(-1);
+      output.set_na(i);
+      return;
+    }
+    row.row(x.size(i));
+    supported_types type = x.type(i);
+    row.lap(dispatch_phase);
+    switch(type){
+    case point:
+      single<point_type>(i, "POINT", row);
+      break;
+    case line_string:
+      single<linestring_type>(i, "LINESTRING", row);
+      break;
+    case polygon:
+      single<polygon_type>(i, "POLYGON", row);
+      break;
+    case multi_point:
+      single<multipoint_type>(i, "MULTIPOINT", row);
+      break;
+    case multi_line_string:
+      single<multilinestring_type>(i, "MULTILINESTRING", row);
+      break;
+    case multi_polygon:
+      single<multipolygon_type>(i, "MULTIPOLYGON", row);
+      break;
+    case geometry_collection:
+      collection(i, row);
+      break;
+    default:
+      output.set_unchanged(i);
+      row.failed(x, i);
+    }
+  }
+};
+
+//' @title Simplify WKT Objects
+//' @description `wkt_simplify` simplifies the linestrings and polygon
+//' rings in any of point, multipoint, linestring, multilinestring, polygon,
+//' multipolygon or geometrycollection, dropping the points that add least
+//' to their shape.
+//' @export
+//' @param x a character vector of WKT objects, represented as strings, or
+//' a `wkt_parsed` object from [wkt_parse()]
+//' @param tolerance how far to simplify: a single non-negative number, or
+//' one per object. For `"douglas-peucker"`, the furthest a dropped point
+//' may be from the simplified line, in the units of the coordinates; for
+//' `"visvalingam"`, the largest area of the triangle a dropped point forms
+//' with its neighbours, in squared units.
+//' @param method the algorithm: `"douglas-peucker"` (the default), using
+//' `boost::geometry::simplify`, or `"visvalingam"` (Visvalingam-Whyatt),
+//' which tends to keep shapes smoother at the same number of points.
+//' @param preserve_topology whether to keep each object's parts, rings and
+//' validity. If `TRUE`, an object that would lose a ring or part, or become
+//' invalid (or, for linestrings, cross itself) when it wasn't before, is
+//' simplified again at half the tolerance, as many as 9 times, after which
+//' it is returned unsimplified. Set to `FALSE` by default.
+//' @template nthreads
+//' @return a string, same length as given. Linestrings left with fewer
+//' than two distinct points, and rings with no area, are dropped, along
+//' with polygons whose exterior rings are dropped; objects left with
+//' nothing are returned as, for instance, `"POLYGON EMPTY"`. Objects that
+//' cannot be parsed are returned unchanged.
+//' @details Linestrings keep their first and last points. Rings may lose
+//' any of theirs, so simplified rings can start at a different point. Each
+//' member of a GeometryCollection is simplified in turn.
+//' @examples
+//' wkt_simplify("LINESTRING (0 0, 1 0.1, 2 -0.1, 3 5, 4 6, 5 7, 6 8.1, 7 9, 8 9, 9 9)", 0.5)
+//' wkt_simplify("POLYGON ((0 0, 0 10, 0.1 10.1, 10 10, 10 0, 0 0))", 1,
+//'   method = "visvalingam")
+// [[Rcpp::export]]
+CharacterVector wkt_simplify(SEXP x, NumericVector tolerance, std::string method = "douglas-peucker",
+                             bool preserve_topology = false, SEXP nthreads = R_NilValue){
+
+  simplify_method algorithm = douglas_peucker;
+  if(method == "visvalingam"){
+    algorithm = visvalingam_whyatt;
+  } else if(method != "douglas-peucker"){
+    Rcpp::stop("method must be one of 'douglas-peucker' or 'visvalingam'");
+  }
+
+  int threads = resolve_threads(nthreads);
+  call_stats stats("wkt_simplify", threads);
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  if(tolerance.size() != 1 && tolerance.size() != input_size){
+    Rcpp::stop("tolerance must be of length 1 or the same length as x");
+  }
+  for(unsigned int i = 0; i < tolerance.size(); i++){
+    if(ISNAN(tolerance[i]) || tolerance[i] < 0){
+      Rcpp::stop("tolerance must be a non-negative number");
+    }
+  }
+  wkt_output output(input_size);
+
+  parallel_for(input_size, threads,
+               simplify_worker(input, REAL(tolerance), tolerance.size() == 1, algorithm,
+                               preserve_topology, output, stats));
+
+  row_stats row(stats.local());
+  CharacterVector result = output.to_r(input);
+  row.lap(output_phase);
+  stats.finish();
+  return result;
+}
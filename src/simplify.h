@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "def.h"
+#include "sweep.h"
+
+#ifndef __WKT_SIMPLIFY__
+#define __WKT_SIMPLIFY__
+namespace wkt_utils {
+
+  enum simplify_method { douglas_peucker, visvalingam_whyatt };
+
+  /**
+   * Simplifies objects of any of the def.h types, either by Douglas-Peucker,
+   * through boost::geometry::simplify, or by Visvalingam-Whyatt, which
+   * repeatedly drops the point forming the smallest triangle with its
+   * neighbours. Linestrings keep their end points; rings are treated as
+   * cycles, so any of their points may go.
+   *
+   * Linestrings simplified to fewer than two distinct points, and rings to
+   * fewer than three or no area, are dropped - a polygon along with its
+   * exterior ring - as are parts of multi-part objects left empty. With
+   * preserve_topology set, an object that would lose a part or a ring that
+   * way, or would become invalid (or, for linestrings, stop being simple)
+   * when it wasn't before, is simplified again at half the tolerance, and so
+   * on, and left as it is if it still can't be after max_attempts tries.
+   *
+   * One simplifier is kept per thread, so that the Visvalingam-Whyatt
+   * buffers are reused from row to row.
+   */
+  class simplifier {
+
+  public:
+
+    static const unsigned int max_attempts = 10;
+
+    /**
+     * @param method the algorithm to simplify with
+     *
+     * @param preserve_topology whether to keep objects' parts, rings and
+     * validity
+     */
+    simplifier(simplify_method method, bool preserve_topology)
+      : method(method), preserve_topology(preserve_topology), tolerance(0) {}
+
+    /**
+     * A function for simplifying an object
+     *
+     * @param in the object
+     *
+     * @param out a reference to an (empty) object of the same type to write
+     * the result into
+     *
+     * @param max_distance the tolerance: for Douglas-Peucker, the furthest a
+     * dropped point may be from the simplified line; for Visvalingam-Whyatt,
+     * the largest area a dropped point's triangle may have
+     */
+    template <typename Geometry>
+    void simplify(const Geometry& in, Geometry& out, double max_distance){
+      tolerance = max_distance;
+      simplify_geometry(in, out);
+      if(!preserve_topology){
+        return;
+      }
+      int input_fine = -1;
+      for(unsigned int attempt = 1; ; attempt++){
+        if(same_parts(in, out)){
+          if(fine(out)){
+            return;
+          }
+          // Only count against the result what the input didn't already have
+          if(input_fine < 0){
+            input_fine = fine(in);
+          }
+          if(!input_fine){
+            return;
+          }
+        }
+        if(attempt == max_attempts){
+          out = in;
+          return;
+        }
+        tolerance /= 2;
+        boost::geometry::clear(out);
+        simplify_geometry(in, out);
+      }
+    }
+
+  private:
+
+    simplify_method method;
+    bool preserve_topology;
+    double tolerance;
+
+    // The Visvalingam-Whyatt state for one range: each point's neighbours
+    // among those still in, and the area of its triangle with them
+    std::vector < size_t > prev;
+    std::vector < size_t > next;
+    std::vector < double > area;
+    std::vector < bool > removed;
+    typedef std::pair < double, size_t > candidate;
+    std::priority_queue < candidate, std::vector < candidate >, std::greater < candidate > > queue;
+
+    static inline double x(const point_type& p){
+      return boost::geometry::get<0>(p);
+    }
+
+    static inline double y(const point_type& p){
+      return boost::geometry::get<1>(p);
+    }
+
+    template <typename Range>
+    static inline bool collapsed_line(const Range& line){
+      for(size_t i = 1; i < line.size(); i++){
+        if(x(line[i]) != x(line[0]) || y(line[i]) != y(line[0])){
+          return false;
+        }
+      }
+      return true;
+    }
+
+    template <typename Ring>
+    static inline bool collapsed_ring(const Ring& ring){
+      return ring.size() < 4 || boost::geometry::area(ring) == 0;
+    }
+
+    template <typename Range>
+    inline double triangle(const Range& points, size_t i) const {
+      const point_type& a = points[prev[i]];
+      const point_type& b = points[i];
+      const point_type& c = points[next[i]];
+      return std::fabs((x(a) - x(b)) * (y(c) - y(b)) - (y(a) - y(b)) * (x(c) - x(b))) / 2;
+    }
+
+    /**
+     * A function for simplifying a linestring or ring by Visvalingam-Whyatt
+     *
+     * @param in the points
+     *
+     * @param out a reference to where to write the points that are kept
+     *
+     * @param ring whether it's a ring
+     */
+    template <typename Range>
+    void visvalingam(const Range& in, Range& out, bool ring){
+      // A ring's closing point, if it has one, is its first again
+      size_t n = in.size();
+      if(ring && x(in[0]) == x(in[n - 1]) && y(in[0]) == y(in[n - 1])){
+        n--;
+      }
+      size_t keep = ring ? 3 : 2;
+      if(n <= keep){
+        out = in;
+        return;
+      }
+      prev.resize(n);
+      next.resize(n);
+      area.resize(n);
+      removed.assign(n, false);
+      for(size_t i = 0; i < n; i++){
+        prev[i] = i == 0 ? n - 1 : i - 1;
+        next[i] = i == n - 1 ? 0 : i + 1;
+      }
+      // A linestring's ends never go
+      size_t first = ring ? 0 : 1;
+      size_t last = ring ? n : n - 1;
+      for(size_t i = first; i < last; i++){
+        area[i] = triangle(in, i);
+        queue.push(candidate(area[i], i));
+      }
+
+      size_t remaining = n;
+      while(!queue.empty() && remaining > keep){
+        candidate c = queue.top();
+        queue.pop();
+        size_t i = c.second;
+        // Entries for points since removed, or whose triangles have
+        // changed, are stale
+        if(removed[i] || c.first != area[i]){
+          continue;
+        }
+        if(c.first >= tolerance){
+          break;
+        }
+        removed[i] = true;
+        remaining--;
+        next[prev[i]] = next[i];
+        prev[next[i]] = prev[i];
+        size_t neighbours[] = {prev[i], next[i]};
+        for(unsigned int j = 0; j < 2; j++){
+          size_t k = neighbours[j];
+          if(ring || (k != 0 && k != n - 1)){
+            area[k] = triangle(in, k);
+            queue.push(candidate(area[k], k));
+          }
+        }
+      }
+      while(!queue.empty()){
+        queue.pop();
+      }
+
+      size_t start = 0;
+      while(removed[start]){
+        start++;
+      }
+      size_t i = start;
+      do {
+        out.push_back(in[i]);
+        i = next[i];
+      } while(i != start);
+      if(ring){
+        out.push_back(in[start]);
+      }
+    }
+
+    template <typename Line>
+    inline void line(const Line& in, Line& out){
+      if(method == douglas_peucker){
+        boost::geometry::simplify(in, out, tolerance);
+      } else {
+        visvalingam(in, out, false);
+      }
+      if(collapsed_line(out)){
+        boost::geometry::clear(out);
+      }
+    }
+
+    template <typename Ring>
+    inline void ring(const Ring& in, Ring& out){
+      if(in.size() >= 3){
+        if(method == douglas_peucker){
+          boost::geometry::simplify(in, out, tolerance);
+        } else {
+          visvalingam(in, out, true);
+        }
+      }
+      if(!out.empty() && (x(out.front()) != x(out.back()) || y(out.front()) != y(out.back()))){
+        out.push_back(out.front());
+      }
+      if(collapsed_ring(out)){
+        boost::geometry::clear(out);
+      }
+    }
+
+    inline void polygon(const polygon_type& in, polygon_type& out){
+      ring(in.outer(), out.outer());
+      if(out.outer().empty()){
+        return;
+      }
+      for(unsigned int i = 0; i < in.inners().size(); i++){
+        out.inners().resize(out.inners().size() + 1);
+        ring(in.inners()[i], out.inners().back());
+        if(out.inners().back().empty()){
+          out.inners().pop_back();
+        }
+      }
+    }
+
+    inline void simplify_geometry(const point_type& in, point_type& out){
+      out = in;
+    }
+
+    inline void simplify_geometry(const multipoint_type& in, multipoint_type& out){
+      out = in;
+    }
+
+    inline void simplify_geometry(const linestring_type& in, linestring_type& out){
+      line(in, out);
+    }
+
+    inline void simplify_geometry(const multilinestring_type& in, multilinestring_type& out){
+      for(unsigned int i = 0; i < in.size(); i++){
+        out.resize(out.size() + 1);
+        line(in[i], out.back());
+        if(out.back().empty()){
+          out.pop_back();
+        }
+      }
+    }
+
+    inline void simplify_geometry(const polygon_type& in, polygon_type& out){
+      polygon(in, out);
+    }
+
+    inline void simplify_geometry(const multipolygon_type& in, multipolygon_type& out){
+      for(unsigned int i = 0; i < in.size(); i++){
+        out.resize(out.size() + 1);
+        polygon(in[i], out.back());
+        if(out.back().outer().empty()){
+          out.pop_back();
+        }
+      }
+    }
+
+    template <typename Geometry>
+    static inline bool same_parts(const Geometry& in, const Geometry& out){
+      return boost::geometry::num_geometries(in) == boost::geometry::num_geometries(out) &&
+        boost::geometry::num_interior_rings(in) == boost::geometry::num_interior_rings(out) &&
+        boost::geometry::is_empty(in) == boost::geometry::is_empty(out);
+    }
+
+    template <typename Geometry>
+    static inline bool fine(const Geometry&){
+      return true;
+    }
+
+    static inline bool fine(const linestring_type& geom){
+      return boost::geometry::is_simple(geom);
+    }
+
+    static inline bool fine(const multilinestring_type& geom){
+      return boost::geometry::is_simple(geom);
+    }
+
+    static inline bool fine(const polygon_type& geom){
+      boost::geometry::validity_failure_type failure;
+      return is_valid(geom, failure);
+    }
+
+    static inline bool fine(const multipolygon_type& geom){
+      boost::geometry::validity_failure_type failure;
+      return is_valid(geom, failure);
+    }
+  };
+}
+#endif
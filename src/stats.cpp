@@ -0,0 +1,176 @@
+#include <Rcpp.h>
+using namespace Rcpp;
+#include "stats.h"
+using namespace wkt_utils;
+
+/**
+ * A finished call, as wellknown_stats() reports it
+ */
+struct call_record {
+  std::string kernel;
+  int nthreads;
+  thread_stats totals;
+  double seconds;
+};
+
+// The most recent calls made with the wellknown.stats option set, oldest
+// first. Only so many are kept, so that leaving the option on doesn't grow
+// the session without bound.
+static std::vector < call_record > history;
+static const unsigned int history_size = 1000;
+
+wkt_utils::call_stats::call_stats(const char* kernel, int nthreads)
+  : enabled(false), kernel(kernel), nthreads(nthreads) {
+  SEXP option = Rf_GetOption1(Rf_install("wellknown.stats"));
+  if(Rf_isNull(option) || Rf_asLogical(option) != TRUE){
+    return;
+  }
+  enabled = true;
+  slots.resize(nthreads);
+  started = std::chrono::steady_clock::now();
+}
+
+void wkt_utils::call_stats::finish(){
+  if(!enabled){
+    return;
+  }
+  call_record record;
+  record.kernel = kernel;
+  record.nthreads = nthreads;
+  record.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  thread_stats& totals = record.totals;
+  for(unsigned int i = 0; i < slots.size(); i++){
+    const thread_stats& slot = slots[i];
+    totals.rows += slot.rows;
+    totals.missing += slot.missing;
+    totals.bytes += slot.bytes;
+    for(unsigned int j = 0; j <= unsupported_type; j++){
+      totals.failures[j] += slot.failures[j];
+    }
+    totals.allocations += slot.allocations;
+    totals.heap_blocks += slot.heap_blocks;
+    for(unsigned int j = 0; j <= output_phase; j++){
+      totals.seconds[j] += slot.seconds[j];
+    }
+  }
+
+  if(history.size() == history_size){
+    history.erase(history.begin());
+  }
+  history.push_back(record);
+}
+
+//' @title Instrumentation for WKT Functions
+//' @description With `options(wellknown.stats = TRUE)` set, calls to
+//' [validate_wkt()], [wkt_correct()], [wkt_reverse()], [wkt_simplify()],
+//' [wkt_round()], [wkt_snap()], [wkt_bounding()], [wkt_centroid()],
+//' [wkt_area()] and [wkt_length()] record what they did and where their
+//' time went.
+//' `wellknown_stats` returns those records. With the option unset (the
+//' default), nothing is recorded, and the functions do no timing at all.
+//' @export
+//' @param reset whether to clear the records once they've been returned.
+//' Set to `FALSE` by default.
+//' @return a data.frame with one row per call, oldest first (only the most
+//' recent 1,000 are kept), and columns:
+//' \itemize{
+//'  \item{`kernel`: the function called}
+//'  \item{`nthreads`: the number of threads it used}
+//'  \item{`rows`, `missing`, `bytes`: the number of objects, how many
+//'  of those were `NA`, and the size of the WKT (or WKB) read. Objects read
+//'  from a [wkt_parse()] store count as zero bytes.}
+//'  \item{`failed_point`, `failed_multipoint`, ... `failed_unknown`: the
+//'  number of objects of each type that could not be parsed, and (as
+//'  unknown) those whose type could not be recognised}
+//'  \item{`allocations`, `heap_blocks`: the number of allocations made for
+//'  the `boost::geometry` objects built, and the number of those that needed
+//'  new memory from the heap rather than reusing memory from earlier rows}
+//'  \item{`dispatch_time`, `parse_time`, `compute_time`, `output_time`:
+//'  seconds spent identifying object types, parsing, computing results
+//'  and building the output, summed across threads. Kernels that compute
+//'  as they parse ([wkt_bounding()], [wkt_centroid()], [wkt_area()] and
+//'  [wkt_length()]) charge both to parsing.}
+//'  \item{`total_time`: the elapsed time of the call, in seconds}
+//' }
+//' @details Timing each row has a cost of its own, so calls are somewhat
+//' slower with the option set; the split between phases is more useful
+//' than the totals.
+//' @examples
+//' options(wellknown.stats = TRUE)
+//' x <- validate_wkt(c("POLYGON ((30 10, 40 40, 20 40, 10 20, 30 10))",
+//'   "POINT (1 foo)"))
+//' wellknown_stats(reset = TRUE)
+//' options(wellknown.stats = NULL)
+// [[Rcpp::export]]
+List wellknown_stats(bool reset = false){
+
+  static const char* failure_names[] = {
+    "failed_point", "failed_multipoint", "failed_linestring", "failed_multilinestring",
+    "failed_polygon", "failed_geometrycollection", "failed_multipolygon"
+  };
+  static const char* phase_names[] = {
+    "dispatch_time", "parse_time", "compute_time", "output_time"
+  };
+
+  unsigned int calls = history.size();
+  CharacterVector kernel(calls);
+  IntegerVector nthreads(calls);
+  NumericVector rows(calls);
+  NumericVector missing(calls);
+  NumericVector bytes(calls);
+  std::vector < NumericVector > failures;
+  for(unsigned int j = 0; j < unsupported_type; j++){
+    failures.push_back(NumericVector(calls));
+  }
+  NumericVector allocations(calls);
+  NumericVector heap_blocks(calls);
+  std::vector < NumericVector > phases;
+  for(unsigned int j = 0; j <= output_phase; j++){
+    phases.push_back(NumericVector(calls));
+  }
+  NumericVector total(calls);
+
+  for(unsigned int i = 0; i < calls; i++){
+    const call_record& record = history[i];
+    const thread_stats& totals = record.totals;
+    kernel[i] = record.kernel;
+    nthreads[i] = record.nthreads;
+    rows[i] = totals.rows;
+    missing[i] = totals.missing;
+    bytes[i] = totals.bytes;
+    for(unsigned int j = point; j < unsupported_type; j++){
+      failures[j - 1][i] = totals.failures[j];
+    }
+    failures[unsupported_type - 1][i] = totals.failures[0] + totals.failures[unsupported_type];
+    allocations[i] = totals.allocations;
+    heap_blocks[i] = totals.heap_blocks;
+    for(unsigned int j = 0; j <= output_phase; j++){
+      phases[j][i] = totals.seconds[j];
+    }
+    total[i] = record.seconds;
+  }
+  if(reset){
+    history.clear();
+  }
+
+  List output;
+  output["kernel"] = kernel;
+  output["nthreads"] = nthreads;
+  output["rows"] = rows;
+  output["missing"] = missing;
+  output["bytes"] = bytes;
+  for(unsigned int j = 0; j < unsupported_type - 1; j++){
+    output[failure_names[j]] = failures[j];
+  }
+  output["failed_unknown"] = failures[unsupported_type - 1];
+  output["allocations"] = allocations;
+  output["heap_blocks"] = heap_blocks;
+  for(unsigned int j = 0; j <= output_phase; j++){
+    output[phase_names[j]] = phases[j];
+  }
+  output["total_time"] = total;
+
+  output.attr("class") = "data.frame";
+  output.attr("row.names") = IntegerVector::create(NA_INTEGER, -static_cast<int>(calls));
+  return output;
+}
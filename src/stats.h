@@ -0,0 +1,168 @@
+#include <Rcpp.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "arena.h"
+#include "reader.h"
+
+#ifndef __WKT_STATS__
+#define __WKT_STATS__
+namespace wkt_utils {
+
+  enum stats_phase { dispatch_phase, parse_phase, compute_phase, output_phase };
+
+  /**
+   * What one thread has counted over one call. Each thread has a slot of its
+   * own, padded so that neighbouring slots don't share a cache line.
+   */
+  struct thread_stats {
+    unsigned long long rows;
+    unsigned long long missing;
+    unsigned long long bytes;
+    // Indexed by supported_types; 0 and unsupported_type are both unknown
+    unsigned long long failures[unsupported_type + 1];
+    unsigned long long allocations;
+    unsigned long long heap_blocks;
+    double seconds[output_phase + 1];
+    char padding[64];
+
+    thread_stats() : rows(0), missing(0), bytes(0), allocations(0), heap_blocks(0) {
+      for(unsigned int i = 0; i <= unsupported_type; i++){
+        failures[i] = 0;
+      }
+      for(unsigned int i = 0; i <= output_phase; i++){
+        seconds[i] = 0;
+      }
+    }
+  };
+
+  /**
+   * The statistics for one call to a kernel, if the wellknown.stats option
+   * is set when it starts. When it isn't, local() is NULL and nothing else
+   * is done, so that a kernel pays for one test per row. finish() merges
+   * the threads' slots into the session's history, for wellknown_stats().
+   */
+  class call_stats {
+
+  public:
+
+    /**
+     * @param kernel the name of the R function
+     *
+     * @param nthreads the number of threads the kernel will use
+     */
+    call_stats(const char* kernel, int nthreads);
+
+    /**
+     * A function for getting the calling thread's slot
+     *
+     * @return a pointer to the slot, or NULL if statistics are off
+     */
+    inline thread_stats* local(){
+      if(!enabled){
+        return NULL;
+      }
+#ifdef _OPENMP
+      return &slots[omp_get_thread_num()];
+#else
+      return &slots[0];
+#endif
+    }
+
+    /**
+     * A function for recording the call. Must be called on the main thread,
+     * once the output has been built.
+     */
+    void finish();
+
+  private:
+    bool enabled;
+    std::string kernel;
+    int nthreads;
+    std::vector < thread_stats > slots;
+    std::chrono::steady_clock::time_point started;
+  };
+
+  /**
+   * Counts one row into a thread's slot - if there is one - and times the
+   * phases of its processing: each call to lap() charges the time since the
+   * last to a phase. Arena allocations made while it is in scope are
+   * counted too.
+   */
+  class row_stats {
+
+  public:
+
+    row_stats(thread_stats* local) : local(local) {
+      if(local){
+        start();
+      }
+    }
+
+    ~row_stats(){
+      if(local){
+        const arena& a = thread_arena();
+        local->allocations += a.allocations() - allocations;
+        local->heap_blocks += a.heap_blocks() - heap_blocks;
+      }
+    }
+
+    /**
+     * A function for counting the row, and the bytes it was read from
+     *
+     * @param bytes the size of the row's WKT or WKB; -1 if it is NA
+     */
+    inline void row(R_xlen_t bytes){
+      if(local){
+        local->rows++;
+        if(bytes < 0){
+          local->missing++;
+        } else {
+          local->bytes += bytes;
+        }
+      }
+    }
+
+    inline void lap(stats_phase phase){
+      if(local){
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        local->seconds[phase] += std::chrono::duration<double>(now - last).count();
+        last = now;
+      }
+    }
+
+    /**
+     * A function for counting a row that couldn't be parsed, by its type
+     *
+     * @param x the input the row came from; a wkt_input
+     *
+     * @param i the row
+     */
+    template <typename Input>
+    inline void failed(const Input& x, unsigned int i){
+      if(local){
+        local->failures[x.type(i)]++;
+      }
+    }
+
+  private:
+    thread_stats* local;
+    std::chrono::steady_clock::time_point last;
+    size_t allocations;
+    size_t heap_blocks;
+
+    void start(){
+      const arena& a = thread_arena();
+      allocations = a.allocations();
+      heap_blocks = a.heap_blocks();
+      last = std::chrono::steady_clock::now();
+    }
+
+    row_stats(const row_stats&);
+    row_stats& operator=(const row_stats&);
+  };
+}
+#endif
@@ -0,0 +1,790 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "reader.h"
+
+#ifndef __WKT_STREAMING__
+#define __WKT_STREAMING__
+namespace wkt_utils {
+
+  /**
+   * A running bounding box over x and y. Starts out "inverted" so that the
+   * first coordinate folded in sets both corners.
+   */
+  struct bounds {
+    double min_x;
+    double min_y;
+    double max_x;
+    double max_y;
+
+    bounds(){
+      reset();
+    }
+
+    inline void reset(){
+      min_x = std::numeric_limits<double>::infinity();
+      min_y = std::numeric_limits<double>::infinity();
+      max_x = -std::numeric_limits<double>::infinity();
+      max_y = -std::numeric_limits<double>::infinity();
+    }
+
+    inline bool is_empty() const {
+      return min_x > max_x;
+    }
+
+    inline void add(double x, double y){
+      if(x < min_x) min_x = x;
+      if(x > max_x) max_x = x;
+      if(y < min_y) min_y = y;
+      if(y > max_y) max_y = y;
+    }
+
+    inline void add(const bounds& other){
+      if(!other.is_empty()){
+        add(other.min_x, other.min_y);
+        add(other.max_x, other.max_y);
+      }
+    }
+  };
+
+  /**
+   * A handler that folds a WKT object into its bounding box as it is read,
+   * without storing any coordinates. Follows boost::geometry::envelope: a
+   * polygon's box comes from its exterior ring, unless that is empty, in which
+   * case the interior rings are used. A GeometryCollection's box covers those
+   * of its members.
+   */
+  struct envelope_handler : wkt_handler {
+
+    static const bool collections = true;
+
+    bounds box;
+    bounds exterior;
+    bounds interiors;
+    bool areal;
+    unsigned int ring;
+    unsigned int depth;
+
+    envelope_handler() : areal(false), ring(0), depth(0) {}
+
+    inline void begin_geometry(const wkt_header& header){
+      if(depth++ == 0){
+        box.reset();
+      }
+      areal = (header.type == polygon || header.type == multi_polygon);
+      if(areal){
+        exterior.reset();
+        interiors.reset();
+      }
+    }
+
+    inline void end_geometry(){
+      end_part();
+      areal = false;
+      depth--;
+    }
+
+    inline void end_part(){
+      if(areal){
+        box.add(exterior.is_empty() ? interiors : exterior);
+        exterior.reset();
+        interiors.reset();
+      }
+    }
+
+    inline void begin_ring(unsigned int i){
+      ring = i;
+    }
+
+    inline void coord(const coordinate& c){
+      if(!areal){
+        box.add(c.x, c.y);
+      } else if(ring == 0){
+        exterior.add(c.x, c.y);
+      } else {
+        interiors.add(c.x, c.y);
+      }
+    }
+  };
+
+  /**
+   * A running range over one value (z or m). NaN - the value of a missing
+   * z or m - fails both comparisons, so is never folded in.
+   */
+  struct value_range {
+    double min;
+    double max;
+
+    value_range(){
+      reset();
+    }
+
+    inline void reset(){
+      min = std::numeric_limits<double>::infinity();
+      max = -std::numeric_limits<double>::infinity();
+    }
+
+    inline bool is_empty() const {
+      return min > max;
+    }
+
+    inline void add(double x){
+      if(x < min) min = x;
+      if(x > max) max = x;
+    }
+  };
+
+  /**
+   * An envelope_handler that also tracks the range of any z and m values.
+   * Unlike x and y, these are taken from every ring of a polygon. Kept apart
+   * from envelope_handler so that 2D bounding doesn't pay for them.
+   */
+  struct zm_envelope_handler : envelope_handler {
+
+    value_range z;
+    value_range m;
+
+    inline void begin_geometry(const wkt_header& header){
+      if(depth == 0){
+        z.reset();
+        m.reset();
+      }
+      envelope_handler::begin_geometry(header);
+    }
+
+    inline void coord(const coordinate& c){
+      envelope_handler::coord(c);
+      z.add(c.z);
+      m.add(c.m);
+    }
+  };
+
+  /**
+   * A handler that checks, as a polygon or multipolygon is read, whether its
+   * rings wind the way polygon_type expects - exterior rings clockwise,
+   * interior rings anticlockwise - from the sign of each ring's shoelace sum
+   * (with coordinates taken relative to the ring's first point). Rings whose
+   * sum is too close to zero to call, empty ones included, count as wrongly
+   * oriented, so that a caller falls back to boost::geometry for them. In a
+   * GeometryCollection, the rings of every areal member are checked.
+   */
+  struct orientation_handler : wkt_handler {
+
+    static const bool collections = true;
+
+    bool oriented;
+    bool areal;
+    unsigned int depth;
+    unsigned int ring;
+    unsigned long ring_size;
+    coordinate first;
+    double previous_x;
+    double previous_y;
+    double sum;
+    double magnitude;
+
+    orientation_handler() : oriented(true), areal(false), depth(0) {}
+
+    inline void begin_geometry(const wkt_header& header){
+      if(depth++ == 0){
+        oriented = true;
+      }
+      areal = (header.type == polygon || header.type == multi_polygon);
+    }
+
+    inline void end_geometry(){
+      depth--;
+    }
+
+    inline void begin_ring(unsigned int i){
+      ring = i;
+      ring_size = 0;
+      sum = 0;
+      magnitude = 0;
+    }
+
+    inline void end_ring(){
+      if(!areal){
+        return;
+      }
+      bool clear = std::fabs(sum) > magnitude * 1e-10;
+      if(!clear || (ring == 0 ? sum > 0 : sum < 0)){
+        oriented = false;
+      }
+    }
+
+    inline void coord(const coordinate& c){
+      if(!areal){
+        return;
+      }
+      if(ring_size == 0){
+        first = c;
+      }
+      double x = c.x - first.x;
+      double y = c.y - first.y;
+      if(ring_size){
+        double a = previous_x * y;
+        double b = previous_y * x;
+        sum += a - b;
+        magnitude += std::fabs(a) + std::fabs(b);
+      }
+      previous_x = x;
+      previous_y = y;
+      ring_size++;
+    }
+  };
+
+  /**
+   * A handler that makes, as an object is read, the checks that
+   * boost::geometry::is_valid makes of each of its rings and linestrings
+   * alone - the cheap ones - in the order it makes them: for invalid (NaN or
+   * infinite) coordinates, too few points, too few distinct points, rings
+   * that aren't closed, spikes in rings and rings that wind the wrong way.
+   * What it can't see without the whole object - self-intersections and how
+   * rings nest - is left alone, so an object it passes may still be invalid.
+   * Empty multi- types are valid, as boost::geometry has it, but an empty
+   * polygon or linestring has too few points. In a GeometryCollection, every
+   * member is checked, and failure is the first that fails.
+   */
+  struct structure_handler : wkt_handler {
+
+    static const bool collections = true;
+
+    boost::geometry::validity_failure_type failure;
+    // The number of parts (or members) of the outermost object
+    unsigned int parts;
+    std::vector < supported_types > open;
+    unsigned int rings;
+    unsigned int ring;
+    unsigned long ring_size;
+    unsigned long distinct;
+    bool invalid_coordinate;
+    bool spike;
+    coordinate first;
+    coordinate second;
+    coordinate previous;
+    coordinate last;
+    double sum;
+
+    structure_handler() : failure(boost::geometry::no_failure), parts(0) {}
+
+    inline bool valid() const {
+      return failure == boost::geometry::no_failure;
+    }
+
+    inline void fail(boost::geometry::validity_failure_type x){
+      if(valid()){
+        failure = x;
+      }
+    }
+
+    inline void begin_geometry(const wkt_header& header){
+      if(open.empty()){
+        failure = boost::geometry::no_failure;
+        parts = 0;
+      }
+      open.push_back(header.type);
+      rings = 0;
+    }
+
+    inline void end_geometry(){
+      supported_types type = open.back();
+      if((type == polygon || type == line_string) && rings == 0){
+        fail(boost::geometry::failure_few_points);
+      }
+      open.pop_back();
+    }
+
+    inline void begin_part(unsigned int){
+      if(open.size() == 1){
+        parts++;
+      }
+      rings = 0;
+    }
+
+    inline void end_part(){
+      if(open.back() == multi_polygon && rings == 0){
+        fail(boost::geometry::failure_few_points);
+      }
+    }
+
+    inline void begin_ring(unsigned int i){
+      rings++;
+      ring = i;
+      ring_size = 0;
+      distinct = 0;
+      invalid_coordinate = false;
+      spike = false;
+      sum = 0;
+    }
+
+    // Whether b is the tip of a spike, going from a to b and back towards a
+    static inline bool is_spike(const coordinate& a, const coordinate& b, const coordinate& c){
+      double side = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+      return side == 0 && (b.x - a.x) * (c.x - b.x) + (b.y - a.y) * (c.y - b.y) < 0;
+    }
+
+    inline void end_ring(){
+      if(!valid()){
+        return;
+      }
+      if(invalid_coordinate){
+        fail(boost::geometry::failure_invalid_coordinate);
+        return;
+      }
+      if(open.back() == line_string || open.back() == multi_line_string){
+        // Spikes are allowed in linestrings
+        if(ring_size < 2){
+          fail(boost::geometry::failure_few_points);
+        } else if(distinct < 2){
+          fail(boost::geometry::failure_wrong_topological_dimension);
+        }
+        return;
+      }
+      if(ring_size < 4){
+        fail(boost::geometry::failure_few_points);
+        return;
+      }
+      if(distinct < 4){
+        fail(boost::geometry::failure_wrong_topological_dimension);
+      } else if(first.x != last.x || first.y != last.y){
+        fail(boost::geometry::failure_not_closed);
+      } else if(spike || is_spike(previous, last, second)){
+        fail(boost::geometry::failure_spikes);
+      } else if(ring == 0 ? sum >= 0 : sum <= 0){
+        fail(boost::geometry::failure_wrong_orientation);
+      }
+    }
+
+    inline void coord(const coordinate& c){
+      if(!valid()){
+        return;
+      }
+      bool finite = std::isfinite(c.x) && std::isfinite(c.y);
+      if(open.back() == point || open.back() == multi_point){
+        if(!finite){
+          fail(boost::geometry::failure_invalid_coordinate);
+        }
+        return;
+      }
+      if(!finite){
+        invalid_coordinate = true;
+      }
+      if(ring_size++ == 0){
+        first = c;
+        last = c;
+        distinct = 1;
+        return;
+      }
+      if(duplicate_points(c, last)){
+        return;
+      }
+      if(++distinct == 2){
+        second = c;
+      } else if(is_spike(previous, last, c)){
+        spike = true;
+      }
+      sum += (last.x - first.x) * (c.y - first.y) - (last.y - first.y) * (c.x - first.x);
+      previous = last;
+      last = c;
+    }
+  };
+
+  /**
+   * A handler that computes the centroid of a WKT object as it is read,
+   * without storing any coordinates. Mirrors the cartesian strategies that
+   * boost::geometry::centroid uses: the mean of the points for (multi)points,
+   * the length-weighted mean of the segment midpoints for (multi)linestrings
+   * and Bashein-Detmer area sums for (multi)polygons (with coordinates taken
+   * relative to the first point, for precision). Where the weights sum to zero
+   * the first point is used instead, and empty objects have no centroid.
+   *
+   * A GeometryCollection's centroid is that of its members of the highest
+   * dimension with any weight - areas, then lines, then points - taken
+   * together, as GEOS does.
+   */
+  struct centroid_handler : wkt_handler {
+
+    static const bool collections = true;
+
+    supported_types root;
+    supported_types type;
+    unsigned int depth;
+    unsigned long count;
+    unsigned long ring_size;
+    unsigned long exterior_size;
+    bool first_ring;
+    coordinate first;
+    coordinate previous;
+
+    // Sums for each strategy. Only one set is in use for anything but a
+    // GeometryCollection.
+    double point_x;
+    double point_y;
+    unsigned long points;
+    double line_x;
+    double line_y;
+    double length;
+    double area_x;
+    double area_y;
+    double area;
+
+    centroid_handler() : depth(0) {}
+
+    inline void begin_geometry(const wkt_header& header){
+      type = header.type;
+      if(depth++ > 0){
+        return;
+      }
+      root = header.type;
+      count = 0;
+      ring_size = 0;
+      exterior_size = 0;
+      first_ring = true;
+      point_x = 0;
+      point_y = 0;
+      points = 0;
+      line_x = 0;
+      line_y = 0;
+      length = 0;
+      area_x = 0;
+      area_y = 0;
+      area = 0;
+    }
+
+    inline void end_geometry(){
+      depth--;
+    }
+
+    inline void begin_ring(unsigned int){
+      ring_size = 0;
+    }
+
+    inline void end_ring(){
+      if(first_ring){
+        exterior_size = ring_size;
+        first_ring = false;
+      }
+    }
+
+    inline void coord(const coordinate& c){
+      if(count == 0){
+        first = c;
+      }
+      count++;
+
+      switch(type){
+      case point:
+      case multi_point:
+        point_x += c.x;
+        point_y += c.y;
+        points++;
+        return;
+      case line_string:
+      case multi_line_string:
+        if(ring_size){
+          double d = std::sqrt(((c.x - previous.x) * (c.x - previous.x)) +
+                               ((c.y - previous.y) * (c.y - previous.y)));
+          length += d;
+          line_x += (previous.x + c.x) * (d / 2);
+          line_y += (previous.y + c.y) * (d / 2);
+        }
+        previous = c;
+        break;
+      default: {
+        double x = c.x - first.x;
+        double y = c.y - first.y;
+        if(ring_size){
+          double a = (previous.x * y) - (previous.y * x);
+          area += a;
+          area_x += a * (previous.x + x);
+          area_y += a * (previous.y + y);
+        }
+        previous.x = x;
+        previous.y = y;
+      }
+      }
+      ring_size++;
+    }
+
+    /**
+     * A function for retrieving the centroid once the object has been read
+     *
+     * @param x a reference to a double to write the x value into
+     *
+     * @param y a reference to a double to write the y value into
+     *
+     * @return whether the object had a centroid
+     */
+    inline bool result(double& x, double& y) const {
+      if(count == 0 || (root == polygon && exterior_size == 0)){
+        return false;
+      }
+      x = first.x;
+      y = first.y;
+
+      switch(root){
+      case point:
+      case multi_point:
+        set_points(x, y);
+        break;
+      case line_string:
+      case multi_line_string:
+        if(!(root == line_string && count == 1)){
+          set_lines(x, y);
+        }
+        break;
+      case geometry_collection:
+        if(!set_areas(x, y) && !set_lines(x, y)){
+          set_points(x, y);
+        }
+        break;
+      default:
+        if(!(root == polygon && exterior_size == 1)){
+          set_areas(x, y);
+        }
+      }
+      return true;
+    }
+
+  private:
+
+    inline bool set_points(double& x, double& y) const {
+      if(points == 0){
+        return false;
+      }
+      x = point_x / points;
+      y = point_y / points;
+      return true;
+    }
+
+    inline bool set_lines(double& x, double& y) const {
+      if(boost::geometry::math::equals(length, 0.0) || !boost::math::isfinite(length)){
+        return false;
+      }
+      x = line_x / length;
+      y = line_y / length;
+      return true;
+    }
+
+    inline bool set_areas(double& x, double& y) const {
+      if(boost::geometry::math::equals(area, 0.0) || !boost::math::isfinite(3 * area)){
+        return false;
+      }
+      x = (area_x / (3 * area)) + first.x;
+      y = (area_y / (3 * area)) + first.y;
+      return true;
+    }
+  };
+
+  /**
+   * A point, or a sum of points, in three dimensions, for working on the
+   * unit sphere
+   */
+  struct vector3 {
+    double x;
+    double y;
+    double z;
+
+    vector3() : x(0), y(0), z(0) {}
+    vector3(double x, double y, double z) : x(x), y(y), z(z) {}
+
+    /**
+     * A function for getting the point on the unit sphere at a longitude
+     * and latitude, in degrees
+     *
+     * @param squash the ratio of the tangents of the latitude on the sphere
+     * and the one given: 1 for a latitude on the sphere, and 1 - e^2 for a
+     * geodetic one on an ellipsoid of eccentricity e, whose point has the
+     * same direction from the centre
+     */
+    static inline vector3 from_degrees(double lng, double lat, double squash = 1){
+      double lambda = lng * M_PI / 180;
+      double phi = lat * M_PI / 180;
+      if(squash != 1){
+        phi = std::atan2(squash * std::sin(phi), std::cos(phi));
+      }
+      return vector3(std::cos(phi) * std::cos(lambda), std::cos(phi) * std::sin(lambda), std::sin(phi));
+    }
+
+    inline void add(const vector3& v, double weight){
+      x += v.x * weight;
+      y += v.y * weight;
+      z += v.z * weight;
+    }
+
+    inline double dot(const vector3& v) const {
+      return x * v.x + y * v.y + z * v.z;
+    }
+
+    inline vector3 cross(const vector3& v) const {
+      return vector3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x);
+    }
+
+    inline double norm() const {
+      return std::sqrt(dot(*this));
+    }
+  };
+
+  /**
+   * A handler that computes the centroid of a WKT object of longitudes and
+   * latitudes, in degrees, on the sphere, as it is read: the direction of
+   * the mean position (in three dimensions) of its points, of its great
+   * circle edges weighted by length, or of its area, which is found edge
+   * by edge, from the integral of position over a spherical polygon being
+   * half the sum of each edge's angle times the normal to its great circle.
+   * So it's right across the antimeridian and around the poles, as the
+   * planar centroid isn't. Each ring is taken to enclose the smaller of the
+   * two areas it splits the sphere into, whichever way it winds.
+   *
+   * As with centroid_handler, a GeometryCollection's centroid is that of its
+   * members of the highest dimension with any weight, and the first point
+   * is used where there is no weight at all.
+   *
+   * For the WGS84 ellipsoid, geodetic latitudes are turned into geocentric
+   * ones on the way in, and back on the way out, and the rest is done on
+   * the sphere; the difference in weighting is well under a percent.
+   */
+  struct spherical_centroid_handler : wkt_handler {
+
+    static const bool collections = true;
+
+    supported_types type;
+    unsigned int depth;
+    unsigned long count;
+    unsigned int ring;
+    unsigned long ring_size;
+    vector3 first;
+    vector3 ring_first;
+    vector3 previous;
+    // A ring's area integral, and the sum of its points, for telling which
+    // side of it is the inside
+    vector3 ring_area;
+    vector3 ring_points;
+
+    vector3 point_sum;
+    unsigned long points;
+    vector3 line_sum;
+    double length;
+    vector3 area_sum;
+    double squash;
+
+    /**
+     * @param ellipsoidal whether the latitudes are geodetic ones on the WGS84
+     * ellipsoid, rather than on a sphere
+     */
+    spherical_centroid_handler(bool ellipsoidal = false)
+      : depth(0), squash(ellipsoidal ? 1 - 0.00669437999014 : 1) {}
+
+    inline void begin_geometry(const wkt_header& header){
+      type = header.type;
+      if(depth++ > 0){
+        return;
+      }
+      count = 0;
+      point_sum = vector3();
+      points = 0;
+      line_sum = vector3();
+      length = 0;
+      area_sum = vector3();
+    }
+
+    inline void end_geometry(){
+      depth--;
+    }
+
+    inline void begin_ring(unsigned int i){
+      ring = i;
+      ring_size = 0;
+      ring_area = vector3();
+      ring_points = vector3();
+    }
+
+    inline void end_ring(){
+      if((type != polygon && type != multi_polygon) || ring_size == 0){
+        return;
+      }
+      // Close the ring, if it wasn't
+      edge(previous, ring_first);
+      double side = ring_area.dot(ring_points);
+      if(side != 0){
+        area_sum.add(ring_area, (side > 0) == (ring == 0) ? 1 : -1);
+      }
+    }
+
+    inline void coord(const coordinate& c){
+      vector3 v = vector3::from_degrees(c.x, c.y, squash);
+      if(count++ == 0){
+        first = v;
+      }
+
+      switch(type){
+      case point:
+      case multi_point:
+        point_sum.add(v, 1);
+        points++;
+        return;
+      case line_string:
+      case multi_line_string:
+        if(ring_size){
+          // The integral of position along a great circle arc from a to b
+          // is tan(angle / 2) (a + b)
+          double angle = std::atan2(previous.cross(v).norm(), previous.dot(v));
+          length += angle;
+          line_sum.add(previous, std::tan(angle / 2));
+          line_sum.add(v, std::tan(angle / 2));
+        }
+        break;
+      default:
+        if(ring_size){
+          edge(previous, v);
+        } else {
+          ring_first = v;
+        }
+        ring_points.add(v, 1);
+      }
+      previous = v;
+      ring_size++;
+    }
+
+    /**
+     * A function for retrieving the centroid once the object has been read
+     *
+     * @param x a reference to a double to write the longitude into
+     *
+     * @param y a reference to a double to write the latitude into
+     *
+     * @return whether the object had a centroid
+     */
+    inline bool result(double& x, double& y) const {
+      if(count == 0){
+        return false;
+      }
+      vector3 v = first;
+      if(area_sum.norm() > 1e-14){
+        v = area_sum;
+      } else if(length > 0){
+        v = line_sum;
+      } else if(points > 0){
+        v = point_sum;
+      }
+      if(!(v.norm() > 0) || !boost::math::isfinite(v.norm())){
+        v = first;
+      }
+      x = std::atan2(v.y, v.x) * 180 / M_PI;
+      y = std::atan2(v.z, squash * std::sqrt(v.x * v.x + v.y * v.y)) * 180 / M_PI;
+      return true;
+    }
+
+  private:
+
+    inline void edge(const vector3& a, const vector3& b){
+      vector3 normal = a.cross(b);
+      double sine = normal.norm();
+      if(sine > 0){
+        ring_area.add(normal, std::atan2(sine, a.dot(b)) / (2 * sine));
+      }
+    }
+  };
+}
+#endif
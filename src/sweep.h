@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "def.h"
+
+#ifndef __WKT_SWEEP__
+#define __WKT_SWEEP__
+namespace wkt_utils {
+
+  /**
+   * A quick proof that a polygon or multipolygon is valid, for large ones,
+   * where boost::geometry::is_valid spends most of its time looking for
+   * self-intersections. The edges of every ring are swept left to right,
+   * each tested only against those whose x ranges it overlaps, and if no
+   * two edges (other than neighbours sharing a vertex) meet at all, then
+   * the rings are simple and disjoint, and what is left to check - closure,
+   * orientation, spikes, and how the rings nest - is cheap.
+   *
+   * It never says an object is invalid: anything it can't settle - rings
+   * that touch or cross, edges too nearly collinear to call, or any other
+   * fault - is left to boost::geometry, which gives the same answer, with
+   * the reason, as it always has.
+   */
+  class sweep_check {
+
+  public:
+
+    bool proves_valid(const polygon_type& poly){
+      clear();
+      return add_polygon(poly) && sweep() && rings_nest();
+    }
+
+    bool proves_valid(const multipolygon_type& multi){
+      clear();
+      for(unsigned int i = 0; i < multi.size(); i++){
+        if(!add_polygon(multi[i])){
+          return false;
+        }
+      }
+      return sweep() && rings_nest();
+    }
+
+  private:
+
+    struct ring_info {
+      unsigned int polygon;
+      bool exterior;
+      size_t first;
+      size_t size;
+      double min_x, min_y, max_x, max_y;
+    };
+
+    struct edge {
+      double min_x, max_x, min_y, max_y;
+      point_type a, b;
+      unsigned int ring;
+      size_t index;
+    };
+
+    std::vector < point_type > points;
+    std::vector < ring_info > rings;
+    std::vector < edge > edges;
+    std::vector < edge > active;
+    unsigned int polygons;
+
+    inline void clear(){
+      points.clear();
+      rings.clear();
+      edges.clear();
+      polygons = 0;
+    }
+
+    static inline double x(const point_type& p){
+      return boost::geometry::get<0>(p);
+    }
+
+    static inline double y(const point_type& p){
+      return boost::geometry::get<1>(p);
+    }
+
+    /**
+     * A function for finding which side of the line through a and b the
+     * point c is on
+     *
+     * @return 1 for the left, -1 for the right, and 0 if it's too close to
+     * the line to say
+     */
+    static inline int side(const point_type& a, const point_type& b, const point_type& c){
+      double l = (x(b) - x(a)) * (y(c) - y(a));
+      double r = (y(b) - y(a)) * (x(c) - x(a));
+      double det = l - r;
+      double bound = (std::fabs(l) + std::fabs(r)) * 1e-12;
+      return det > bound ? 1 : (det < -bound ? -1 : 0);
+    }
+
+    bool add_polygon(const polygon_type& poly){
+      if(!add_ring(poly.outer(), polygons, true)){
+        return false;
+      }
+      for(unsigned int i = 0; i < poly.inners().size(); i++){
+        if(!add_ring(poly.inners()[i], polygons, false)){
+          return false;
+        }
+      }
+      polygons++;
+      return true;
+    }
+
+    /**
+     * A function for taking in a ring, checking what can be checked of it
+     * alone: that it's closed, has at least three distinct vertices, finite
+     * coordinates, no repeated vertices and no spikes, and winds the right
+     * way - clockwise if exterior and anticlockwise if not
+     */
+    template <typename Ring>
+    bool add_ring(const Ring& ring, unsigned int polygon, bool exterior){
+      size_t n = ring.size();
+      if(n < 4 || x(ring[0]) != x(ring[n - 1]) || y(ring[0]) != y(ring[n - 1])){
+        return false;
+      }
+      ring_info info = {polygon, exterior, points.size(), n - 1,
+                        x(ring[0]), y(ring[0]), x(ring[0]), y(ring[0])};
+      double sum = 0, magnitude = 0;
+      for(size_t i = 0; i < n - 1; i++){
+        const point_type& p = ring[i];
+        const point_type& q = ring[i + 1];
+        if(!std::isfinite(x(p)) || !std::isfinite(y(p)) ||
+           (x(p) == x(q) && y(p) == y(q))){
+          return false;
+        }
+        // Two edges meeting head on - or too nearly in line to be sure they
+        // don't - is a spike, or something boost may call one
+        const point_type& before = ring[i == 0 ? n - 2 : i - 1];
+        if(side(before, p, q) == 0 &&
+           (x(p) - x(before)) * (x(q) - x(p)) + (y(p) - y(before)) * (y(q) - y(p)) <= 0){
+          return false;
+        }
+        double a = (x(p) - x(ring[0])) * (y(q) - y(ring[0]));
+        double b = (y(p) - y(ring[0])) * (x(q) - x(ring[0]));
+        sum += a - b;
+        magnitude += std::fabs(a) + std::fabs(b);
+        info.min_x = std::min(info.min_x, x(p));
+        info.min_y = std::min(info.min_y, y(p));
+        info.max_x = std::max(info.max_x, x(p));
+        info.max_y = std::max(info.max_y, y(p));
+        points.push_back(p);
+      }
+      if(std::fabs(sum) <= magnitude * 1e-10 || (exterior ? sum > 0 : sum < 0)){
+        return false;
+      }
+
+      unsigned int id = rings.size();
+      rings.push_back(info);
+      for(size_t i = 0; i < info.size; i++){
+        const point_type& p = points[info.first + i];
+        const point_type& q = points[info.first + (i + 1) % info.size];
+        edge e = {std::min(x(p), x(q)), std::max(x(p), x(q)),
+                  std::min(y(p), y(q)), std::max(y(p), y(q)), p, q, id, i};
+        edges.push_back(e);
+      }
+      return true;
+    }
+
+    /**
+     * A function for checking whether two edges can be shown not to meet
+     */
+    bool apart(const edge& e, const edge& f) const {
+      if(e.max_y < f.min_y || f.max_y < e.min_y){
+        return true;
+      }
+      if(e.ring == f.ring){
+        size_t size = rings[e.ring].size;
+        size_t gap = e.index > f.index ? e.index - f.index : f.index - e.index;
+        // Neighbours share a vertex, and were checked for overlapping when
+        // the ring was taken in
+        if(gap == 1 || gap == size - 1){
+          return true;
+        }
+      }
+      const point_type& a = e.a;
+      const point_type& b = e.b;
+      const point_type& c = f.a;
+      const point_type& d = f.b;
+      int c_side = side(a, b, c);
+      int d_side = side(a, b, d);
+      if(c_side != 0 && c_side == d_side){
+        return true;
+      }
+      int a_side = side(c, d, a);
+      int b_side = side(c, d, b);
+      return a_side != 0 && a_side == b_side;
+    }
+
+    static inline bool by_min_x(const edge& a, const edge& b){
+      return a.min_x < b.min_x;
+    }
+
+    /**
+     * A function for checking that no two edges meet, save neighbours
+     */
+    bool sweep(){
+      std::sort(edges.begin(), edges.end(), by_min_x);
+      active.clear();
+      for(size_t i = 0; i < edges.size(); i++){
+        const edge& e = edges[i];
+        size_t kept = 0;
+        for(size_t j = 0; j < active.size(); j++){
+          if(active[j].max_x < e.min_x){
+            continue;
+          }
+          if(!apart(active[j], e)){
+            return false;
+          }
+          if(kept != j){
+            active[kept] = active[j];
+          }
+          kept++;
+        }
+        active.resize(kept);
+        active.push_back(e);
+      }
+      return true;
+    }
+
+    /**
+     * A function for checking whether a point is inside a ring, for a point
+     * known not to be on it
+     */
+    bool inside(const point_type& p, const ring_info& r) const {
+      bool in = false;
+      for(size_t i = 0, j = r.size - 1; i < r.size; j = i++){
+        const point_type& a = points[r.first + i];
+        const point_type& b = points[r.first + j];
+        if((y(a) > y(p)) != (y(b) > y(p)) &&
+           x(p) < (x(b) - x(a)) * (y(p) - y(a)) / (y(b) - y(a)) + x(a)){
+          in = !in;
+        }
+      }
+      return in;
+    }
+
+    static inline bool overlap(const ring_info& a, const ring_info& b){
+      return a.min_x <= b.max_x && b.min_x <= a.max_x && a.min_y <= b.max_y && b.min_y <= a.max_y;
+    }
+
+    /**
+     * A function for checking whether one ring sits inside another where
+     * it mustn't: an interior ring inside another of its polygon's interior
+     * rings, or an exterior ring inside another polygon other than in one
+     * of its holes
+     */
+    bool badly_nested(unsigned int i, unsigned int j) const {
+      const ring_info& r = rings[i];
+      const ring_info& s = rings[j];
+      const point_type& p = points[r.first];
+      if(!r.exterior && !s.exterior && r.polygon == s.polygon){
+        return inside(p, s);
+      }
+      if(r.exterior && s.exterior && inside(p, s)){
+        // s's interior rings follow it
+        for(unsigned int k = j + 1; k < rings.size() && !rings[k].exterior; k++){
+          if(overlap(r, rings[k]) && inside(p, rings[k])){
+            return false;
+          }
+        }
+        return true;
+      }
+      return false;
+    }
+
+    static inline bool ring_by_min_x(const std::pair < double, unsigned int >& a,
+                                     const std::pair < double, unsigned int >& b){
+      return a.first < b.first;
+    }
+
+    /**
+     * A function for checking, once the rings are known to be disjoint, that
+     * each interior ring is inside its own exterior ring and no other of its
+     * polygon's interior rings, and that no polygon's exterior ring is inside
+     * another polygon, other than in one of its holes. Only rings whose
+     * boxes overlap can be inside one another, so the boxes are swept too.
+     */
+    bool rings_nest() const {
+      unsigned int exterior = 0;
+      std::vector < std::pair < double, unsigned int > > order(rings.size());
+      for(unsigned int i = 0; i < rings.size(); i++){
+        const ring_info& r = rings[i];
+        if(r.exterior){
+          exterior = i;
+        } else if(!overlap(r, rings[exterior]) || !inside(points[r.first], rings[exterior])){
+          return false;
+        }
+        order[i] = std::make_pair(r.min_x, i);
+      }
+      if(rings.size() == 1){
+        return true;
+      }
+
+      std::sort(order.begin(), order.end(), ring_by_min_x);
+      std::vector < unsigned int > open;
+      for(unsigned int i = 0; i < order.size(); i++){
+        unsigned int r = order[i].second;
+        size_t kept = 0;
+        for(size_t j = 0; j < open.size(); j++){
+          unsigned int s = open[j];
+          if(rings[s].max_x < rings[r].min_x){
+            continue;
+          }
+          if(overlap(rings[r], rings[s]) && (badly_nested(r, s) || badly_nested(s, r))){
+            return false;
+          }
+          open[kept++] = s;
+        }
+        open.resize(kept);
+        open.push_back(r);
+      }
+      return true;
+    }
+  };
+
+  /**
+   * A function for checking an object's validity, as boost::geometry::is_valid
+   * does, but for large polygons and multipolygons, trying sweep_check first
+   *
+   * @param geom the object
+   *
+   * @param failure a reference to where to put the reason it's invalid
+   *
+   * @return whether it's valid
+   */
+  template <typename Geometry>
+  inline bool is_valid(const Geometry& geom, boost::geometry::validity_failure_type& failure){
+    return boost::geometry::is_valid(geom, failure);
+  }
+
+  // Below this many points, boost::geometry is quick enough on its own
+  static const size_t sweep_threshold = 256;
+
+  template <typename Geometry>
+  inline bool sweep_is_valid(const Geometry& geom, boost::geometry::validity_failure_type& failure){
+    if(boost::geometry::num_points(geom) >= sweep_threshold){
+      sweep_check check;
+      if(check.proves_valid(geom)){
+        failure = boost::geometry::no_failure;
+        return true;
+      }
+    }
+    return boost::geometry::is_valid(geom, failure);
+  }
+
+  inline bool is_valid(const polygon_type& geom, boost::geometry::validity_failure_type& failure){
+    return sweep_is_valid(geom, failure);
+  }
+
+  inline bool is_valid(const multipolygon_type& geom, boost::geometry::validity_failure_type& failure){
+    return sweep_is_valid(geom, failure);
+  }
+}
+#endif
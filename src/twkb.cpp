@@ -0,0 +1,111 @@
+#include <Rcpp.h>
+#include <cstring>
+using namespace Rcpp;
+#include "utils.h"
+#include "parallel.h"
+#include "writer.h"
+#include "twkb.h"
+using namespace wkt_utils;
+
+struct twkb_encode_worker {
+
+  const wkt_input& x;
+  translation& output;
+  int precision;
+  int precision_z;
+  int precision_m;
+  bool sizes;
+  bool bbox;
+
+  twkb_encode_worker(const wkt_input& x, translation& output, int precision, int precision_z,
+                     int precision_m, bool sizes, bool bbox)
+    : x(x), output(output), precision(precision), precision_z(precision_z),
+      precision_m(precision_m), sizes(sizes), bbox(bbox) {}
+
+  void operator()(unsigned int i){
+    if(x.is_na(i)){
+      return;
+    }
+    twkb_writer writer(output.values[i], precision, precision_z, precision_m, sizes, bbox);
+    try {
+      x.read(i, writer);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.errors[i] = e.what();
+    }
+  }
+};
+
+struct twkb_decode_worker {
+
+  const wkt_input& x;
+  translation& output;
+
+  twkb_decode_worker(const wkt_input& x, translation& output)
+    : x(x), output(output) {}
+
+  void operator()(unsigned int i){
+    if(x.is_na(i)){
+      return;
+    }
+    // Stored values are written back with the fewest digits that give them
+    wkt_text_writer writer(output.values[i], 0, true);
+    try {
+      read_twkb_geometry(reinterpret_cast<const unsigned char*>(x.get(i)), x.size(i), writer);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.errors[i] = e.what();
+    }
+  }
+};
+
+// [[Rcpp::export]]
+List wkt_twkb_(SEXP x, int precision, int precision_z, int precision_m, bool sizes, bool bbox,
+               SEXP nthreads = R_NilValue){
+
+  if(precision == NA_INTEGER || precision < -7 || precision > 7){
+    Rcpp::stop("'precision' must be a whole number between -7 and 7");
+  }
+  if(precision_z == NA_INTEGER || precision_z < 0 || precision_z > 7 ||
+     precision_m == NA_INTEGER || precision_m < 0 || precision_m > 7){
+    Rcpp::stop("'precision_z' and 'precision_m' must be whole numbers between 0 and 7");
+  }
+
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  translation output(input_size);
+  parallel_for(input_size, resolve_threads(nthreads),
+               twkb_encode_worker(input, output, precision, precision_z, precision_m, sizes, bbox));
+  output.check();
+
+  List out(input_size);
+  for(unsigned int i = 0; i < input_size; i++){
+    if(input.is_na(i)){
+      out[i] = R_NilValue;
+      continue;
+    }
+    RawVector holding(output.values[i].size());
+    std::memcpy(RAW(holding), output.values[i].data(), output.values[i].size());
+    out[i] = holding;
+  }
+  return out;
+}
+
+// [[Rcpp::export]]
+CharacterVector twkb_wkt_(List x, SEXP nthreads = R_NilValue){
+
+  // The raw vectors are read just as WKB ones are, other than the parsing
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  translation output(input_size);
+  parallel_for(input_size, resolve_threads(nthreads), twkb_decode_worker(input, output));
+  output.check();
+
+  CharacterVector out(input_size);
+  for(unsigned int i = 0; i < input_size; i++){
+    if(input.is_na(i)){
+      out[i] = NA_STRING;
+    } else {
+      out[i] = Rf_mkCharLenCE(output.values[i].data(), output.values[i].size(), CE_UTF8);
+    }
+  }
+  return out;
+}
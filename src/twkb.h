@@ -0,0 +1,551 @@
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include "wkb.h"
+
+#ifndef __WKT_TWKB__
+#define __WKT_TWKB__
+namespace wkt_utils {
+
+  /**
+   * A function for finding the integer a coordinate is stored as: the
+   * coordinate times 10^precision, rounded
+   *
+   * @param x the coordinate
+   *
+   * @param scale 10^precision
+   */
+  inline boost::int64_t quantize(double x, double scale){
+    double scaled = x * scale;
+    if(!(std::fabs(scaled) < 4.6e18)){
+      throw read_wkb_exception("Coordinates must be finite, and small enough to store at the given precision");
+    }
+    return (boost::int64_t) std::floor(scaled + 0.5);
+  }
+
+  /**
+   * A function for turning a stored integer back into a coordinate.
+   * Dividing by a whole power of ten, rather than multiplying by a fraction
+   * of one, gives the double nearest the decimal, so coordinates come back
+   * as they were written.
+   *
+   * @param x the integer
+   *
+   * @param precision the number of decimal places it was stored to, from
+   * -10 to 10
+   */
+  inline double unquantize(boost::int64_t x, int precision){
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10};
+    return precision >= 0 ? (double) x / powers[precision] : (double) x * powers[-precision];
+  }
+
+  inline boost::uint64_t zigzag(boost::int64_t x){
+    return ((boost::uint64_t) x << 1) ^ (boost::uint64_t) (x >> 63);
+  }
+
+  inline boost::int64_t unzigzag(boost::uint64_t x){
+    return (boost::int64_t) (x >> 1) ^ -(boost::int64_t) (x & 1);
+  }
+
+  inline void write_varint(std::string& out, boost::uint64_t x){
+    while(x >= 0x80){
+      out += (char) ((x & 0x7F) | 0x80);
+      x >>= 7;
+    }
+    out += (char) x;
+  }
+
+  /**
+   * A single-pass scanner over a TWKB ("Tiny WKB", as PostGIS' ST_AsTWKB
+   * writes it) object: unsigned LEB128 varints, zigzag-encoded where
+   * signed, behind a two-byte header.
+   */
+  class twkb_scanner {
+
+  public:
+
+    twkb_scanner(const unsigned char* x, size_t size)
+      : cursor(x), end(x + size) {}
+
+    inline unsigned char read_byte(){
+      if(cursor == end){
+        fail("Unexpected end of TWKB");
+      }
+      return *cursor++;
+    }
+
+    inline boost::uint64_t read_varint(){
+      boost::uint64_t out = 0;
+      for(unsigned int shift = 0; shift < 64; shift += 7){
+        unsigned char byte = read_byte();
+        out |= (boost::uint64_t) (byte & 0x7F) << shift;
+        if(!(byte & 0x80)){
+          return out;
+        }
+      }
+      fail("Malformed TWKB varint");
+      return 0;
+    }
+
+    inline boost::int64_t read_signed(){
+      return unzigzag(read_varint());
+    }
+
+    /**
+     * A function for reading the number of elements that follow, checking
+     * that there are enough bytes left to hold them
+     *
+     * @param smallest the fewest bytes each element can take
+     */
+    inline boost::uint32_t read_count(size_t smallest){
+      boost::uint64_t out = read_varint();
+      if(out > (size_t) (end - cursor) / smallest){
+        fail("Unexpected end of TWKB");
+      }
+      return (boost::uint32_t) out;
+    }
+
+    /**
+     * A function for checking that nothing remains after the object
+     */
+    inline void finish(){
+      if(cursor != end){
+        fail("Too many bytes");
+      }
+    }
+
+    void fail(const std::string& message) const {
+      throw read_wkb_exception(message);
+    }
+
+  private:
+
+    const unsigned char* cursor;
+    const unsigned char* end;
+  };
+
+  /**
+   * What the header of a TWKB object says about the coordinates that follow
+   * it - how many numbers each has, and the precision of each - along with
+   * the last coordinate read, which each is stored as a delta from
+   */
+  struct twkb_coordinates {
+
+    bool has_z;
+    bool has_m;
+    int precision[4];
+    boost::int64_t last[4];
+
+    inline void read(twkb_scanner& scanner, coordinate& c){
+      c.x = next(scanner, 0);
+      c.y = next(scanner, 1);
+      c.z = has_z ? next(scanner, 2) : std::numeric_limits<double>::quiet_NaN();
+      c.m = has_m ? next(scanner, 3) : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    inline double next(twkb_scanner& scanner, unsigned int d){
+      last[d] += scanner.read_signed();
+      return unquantize(last[d], precision[d]);
+    }
+
+    inline unsigned int size() const {
+      return 2 + has_z + has_m;
+    }
+  };
+
+  /**
+   * A function for reading the coordinates of a linestring or ring
+   */
+  template <typename Handler>
+  inline void read_twkb_sequence(twkb_scanner& scanner, twkb_coordinates& coords, Handler& handler,
+                                 unsigned int ring){
+    coordinate c;
+    boost::uint32_t size = scanner.read_count(coords.size());
+    handler.begin_ring(ring);
+    for(boost::uint32_t i = 0; i < size; i++){
+      coords.read(scanner, c);
+      handler.coord(c);
+    }
+    handler.end_ring();
+  }
+
+  /**
+   * A function for reading a TWKB object from its header onwards, reporting
+   * the same events to the handler that read_body reports for WKT. Bounding
+   * boxes, sizes and ID lists are skipped over.
+   *
+   * @param scanner a reference to a twkb_scanner positioned at the start of the object
+   *
+   * @param handler a reference to a handler to report to
+   *
+   * @param depth the number of GeometryCollections the object is inside;
+   * see max_nesting
+   */
+  template <typename Handler>
+  void read_twkb_body(twkb_scanner& scanner, Handler& handler, unsigned int depth = 0){
+
+    unsigned char type = scanner.read_byte();
+    unsigned char flags = scanner.read_byte();
+    twkb_coordinates coords = {false, false, {0, 0, 0, 0}, {0, 0, 0, 0}};
+    coords.precision[0] = coords.precision[1] = (int) unzigzag(type >> 4);
+    if(flags & 0x08){
+      unsigned char extended = scanner.read_byte();
+      coords.has_z = (extended & 0x01) != 0;
+      coords.has_m = (extended & 0x02) != 0;
+      coords.precision[2] = (extended >> 2) & 0x07;
+      coords.precision[3] = (extended >> 5) & 0x07;
+    }
+    if(flags & 0x02){
+      scanner.read_varint();
+    }
+
+    wkt_header header;
+    header.has_z = coords.has_z;
+    header.has_m = coords.has_m;
+    header.is_empty = (flags & 0x10) != 0;
+    switch(type & 0x0F){
+    case 1: header.type = point; break;
+    case 2: header.type = line_string; break;
+    case 3: header.type = polygon; break;
+    case 4: header.type = multi_point; break;
+    case 5: header.type = multi_line_string; break;
+    case 6: header.type = multi_polygon; break;
+    case 7: header.type = geometry_collection; break;
+    default:
+      scanner.fail("Object could not be recognised as a supported TWKB type");
+    }
+    if(header.type == geometry_collection && !Handler::collections){
+      scanner.fail("Object could not be recognised as a supported TWKB type");
+    }
+    if(header.type == geometry_collection && depth == max_nesting){
+      scanner.fail("GeometryCollections are too deeply nested");
+    }
+    if(header.is_empty){
+      handler.begin_geometry(header);
+      handler.end_geometry();
+      return;
+    }
+    if(flags & 0x01){
+      for(unsigned int i = 0; i < 2 * coords.size(); i++){
+        scanner.read_varint();
+      }
+    }
+
+    coordinate c;
+    boost::uint32_t size;
+    switch(header.type){
+    case point:
+      handler.begin_geometry(header);
+      coords.read(scanner, c);
+      handler.coord(c);
+      break;
+    case line_string:
+      size = scanner.read_count(coords.size());
+      header.is_empty = (size == 0);
+      handler.begin_geometry(header);
+      if(size){
+        handler.begin_ring(0);
+        for(boost::uint32_t i = 0; i < size; i++){
+          coords.read(scanner, c);
+          handler.coord(c);
+        }
+        handler.end_ring();
+      }
+      break;
+    case polygon:
+      size = scanner.read_count(1);
+      header.is_empty = (size == 0);
+      handler.begin_geometry(header);
+      for(boost::uint32_t i = 0; i < size; i++){
+        read_twkb_sequence(scanner, coords, handler, i);
+      }
+      break;
+    default:
+      size = scanner.read_count(1);
+      if(flags & 0x04){
+        for(boost::uint32_t i = 0; i < size; i++){
+          scanner.read_varint();
+        }
+      }
+      header.is_empty = (size == 0);
+      handler.begin_geometry(header);
+      for(boost::uint32_t i = 0; i < size; i++){
+        handler.begin_part(i);
+        switch(header.type){
+        case multi_point:
+          coords.read(scanner, c);
+          handler.coord(c);
+          break;
+        case multi_line_string:
+          read_twkb_sequence(scanner, coords, handler, 0);
+          break;
+        case multi_polygon:
+          for(boost::uint32_t j = 0, rings = scanner.read_count(1); j < rings; j++){
+            read_twkb_sequence(scanner, coords, handler, j);
+          }
+          break;
+        default:
+          read_twkb_body(scanner, handler, depth + 1);
+        }
+        handler.end_part();
+      }
+    }
+    handler.end_geometry();
+  }
+
+  /**
+   * A function for reading a complete TWKB object into a handler
+   *
+   * @param x a pointer to the TWKB object
+   *
+   * @param size the number of bytes in x
+   *
+   * @param handler a reference to a handler to report to
+   */
+  template <typename Handler>
+  void read_twkb_geometry(const unsigned char* x, size_t size, Handler& handler){
+    twkb_scanner scanner(x, size);
+    read_twkb_body(scanner, handler);
+    scanner.finish();
+  }
+
+  /**
+   * A handler that writes TWKB as an object is read. Coordinates are stored
+   * as integers at a fixed number of decimal places, each as the difference
+   * from the last within the object (members of a GeometryCollection are
+   * objects of their own), in varints, so that nearby points take a byte or
+   * two per number rather than eight.
+   *
+   * TWKB puts counts - and, optionally, sizes and bounding boxes - ahead of
+   * what they describe, and varints can't be patched in once known, so each
+   * object, multipolygon part and ring is written to a buffer of its own
+   * and copied into the one enclosing it, behind its count, when it ends.
+   * Empty points in a multipoint, which TWKB can't represent, are dropped.
+   */
+  struct twkb_writer : wkt_handler {
+
+    static const bool collections = true;
+
+    struct frame {
+      supported_types type;
+      bool has_z;
+      bool has_m;
+      bool has_points;
+      bool boxed;
+      boost::int64_t last[4];
+      boost::int64_t low[4];
+      boost::int64_t high[4];
+    };
+
+    std::string& out;
+    int precision[4];
+    double scale[4];
+    bool sizes;
+    bool bbox;
+    std::vector < frame > frames;
+    // The buffer and element count of each level being written; level 0
+    // is out itself
+    std::vector < std::string > buffers;
+    std::vector < boost::uint32_t > counts;
+    unsigned int depth;
+    std::string head;
+
+    /**
+     * @param out a reference to the string to append TWKB to
+     *
+     * @param xy the number of decimal places to store x and y to, from -7 to 7
+     *
+     * @param z the number of decimal places to store Z values to, from 0 to 7
+     *
+     * @param m the number of decimal places to store M values to, from 0 to 7
+     *
+     * @param sizes whether to write each object's size in bytes
+     *
+     * @param bbox whether to write each object's bounding box
+     */
+    twkb_writer(std::string& out, int xy, int z, int m, bool sizes, bool bbox)
+      : out(out), sizes(sizes), bbox(bbox), buffers(1), counts(1, 0), depth(0) {
+      precision[0] = precision[1] = xy;
+      precision[2] = z;
+      precision[3] = m;
+      for(unsigned int d = 0; d < 4; d++){
+        scale[d] = std::pow(10.0, precision[d]);
+      }
+    }
+
+    inline void begin_geometry(const wkt_header& header){
+      frame f;
+      f.type = header.type;
+      f.has_z = header.has_z;
+      f.has_m = header.has_m;
+      f.has_points = false;
+      f.boxed = false;
+      for(unsigned int d = 0; d < 4; d++){
+        f.last[d] = 0;
+      }
+      frames.push_back(f);
+      open();
+    }
+
+    inline void end_geometry(){
+      const frame& f = frames.back();
+      bool empty = f.type == point ? !f.has_points : counts[depth] == 0;
+      unsigned int dims = 2 + f.has_z + f.has_m;
+
+      head.clear();
+      if(!empty){
+        if(bbox){
+          for(unsigned int d = 0; d < 4; d++){
+            if((d == 2 && !f.has_z) || (d == 3 && !f.has_m)){
+              continue;
+            }
+            write_varint(head, zigzag(f.low[d]));
+            write_varint(head, zigzag(f.high[d] - f.low[d]));
+          }
+        }
+        if(f.type != point){
+          write_varint(head, counts[depth]);
+        }
+      }
+
+      std::string& to = level(depth - 1);
+      to += (char) (code(f.type) | (zigzag(precision[0]) << 4));
+      to += (char) ((bbox && !empty ? 0x01 : 0) | (sizes ? 0x02 : 0) |
+                    (dims > 2 ? 0x08 : 0) | (empty ? 0x10 : 0));
+      if(dims > 2){
+        to += (char) ((f.has_z ? 0x01 : 0) | (f.has_m ? 0x02 : 0) |
+                      (f.has_z ? precision[2] << 2 : 0) | (f.has_m ? precision[3] << 5 : 0));
+      }
+      if(sizes){
+        write_varint(to, empty ? 0 : head.size() + buffers[depth].size());
+      }
+      if(!empty){
+        to += head;
+        to += buffers[depth];
+      }
+      depth--;
+
+      if(bbox && !empty && frames.size() > 1){
+        include(frames[frames.size() - 2], f.low, f.high);
+      }
+      frames.pop_back();
+    }
+
+    inline void begin_part(unsigned int){
+      switch(frames.back().type){
+      case multi_polygon:
+        counts[depth]++;
+        open();
+        break;
+      case geometry_collection:
+        counts[depth]++;
+        break;
+      default:
+        // Multipoints count their points, and multilinestrings their
+        // linestrings, as they come
+        break;
+      }
+    }
+
+    inline void end_part(){
+      if(frames.back().type == multi_polygon){
+        close();
+      }
+    }
+
+    inline void begin_ring(unsigned int){
+      if(frames.back().type != line_string){
+        counts[depth]++;
+        open();
+      }
+    }
+
+    inline void end_ring(){
+      if(frames.back().type != line_string){
+        close();
+      }
+    }
+
+    inline void coord(const coordinate& c){
+      frame& f = frames.back();
+      if(f.type != point){
+        counts[depth]++;
+      }
+      const double values[] = {c.x, c.y, c.z, c.m};
+      boost::int64_t stored[] = {0, 0, 0, 0};
+      std::string& to = buffers[depth];
+      for(unsigned int d = 0; d < 4; d++){
+        if((d == 2 && !f.has_z) || (d == 3 && !f.has_m)){
+          continue;
+        }
+        stored[d] = quantize(values[d], scale[d]);
+        write_varint(to, zigzag(stored[d] - f.last[d]));
+        f.last[d] = stored[d];
+      }
+      f.has_points = true;
+      if(bbox){
+        include(f, stored, stored);
+      }
+    }
+
+    /**
+     * A function for starting a level: an object, multipolygon part or
+     * ring, whose elements are counted
+     */
+    inline void open(){
+      depth++;
+      if(buffers.size() <= depth){
+        buffers.resize(depth + 1);
+        counts.resize(depth + 1);
+      }
+      buffers[depth].clear();
+      counts[depth] = 0;
+    }
+
+    /**
+     * A function for finishing a level other than an object's, copying its
+     * count and elements into the level enclosing it
+     */
+    inline void close(){
+      std::string& to = level(depth - 1);
+      write_varint(to, counts[depth]);
+      to += buffers[depth];
+      depth--;
+    }
+
+    inline std::string& level(unsigned int i){
+      return i ? buffers[i] : out;
+    }
+
+    /**
+     * A function for growing an object's bounding box to take in a point,
+     * or another object's box
+     */
+    static inline void include(frame& f, const boost::int64_t* low, const boost::int64_t* high){
+      for(unsigned int d = 0; d < 4; d++){
+        if(!f.boxed || low[d] < f.low[d]){
+          f.low[d] = low[d];
+        }
+        if(!f.boxed || high[d] > f.high[d]){
+          f.high[d] = high[d];
+        }
+      }
+      f.boxed = true;
+    }
+
+    static inline unsigned char code(supported_types type){
+      switch(type){
+      case point: return 1;
+      case line_string: return 2;
+      case polygon: return 3;
+      case multi_point: return 4;
+      case multi_line_string: return 5;
+      case multi_polygon: return 6;
+      default: return 7;
+      }
+    }
+  };
+}
+#endif
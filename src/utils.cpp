@@ -1,109 +1,147 @@
 #include "utils.h"
+#include "writer.h"
 
-void wkt_utils::lower_case(std::string& x){
-
-  std::string out(x);
-  for(unsigned int i = 0; i < x.size(); i++){
-    x[i] = std::tolower(x[i]);
-  }
-
+wkt_utils::supported_types wkt_utils::id_type(std::string& wkt_obj){
+  return wkt_utils::id_type(wkt_obj.data(), wkt_obj.size());
 }
 
-void wkt_utils::clean_wkt(std::string& x){
-  size_t first_point = x.find_first_not_of(" \t");
-  x.erase(0, first_point);
-  first_point = x.find_last_not_of(" \t");
-  if(first_point != std::string::npos){
-    x.erase(first_point+1);
-  }
+wkt_utils::supported_types wkt_utils::id_type(const char* wkt_obj, size_t size){
+  wkt_scanner scanner(wkt_obj, size);
+  return scanner.read_type();
 }
 
-wkt_utils::supported_types wkt_utils::hash_type(std::string type){
-  if(type == "point"){
-    return point;
-  }
-  if(type == "multipoint"){
-    return multi_point;
-  }
-  if(type == "linestring"){
-    return line_string;
-  }
-  if(type == "multilinestring"){
-    return multi_line_string;
-  }
-  if(type == "polygon"){
-    return polygon;
-  }
-  if(type == "multipolygon"){
-    return multi_polygon;
-  }
-  if(type == "geometrycollection"){
-    return geometry_collection;
-  }
-  return unsupported_type;
+std::string wkt_utils::make_string(int i){
+  std::stringstream y;
+  y << i;
+  return y.str();
 }
 
-wkt_utils::supported_types wkt_utils::id_type(std::string& wkt_obj){
-
-  // Clean object
-  wkt_utils::lower_case(wkt_obj);
-  wkt_utils::clean_wkt(wkt_obj);
-
-  // Split out type
-  size_t type_loc = wkt_obj.find_first_of(" (");
-  if(type_loc == std::string::npos || type_loc == wkt_obj.size()){
-    return wkt_utils::unsupported_type;
-  }
-
-  return wkt_utils::hash_type(wkt_obj.substr(0, type_loc));
+// NULL marks NA in a wkt_input, so an empty raw vector needs a pointer that isn't
+static const char* raw_data(SEXP x){
+  return XLENGTH(x) ? reinterpret_cast<const char*>(RAW(x)) : "";
 }
 
-void wkt_utils::split_gc(std::string& wkt_obj, std::deque < std::string >& output){
+wkt_utils::wkt_input::wkt_input(SEXP x)
+  : store(NULL){
+  SEXP holding;
 
-  bool last_alpha = false;
-  unsigned int input_size = wkt_obj.size();
-  size_t point = std::string::npos;
-
-  for(signed int i = input_size; i >= 0; i--){
-    if(isalpha(wkt_obj[i])){
-      if(!last_alpha){
-        last_alpha = true;
+  // Factors - data.frame(stringsAsFactors = TRUE) columns, say - are read
+  // as their labels, held for as long as the input is
+  if(Rf_isFactor(x)){
+    labels = Rf_asCharacterFactor(x);
+    x = labels;
+  }
+  kind = TYPEOF(x) == STRSXP ? text : binary;
+  origin = x;
+
+  switch(TYPEOF(x)){
+  case STRSXP:
+    data.resize(Rf_xlength(x));
+    sizes.resize(data.size());
+    for(unsigned int i = 0; i < data.size(); i++){
+      holding = STRING_ELT(x, i);
+      if(holding == NA_STRING){
+        data[i] = NULL;
+        sizes[i] = 0;
+      } else {
+        data[i] = CHAR(holding);
+        sizes[i] = LENGTH(holding);
       }
-    } else {
-      if(last_alpha){
-        output.push_back(wkt_obj.substr(i+1, (point - i)));
-        last_alpha = false;
-        point = i;
+    }
+    break;
+  case RAWSXP:
+    data.push_back(raw_data(x));
+    sizes.push_back(XLENGTH(x));
+    break;
+  case VECSXP:
+    data.resize(Rf_xlength(x));
+    sizes.resize(data.size());
+    for(unsigned int i = 0; i < data.size(); i++){
+      holding = VECTOR_ELT(x, i);
+      if(holding == R_NilValue){
+        data[i] = NULL;
+        sizes[i] = 0;
+      } else if(TYPEOF(holding) == RAWSXP){
+        data[i] = raw_data(holding);
+        sizes[i] = XLENGTH(holding);
+      } else {
+        Rcpp::stop("WKB objects must be raw vectors (or NULL)");
       }
     }
+    break;
+  case EXTPTRSXP:
+    // Rows are read from the store; data only marks which are NA
+    kind = stored;
+    store = get_store(x);
+    origin = R_ExternalPtrProtected(x);
+    data.resize(store->length());
+    sizes.resize(data.size(), 0);
+    for(unsigned int i = 0; i < data.size(); i++){
+      data[i] = store->is_na(i) ? NULL : "";
+    }
+    break;
+  default:
+    Rcpp::stop("Expecting a character vector of WKT objects or a list of raw vectors of WKB objects");
   }
+}
 
-  size_t brace_point;
-  if(output.size() > 0){
-    output[0] = output[0].erase(output[0].size()-1);
-    for(unsigned int i = 0; i < output.size(); i++){
-      brace_point = output[i].find_last_of(")");
-      if(brace_point != std::string::npos && brace_point != (output[i].size() - 1)){
-        output[i] = output[i].erase(brace_point+1);
-      }
-    }
+const wkt_utils::wkt_store* wkt_utils::get_store(SEXP x){
+  if(TYPEOF(x) != EXTPTRSXP || !Rf_inherits(x, "wkt_parsed")){
+    Rcpp::stop("Expecting a wkt_parsed object, as returned by wkt_parse()");
   }
+  wkt_store* out = static_cast<wkt_store*>(R_ExternalPtrAddr(x));
+  if(out == NULL){
+    Rcpp::stop("This wkt_parsed object is no longer valid (parsed objects can't be saved and reloaded); call wkt_parse() again");
+  }
+  return out;
 }
 
-std::string wkt_utils::make_wkt_poly(polygon_type p){
-  std::stringstream ss;
-  ss << boost::geometry::wkt(p);
-  return ss.str();
+SEXP wkt_utils::wkt_output::take(unsigned int i){
+  SEXP out = Rf_mkCharLenCE(values[i].data(), values[i].size(), CE_UTF8);
+  std::string().swap(values[i]);
+  return out;
 }
 
-std::string wkt_utils::make_wkt_multipoly(multipolygon_type p){
-  std::stringstream ss;
-  ss << boost::geometry::wkt(p);
-  return ss.str();
+CharacterVector wkt_utils::wkt_output::to_r(const wkt_input& input){
+  unsigned int input_size = state.size();
+  CharacterVector output(input_size);
+  SEXP source = input.source();
+  std::string holding;
+  for(unsigned int i = 0; i < input_size; i++){
+    switch(state[i]){
+    case missing:
+      SET_STRING_ELT(output, i, NA_STRING);
+      break;
+    case unchanged:
+      if(TYPEOF(source) == STRSXP){
+        SET_STRING_ELT(output, i, STRING_ELT(source, i));
+        break;
+      }
+      holding.clear();
+      try {
+        wkt_text_writer writer(holding, 16, true);
+        input.read(i, writer);
+        SET_STRING_ELT(output, i, Rf_mkCharLenCE(holding.data(), holding.size(), CE_UTF8));
+      } catch (boost::geometry::read_wkt_exception &e){
+        SET_STRING_ELT(output, i, NA_STRING);
+      }
+      break;
+    default:
+      SET_STRING_ELT(output, i, take(i));
+    }
+  }
+  return output;
 }
 
-std::string wkt_utils::make_string(int i){
-  std::stringstream y;
-  y << i;
-  return y.str();
+CharacterVector wkt_utils::wkt_output::to_r(){
+  unsigned int input_size = state.size();
+  CharacterVector output(input_size);
+  for(unsigned int i = 0; i < input_size; i++){
+    if(state[i] == changed){
+      SET_STRING_ELT(output, i, take(i));
+    } else {
+      SET_STRING_ELT(output, i, NA_STRING);
+    }
+  }
+  return output;
 }
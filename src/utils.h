@@ -1,5 +1,8 @@
 #include <Rcpp.h>
 #include "def.h"
+#include "reader.h"
+#include "wkb.h"
+#include "parsed.h"
 using namespace Rcpp;
 
 #ifndef __WKT_UTILS__
@@ -7,87 +10,263 @@ using namespace Rcpp;
 namespace wkt_utils {
 
   /**
-   * A function for lower-casing a string
+   * A function for extracting the type from a WKT object and identifying it
+   * as an enum value
    *
-   * @param x a reference to a string to lower-case
+   * @param wkt_obj a reference to a string to extract the type from
    *
-   * @return nothing; x is modified directly
+   * @return a value from the supported_types enum
    */
-  void lower_case(std::string& x);
+  supported_types id_type(std::string& wkt_obj);
 
   /**
-   * A function for cleaning a WKT object - specifically, removing trailing and tailing
-   * spaces.
+   * A function for identifying the type of a WKT object directly from its
+   * character buffer, without copying or lower-casing it
+   *
+   * @param wkt_obj a pointer to the WKT object
    *
-   * @param x a reference to a string to clean
+   * @param size the number of bytes in wkt_obj
    *
-   * @return nothing; x is modified directly
+   * @return a value from the supported_types enum
    */
-  void clean_wkt(std::string& x);
+  supported_types id_type(const char* wkt_obj, size_t size);
+
+  std::string make_string(int x);
 
   /**
-   * An enum of supported types: exists to make switch statements easier
+   * The objects in a character vector of WKT, a list of raw WKB vectors or
+   * a wkt_parse() store, gathered up front on the main thread so that worker
+   * threads can read them without calling into R
    */
-  enum supported_types {
-    point               = 1,
-    multi_point         = 2,
-    line_string         = 3,
-    multi_line_string   = 4,
-    polygon             = 5,
-    geometry_collection = 6,
-    multi_polygon       = 7,
-    unsupported_type    = 8
+  class wkt_input {
+
+  public:
+
+    /**
+     * @param x a character vector (or a factor), a list of raw vectors (and
+     * NULLs, which are treated as NA), a single raw vector, or a wkt_parsed
+     * object
+     */
+    wkt_input(SEXP x);
+
+    /**
+     * @param data pointers to WKT objects held elsewhere - which must outlive
+     * the input - with NULL for NA
+     *
+     * @param sizes the number of bytes in each object
+     */
+    wkt_input(const std::vector < const char* >& data, const std::vector < R_xlen_t >& sizes)
+      : data(data), sizes(sizes), kind(text), store(NULL), origin(R_NilValue) {}
+
+    inline bool is_na(unsigned int i) const {
+      return data[i] == NULL;
+    }
+
+    /**
+     * A function for checking whether get() returns WKT text
+     */
+    inline bool is_text() const {
+      return kind == text;
+    }
+
+    /**
+     * A function for reading an object into a handler, from whichever form
+     * the input holds it in
+     *
+     * @param i the index of the object
+     *
+     * @param handler a reference to a handler to report to
+     *
+     * @param lenient whether to accept sloppy WKT; see wkt_scanner
+     */
+    template <typename Handler>
+    inline void read(unsigned int i, Handler& handler, bool lenient = false) const {
+      switch(kind){
+      case text:
+        read_geometry(data[i], sizes[i], handler, lenient);
+        break;
+      case binary:
+        read_wkb_geometry(reinterpret_cast<const unsigned char*>(data[i]), sizes[i], handler);
+        break;
+      default:
+        store->replay(i, handler);
+      }
+    }
+
+    /**
+     * A function for reading an object into a boost::geometry object
+     *
+     * @param i the index of the object
+     *
+     * @param geom a reference to the boost::geometry object to fill in
+     */
+    template <typename Geometry>
+    inline void read_into(unsigned int i, Geometry& geom) const {
+      switch(kind){
+      case text:
+        read_wkt(data[i], sizes[i], geom);
+        break;
+      case binary:
+        read_wkb(reinterpret_cast<const unsigned char*>(data[i]), sizes[i], geom);
+        break;
+      default:
+        store->replay_into(i, geom);
+      }
+    }
+
+    /**
+     * A function for identifying the type of an object
+     *
+     * @param i the index of the object
+     *
+     * @return a value from the supported_types enum
+     */
+    inline supported_types type(unsigned int i) const {
+      switch(kind){
+      case text:
+        return id_type(data[i], sizes[i]);
+      case binary:
+        return wkb_type(reinterpret_cast<const unsigned char*>(data[i]), sizes[i]);
+      default:
+        return store->type(i);
+      }
+    }
+
+    inline const char* get(unsigned int i) const {
+      return data[i];
+    }
+
+    inline R_xlen_t size(unsigned int i) const {
+      return sizes[i];
+    }
+
+    inline unsigned int length() const {
+      return data.size();
+    }
+
+    /**
+     * A function for getting the R object the input was read from: the
+     * character vector or list itself, or what a wkt_parse() store was
+     * built from
+     */
+    inline SEXP source() const {
+      return origin;
+    }
+
+  private:
+    enum input_kind { text, binary, stored };
+    std::vector < const char* > data;
+    std::vector < R_xlen_t > sizes;
+    input_kind kind;
+    const wkt_store* store;
+    SEXP origin;
+    Rcpp::RObject labels;
   };
 
   /**
-   * A function for generating a type enum. Used in switch statements.
+   * A function for getting the store behind a wkt_parsed object
    *
-   * @param type a string containing the suspected type of the WKT object
+   * @param x a wkt_parsed object, as returned by wkt_parse()
    *
-   * @return a value from the supported_types enum
+   * @return a pointer to the store; errors if x isn't a usable wkt_parsed object
    */
-  supported_types hash_type(std::string type);
+  const wkt_store* get_store(SEXP x);
 
   /**
-   * A function for extracting the type from a WKT object and identifying it
-   * as an enum value
-   *
-   * @param wkt_obj a reference to a string to extract the type from
-   *
-   * @return a value from the supported_types enum
+   * Per-row string results from worker threads, turned into a character
+   * vector on the main thread once they are done. Rows can be NA, a new
+   * string, or the input string passed through untouched.
    */
-  supported_types id_type(std::string& wkt_obj);
+  class wkt_output {
 
-  /**
-   * A function to split a GeometryCollection into its component parts
-   *
-   * @param wkt_obj: a reference to a string containing a GeometryCollection
-   *
-   * @param output: a reference to a deque of strings to put the GeometryCollection's contents
-   * into
-   *
-   * @return nothing; output is modified
-   */
-  void split_gc(std::string& wkt_obj, std::deque < std::string >& output);
+  public:
 
-  /**
-   * A function for making a string WKT representation of a boost::geometry polygon
-   *
-   * @param p: a boost::geometry polygon
-   *
-   * @return a string containing a WKT representation of p
-   */
-  std::string make_wkt_poly(polygon_type p);
+    wkt_output(unsigned int size) : values(size), state(size, unchanged) {}
+
+    inline void set_na(unsigned int i){
+      state[i] = missing;
+    }
+
+    inline void set_unchanged(unsigned int i){
+      state[i] = unchanged;
+    }
+
+    inline void set(unsigned int i, const std::string& value){
+      values[i] = value;
+      state[i] = changed;
+    }
+
+    /**
+     * A function for writing a row's new value in place, rather than
+     * building it elsewhere and copying it in
+     *
+     * @param i the row
+     *
+     * @return a reference to the row's (empty) string, to append to
+     */
+    inline std::string& open(unsigned int i){
+      state[i] = changed;
+      values[i].clear();
+      return values[i];
+    }
+
+    inline bool is_set(unsigned int i) const {
+      return state[i] == changed;
+    }
+
+    inline const std::string& value(unsigned int i) const {
+      return values[i];
+    }
+
+    /**
+     * A function for building the R output. Must be called on the main
+     * thread, and only once, as the rows are freed as they are copied out.
+     *
+     * @param input the input the rows came from. Unchanged rows reuse its
+     * strings if it was read from WKT, and are written out as WKT otherwise.
+     *
+     * @return a character vector
+     */
+    CharacterVector to_r(const wkt_input& input);
+
+    /**
+     * A function for building the R output when no row is passed through
+     * from the input. Must be called on the main thread, and only once.
+     *
+     * @return a character vector
+     */
+    CharacterVector to_r();
+
+  private:
+    enum row_state { missing, unchanged, changed };
+    std::vector < std::string > values;
+    std::vector < char > state;
+
+    // Makes a row's CHARSXP straight from its string, then frees the string
+    // so that the output isn't held twice over
+    SEXP take(unsigned int i);
+  };
 
   /**
-   * A function for making a string WKT representation of a boost::geometry multipolygon
-   *
-   * @param p: a boost::geometry multipolygon
-   *
-   * @return a string containing a WKT representation of p
+   * Per-row results from the translation workers (wkt_wkb(), wkt_twkb(),
+   * wkt_polyline() and their inverses): the translated object, or the
+   * reason it couldn't be translated. Errors are raised on the main thread
+   * once the workers are done, for the first row that failed.
    */
-  std::string make_wkt_multipoly(multipolygon_type p);
+  struct translation {
 
-  std::string make_string(int x);
+    std::vector < std::string > values;
+    std::vector < std::string > errors;
+
+    translation(unsigned int size) : values(size), errors(size) {}
+
+    inline void check(){
+      for(unsigned int i = 0; i < errors.size(); i++){
+        if(!errors[i].empty()){
+          Rcpp::stop(errors[i]);
+        }
+      }
+    }
+  };
 }
 #endif
@@ -1,11 +1,20 @@
 #include <Rcpp.h>
 #include "utils.h"
+#include "parallel.h"
+#include "shape.h"
+#include "file_input.h"
+#include "stats.h"
+#include "streaming.h"
+#include "sweep.h"
 using namespace wkt_utils;
 using namespace Rcpp;
 
-String validity_comments(boost::geometry::validity_failure_type x){
+const char* validity_comments(boost::geometry::validity_failure_type x){
   if(x == boost::geometry::no_failure){
-    return NA_STRING;
+    return NULL;
+  }
+  if(x == boost::geometry::failure_invalid_coordinate){
+    return "The WKT object has coordinates that are not finite numbers";
   }
   if(x == boost::geometry::failure_few_points){
     return "The WKT object has too few points for its type";
@@ -43,99 +52,248 @@ String validity_comments(boost::geometry::validity_failure_type x){
   if(x == boost::geometry::failure_wrong_corner_order){
     return "The WKT object, a box, has corners in the wrong order";
   }
-  return NA_STRING;
+  return NULL;
 }
 
-template <typename T>
-inline void validate_single(std::string& x, unsigned int& i, CharacterVector& com, LogicalVector& valid, T& p){
-  boost::geometry::validity_failure_type failure;
-  try {
-    boost::geometry::read_wkt(x, p);
-    valid[i] = boost::geometry::is_valid(p, failure);
-    com[i] = validity_comments(failure);
-  } catch (boost::geometry::read_wkt_exception &e){
-    com[i] = e.what();
-    valid[i] = false;
+/**
+ * How much of validity to check: whether an object can be parsed at all;
+ * that and the checks structure_handler makes as it's read; or everything
+ * boost::geometry::is_valid checks
+ */
+enum validation_level { parse_level, structure_level, full_level };
+
+validation_level get_validation_level(std::string level){
+  if(level == "parse"){
+    return parse_level;
+  }
+  if(level == "structure"){
+    return structure_level;
+  }
+  if(level != "full"){
+    Rcpp::stop("level must be one of 'parse', 'structure' or 'full'");
   }
+  return full_level;
 }
 
-void validate_gc(std::string& x, unsigned int& i_sup, CharacterVector& com, LogicalVector& valid, std::deque <std::string>& gc){
+/**
+ * A handler that does nothing but count the parts of what it reads, for
+ * checking objects parse
+ */
+struct parse_handler : wkt_handler {
 
-  bool has_failed = false;
+  static const bool collections = true;
 
-  clean_wkt(x);
-  split_gc(x, gc);
+  unsigned int depth;
+  unsigned int parts;
 
-  if(!gc.size()){
-    com[i_sup] = "No valid objects could be extracted from this GeometryCollection";
-    valid[i_sup] = false;
-    return;
+  parse_handler() : depth(0), parts(0) {}
+
+  inline void begin_geometry(const wkt_header&){
+    depth++;
   }
 
-  // Create instances of each type
-  point_type pt;
-  linestring_type ls;
-  polygon_type poly;
-  multipoint_type multip;
-  multilinestring_type multil;
-  multipolygon_type multipoly;
+  inline void end_geometry(){
+    depth--;
+  }
 
-  for(unsigned int i = 0; i < gc.size(); i++){
-    if(has_failed){
-      break;
+  inline void begin_part(unsigned int){
+    if(depth == 1){
+      parts++;
     }
+  }
+};
 
-    switch(id_type(gc[i])){
-    case point:
-      validate_single(gc[i], i_sup, com, valid, pt);
-      if(!valid[i]){
-        has_failed = true;
-      }
-      break;
-    case line_string:
-      validate_single(gc[i], i_sup, com, valid, ls);
+/**
+ * Checks the members of a GeometryCollection in turn, stopping at the first
+ * that isn't valid
+ */
+struct validity_op {
 
-      if(!valid[i]){
-        has_failed = true;
-      }
-      break;
-    case polygon:
-      validate_single(gc[i], i_sup, com, valid, poly);
-      if(!valid[i]){
-        has_failed = true;
-      }
-      break;
-    case multi_point:
-      validate_single(gc[i], i_sup, com, valid, multip);
-      if(!valid[i]){
-        has_failed = true;
-      }
-      break;
-    case multi_line_string:
-      validate_single(gc[i], i_sup, com, valid, multil);
-      if(!valid[i]){
-        has_failed = true;
-      }
-      break;
-    case multi_polygon:
-      validate_single(gc[i], i_sup, com, valid, multipoly);
-      if(!valid[i]){
-        has_failed = true;
-      }
-      break;
-    case geometry_collection:
-      valid[i_sup] = false;
-      com[i_sup] = "GeometryCollections cannot be nested";
-      has_failed = true;
-      break;
-    default:
-      valid[i_sup] = false;
-      com[i_sup] = "A GeometryCollection member could not be recognised as a supported WKT type";
-      has_failed = true;
+  bool valid;
+  const char* comment;
+
+  validity_op() : valid(true), comment(NULL) {}
+
+  template <typename T>
+  inline void operator()(const T& p){
+    check(p);
+  }
 
+  template <typename T>
+  inline void check(const T& p){
+    if(!valid){
+      return;
     }
+    boost::geometry::validity_failure_type failure;
+    valid = wkt_utils::is_valid(p, failure);
+    comment = validity_comments(failure);
+  }
+
+  // An empty point, left as NaN, is a valid member rather than an invalid
+  // coordinate
+  inline void operator()(const point_type& p){
+    if(!ISNAN(boost::geometry::get<0>(p))){
+      check(p);
+    }
+  }
+};
+
+struct validate_worker {
+
+  const wkt_input& x;
+  wkt_output& com;
+  int* valid;
+  validation_level level;
+  call_stats& stats;
+
+  validate_worker(const wkt_input& x, wkt_output& com, int* valid, validation_level level,
+                  call_stats& stats)
+    : x(x), com(com), valid(valid), level(level), stats(stats) {}
+
+  inline void set_comment(unsigned int i, const char* comment){
+    if(comment == NULL){
+      com.set_na(i);
+    } else {
+      com.set(i, comment);
+    }
+  }
+
+  template <typename T>
+  inline void check(unsigned int i, T& p){
+    boost::geometry::validity_failure_type failure;
+    valid[i] = wkt_utils::is_valid(p, failure);
+    set_comment(i, validity_comments(failure));
+  }
+
+  template <typename T>
+  inline void single(unsigned int i, row_stats& row){
+    T p;
+    try {
+      x.read_into(i, p);
+    } catch (boost::geometry::read_wkt_exception &e){
+      com.set(i, e.what());
+      valid[i] = false;
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+    check(i, p);
+    row.lap(compute_phase);
   }
-}
+
+  void gc(unsigned int i, row_stats& row){
+    shape collection;
+    try {
+      collection.read(x, i);
+    } catch (boost::geometry::read_wkt_exception &e){
+      com.set(i, e.what());
+      valid[i] = false;
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+
+    if(collection.members.empty()){
+      com.set(i, "No valid objects could be extracted from this GeometryCollection");
+      valid[i] = false;
+      return;
+    }
+
+    // Nested collections are checked member by member, like the rest
+    validity_op op;
+    visit_shape(collection, op);
+    valid[i] = op.valid;
+    set_comment(i, op.comment);
+    row.lap(compute_phase);
+  }
+
+  /**
+   * A function for checking an object as it's read, without building it,
+   * for the levels short of full
+   */
+  template <typename Handler>
+  bool scan(unsigned int i, Handler& handler, row_stats& row){
+    try {
+      x.read(i, handler);
+    } catch (boost::geometry::read_wkt_exception &e){
+      com.set(i, e.what());
+      valid[i] = false;
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return false;
+    }
+    row.lap(parse_phase);
+    if(handler.parts == 0 && x.type(i) == geometry_collection){
+      com.set(i, "No valid objects could be extracted from this GeometryCollection");
+      valid[i] = false;
+      return false;
+    }
+    return true;
+  }
+
+  void structure(unsigned int i, row_stats& row){
+    structure_handler handler;
+    if(scan(i, handler, row)){
+      valid[i] = handler.valid();
+      set_comment(i, validity_comments(handler.failure));
+    }
+  }
+
+  void operator()(unsigned int i){
+    // Each row's geometries are built in, and released with, the arena
+    arena_scope scope;
+    row_stats row(stats.local());
+    if(x.is_na(i)){
+      row.row(-1);
+      valid[i] = NA_LOGICAL;
+      com.set_na(i);
+      return;
+    }
+    row.row(x.size(i));
+    valid[i] = true;
+    com.set_na(i);
+    supported_types type = x.type(i);
+    row.lap(dispatch_phase);
+    if(level != full_level && type != unsupported_type){
+      if(level == parse_level){
+        parse_handler handler;
+        scan(i, handler, row);
+      } else {
+        structure(i, row);
+      }
+      return;
+    }
+    switch(type){
+      case point:
+        single<point_type>(i, row);
+        break;
+      case line_string:
+        single<linestring_type>(i, row);
+        break;
+      case polygon:
+        single<polygon_type>(i, row);
+        break;
+      case multi_point:
+        single<multipoint_type>(i, row);
+        break;
+      case multi_line_string:
+        single<multilinestring_type>(i, row);
+        break;
+      case multi_polygon:
+        single<multipolygon_type>(i, row);
+        break;
+      case geometry_collection:
+        gc(i, row);
+        break;
+      default:
+        valid[i] = false;
+        com.set(i, "Object could not be recognised as a supported WKT type");
+        row.failed(x, i);
+    }
+  }
+};
 
 //' @title Validate WKT objects
 //' @description `validate_wkt` takes a vector of WKT objects and validates
@@ -144,12 +302,27 @@ void validate_gc(std::string& x, unsigned int& i_sup, CharacterVector& com, Logi
 //' may be wrong with it. It does not, unfortunately, check whether the
 //' object meets the WKT spec - merely that it is formatted correctly.
 //' @export
-//' @param x a character vector of WKT objects.
+//' @param x a character vector of WKT objects, or a list of raw vectors of
+//' WKB objects (or a single raw vector), or a `wkt_parsed` object from
+//' [wkt_parse()].
+//' @param level how thoroughly to check each object: `"parse"`, only that
+//' it can be parsed; `"structure"`, that and the checks that can be made of
+//' each ring or linestring as it's read - that coordinates are finite, that
+//' there are enough (distinct) points, that rings are closed, have no spikes
+//' and are oriented as [wkt_correct()] would have them; or `"full"` (the
+//' default), everything, including that rings don't intersect themselves or
+//' each other and nest as they should. The first two are much faster, and
+//' never build the object.
+//' @template nthreads
 //' @return a data.frame of two columns, `is_valid` (containing
 //' `TRUE` or `FALSE` values for whether the WKT object is parseable and
 //' valid) and `comments` (containing any error messages
 //' in the case that the WKT object is not). If the objects are simply NA,
 //' both fields will contain NA.
+//' @details For large polygons and multipolygons, the full check first
+//' sweeps their edges, looking for any that meet; only if some do (or the
+//' object fails a cheaper check) does it fall back to the more thorough,
+//' and much slower, check that says what is wrong.
 //' @seealso [wkt_correct()] for correcting WKT objects
 //' that fail validity checks due to having a non-default orientation.
 //' @examples
@@ -157,63 +330,73 @@ void validate_gc(std::string& x, unsigned int& i_sup, CharacterVector& com, Logi
 //'  "ARGHLEFLARFDFG",
 //'  "LINESTRING (30 10, 10 90, 40 some string)")
 //' validate_wkt(wkt)
+//' validate_wkt("POLYGON ((0 0, 1 1, 1 0, 0 1, 0 0))", level = "structure")
 // [[Rcpp::export]]
-DataFrame validate_wkt(CharacterVector x){
-
-  // Create instances of each type
-  point_type pt;
-  linestring_type ls;
-  polygon_type poly;
-  multipoint_type multip;
-  multilinestring_type multil;
-  multipolygon_type multipoly;
+DataFrame validate_wkt(SEXP x, std::string level = "full", SEXP nthreads = R_NilValue){
 
   // Generate output objects
-  unsigned int input_size = x.size();
-  CharacterVector comments(input_size, NA_STRING);
-  LogicalVector is_valid(input_size, true);
-  std::string holding;
-  std::deque < std::string > gc_holding;
-
-  for(unsigned int i = 0; i < input_size; i++){
-    if((i % 10000) == 0){
-      Rcpp::checkUserInterrupt();
-    }
-    if(x[i] == NA_STRING){
-      is_valid[i] = NA_LOGICAL;
-    } else {
-      holding = Rcpp::as<std::string>(x[i]);
-      switch(id_type(holding)){
-        case point:
-          validate_single(holding, i, comments, is_valid, pt);
-          break;
-        case line_string:
-          validate_single(holding, i, comments, is_valid, ls);
-          break;
-        case polygon:
-          validate_single(holding, i, comments, is_valid, poly);
-          break;
-        case multi_point:
-          validate_single(holding, i, comments, is_valid, multip);
-          break;
-        case multi_line_string:
-          validate_single(holding, i, comments, is_valid, multil);
-          break;
-        case multi_polygon:
-          validate_single(holding, i, comments, is_valid, multipoly);
-          break;
-        case geometry_collection:
-          validate_gc(holding, i, comments, is_valid, gc_holding);
-          gc_holding.clear();
-          break;
-        default:
-          is_valid[i] = false;
-          comments[i] = "Object could not be recognised as a supported WKT type";
+  validation_level checks = get_validation_level(level);
+  int threads = resolve_threads(nthreads);
+  call_stats stats("validate_wkt", threads);
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  LogicalVector is_valid(input_size);
+  wkt_output comments(input_size);
+
+  parallel_for(input_size, threads, validate_worker(input, comments, LOGICAL(is_valid), checks, stats));
+
+  row_stats output(stats.local());
+  DataFrame result = DataFrame::create(_["is_valid"] = is_valid,
+                                       _["comments"] = comments.to_r(),
+                                       _["stringsAsFactors"] = false);
+  output.lap(output_phase);
+  stats.finish();
+  return result;
+}
+
+// [[Rcpp::export]]
+DataFrame validate_wkt_file_(std::string path, std::string format, std::string column_name,
+                             int column_index, int chunk_size, std::string level,
+                             SEXP nthreads){
+
+  validation_level checks = get_validation_level(level);
+  int threads = resolve_threads(nthreads);
+  call_stats stats("validate_wkt_file", threads);
+  wkt_file file(path, get_file_format(format), column_name, column_index, chunk_size);
+
+  // Most rows are valid, and so have no comment; only those that do are kept
+  std::vector < int > valid;
+  std::vector < size_t > comment_rows;
+  std::vector < std::string > comment_values;
+  while(file.next()){
+    size_t first = file.first_row();
+    unsigned int chunk_rows = file.rows();
+    valid.resize(first + chunk_rows);
+    wkt_output comments(chunk_rows);
+    parallel_for(chunk_rows, threads, validate_worker(file.input(), comments, valid.data() + first, checks, stats));
+    for(unsigned int i = 0; i < chunk_rows; i++){
+      if(comments.is_set(i)){
+        comment_rows.push_back(first + i);
+        comment_values.push_back(comments.value(i));
       }
     }
+    checkUserInterrupt();
+  }
+
+  row_stats output(stats.local());
+  R_xlen_t rows = valid.size();
+  LogicalVector is_valid(rows);
+  std::copy(valid.begin(), valid.end(), LOGICAL(is_valid));
+  std::vector < int >().swap(valid);
+  CharacterVector comments(rows, NA_STRING);
+  for(size_t i = 0; i < comment_rows.size(); i++){
+    comments[comment_rows[i]] = comment_values[i];
   }
 
-  return DataFrame::create(_["is_valid"] = is_valid,
-                           _["comments"] = comments,
-                           _["stringsAsFactors"] = false);
+  DataFrame result = DataFrame::create(_["is_valid"] = is_valid,
+                                       _["comments"] = comments,
+                                       _["stringsAsFactors"] = false);
+  output.lap(output_phase);
+  stats.finish();
+  return result;
 }
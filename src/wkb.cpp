@@ -0,0 +1,101 @@
+#include <Rcpp.h>
+#include <cstring>
+using namespace Rcpp;
+#include "utils.h"
+#include "parallel.h"
+#include "writer.h"
+using namespace wkt_utils;
+
+struct wkb_encode_worker {
+
+  const wkt_input& x;
+  translation& output;
+  bool little;
+  long srid;
+
+  wkb_encode_worker(const wkt_input& x, translation& output, bool little, long srid)
+    : x(x), output(output), little(little), srid(srid) {}
+
+  void operator()(unsigned int i){
+    if(x.is_na(i)){
+      return;
+    }
+    wkb_writer writer(output.values[i], little, srid);
+    try {
+      x.read(i, writer);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.errors[i] = e.what();
+    }
+  }
+};
+
+struct wkb_decode_worker {
+
+  const wkt_input& x;
+  translation& output;
+  int precision;
+  bool trim;
+
+  wkb_decode_worker(const wkt_input& x, translation& output, int precision, bool trim)
+    : x(x), output(output), precision(precision), trim(trim) {}
+
+  void operator()(unsigned int i){
+    if(x.is_na(i)){
+      return;
+    }
+    wkt_text_writer writer(output.values[i], precision, trim);
+    try {
+      x.read(i, writer);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.errors[i] = e.what();
+    }
+  }
+};
+
+// [[Rcpp::export]]
+List wkt_wkb_(SEXP x, int endian, int srid, SEXP nthreads = R_NilValue){
+
+  if(endian != 0 && endian != 1){
+    Rcpp::stop("'endian' must be 0 (big endian) or 1 (little endian)");
+  }
+
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  translation output(input_size);
+  parallel_for(input_size, resolve_threads(nthreads),
+               wkb_encode_worker(input, output, endian == 1, srid == NA_INTEGER ? -1 : srid));
+  output.check();
+
+  List out(input_size);
+  for(unsigned int i = 0; i < input_size; i++){
+    if(input.is_na(i)){
+      out[i] = R_NilValue;
+      continue;
+    }
+    RawVector holding(output.values[i].size());
+    std::memcpy(RAW(holding), output.values[i].data(), output.values[i].size());
+    out[i] = holding;
+  }
+  return out;
+}
+
+// [[Rcpp::export]]
+CharacterVector wkb_wkt_(List x, int precision, bool trim, SEXP nthreads = R_NilValue){
+
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  translation output(input_size);
+  parallel_for(input_size, resolve_threads(nthreads),
+               wkb_decode_worker(input, output, precision, trim));
+  output.check();
+
+  CharacterVector out(input_size);
+  for(unsigned int i = 0; i < input_size; i++){
+    if(input.is_na(i)){
+      out[i] = NA_STRING;
+    } else {
+      out[i] = Rf_mkCharLenCE(output.values[i].data(), output.values[i].size(), CE_UTF8);
+    }
+  }
+  return out;
+}
@@ -0,0 +1,578 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include <limits>
+#include <boost/cstdint.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include "reader.h"
+
+#ifndef __WKT_WKB__
+#define __WKT_WKB__
+namespace wkt_utils {
+
+  /**
+   * The exception thrown when a WKB object can't be read. Derives from
+   * read_wkt_exception so that everything already treating that as "this
+   * object could not be read" handles binary input the same way.
+   */
+  class read_wkb_exception : public boost::geometry::read_wkt_exception {
+  public:
+    read_wkb_exception(const std::string& message)
+      : boost::geometry::read_wkt_exception(message, ""), message(message) {}
+    virtual ~read_wkb_exception() throw() {}
+    virtual const char* what() const throw() {
+      return message.c_str();
+    }
+  private:
+    std::string message;
+  };
+
+  /**
+   * A function for checking whether this machine is little-endian
+   */
+  inline bool little_endian(){
+    const boost::uint16_t one = 1;
+    return *reinterpret_cast<const unsigned char*>(&one) == 1;
+  }
+
+  /**
+   * A single-pass scanner over a WKB object. Reads both byte orders, ISO
+   * dimension codes (1001 for POINT Z, 3001 for POINT ZM and so on) and
+   * PostGIS EWKB flags, skipping over any SRID an EWKB header carries.
+   */
+  class wkb_scanner {
+
+  public:
+
+    wkb_scanner(const unsigned char* x, size_t size)
+      : cursor(x), end(x + size), swap(false), host_little(little_endian()) {}
+
+    /**
+     * A function for reading the header of a WKB object - its byte order,
+     * type, dimensions and SRID, if it has one. Whether the object is empty
+     * isn't known until its size has been read, so is_empty is left false.
+     *
+     * @param header a reference to a wkt_header to fill in
+     */
+    inline void read_header(wkt_header& header){
+      need(5);
+      unsigned char order = *cursor++;
+      if(order > 1){
+        fail("Unrecognised byte order");
+      }
+      swap = ((order == 1) != host_little);
+
+      boost::uint32_t code = read_uint32();
+      header.has_z = (code & 0x80000000) != 0;
+      header.has_m = (code & 0x40000000) != 0;
+      if(code & 0x20000000){
+        // The SRID has no bearing on anything read here
+        read_uint32();
+      }
+      code &= 0x0FFFFFFF;
+      unsigned int dims = code / 1000;
+      if(dims > 3){
+        fail("Object could not be recognised as a supported WKB type");
+      }
+      header.has_z = header.has_z || dims == 1 || dims == 3;
+      header.has_m = header.has_m || dims == 2 || dims == 3;
+      header.is_empty = false;
+
+      switch(code % 1000){
+      case 1: header.type = point; break;
+      case 2: header.type = line_string; break;
+      case 3: header.type = polygon; break;
+      case 4: header.type = multi_point; break;
+      case 5: header.type = multi_line_string; break;
+      case 6: header.type = multi_polygon; break;
+      case 7: header.type = geometry_collection; break;
+      default:
+        fail("Object could not be recognised as a supported WKB type");
+      }
+    }
+
+    /**
+     * A function for reading the number of elements that follow, checking
+     * that there are enough bytes left to hold them
+     *
+     * @param smallest the fewest bytes each element can take
+     */
+    inline boost::uint32_t read_count(size_t smallest){
+      boost::uint32_t out = read_uint32();
+      if(out > (size_t) (end - cursor) / smallest){
+        fail("Unexpected end of WKB");
+      }
+      return out;
+    }
+
+    inline void read_coordinate(const wkt_header& header, coordinate& c){
+      c.x = read_double();
+      c.y = read_double();
+      c.z = header.has_z ? read_double() : std::numeric_limits<double>::quiet_NaN();
+      c.m = header.has_m ? read_double() : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /**
+     * A function for checking that nothing remains after the object
+     */
+    inline void finish(){
+      if(cursor != end){
+        fail("Too many bytes");
+      }
+    }
+
+    void fail(const std::string& message) const {
+      throw read_wkb_exception(message);
+    }
+
+  private:
+
+    const unsigned char* cursor;
+    const unsigned char* end;
+    bool swap;
+    bool host_little;
+
+    inline void need(size_t n){
+      if((size_t) (end - cursor) < n){
+        fail("Unexpected end of WKB");
+      }
+    }
+
+    inline void read_bytes(unsigned char* out, size_t n){
+      need(n);
+      if(swap){
+        for(size_t i = 0; i < n; i++){
+          out[i] = cursor[n - 1 - i];
+        }
+      } else {
+        std::memcpy(out, cursor, n);
+      }
+      cursor += n;
+    }
+
+    inline boost::uint32_t read_uint32(){
+      boost::uint32_t out;
+      read_bytes(reinterpret_cast<unsigned char*>(&out), sizeof(out));
+      return out;
+    }
+
+    inline double read_double(){
+      double out;
+      read_bytes(reinterpret_cast<unsigned char*>(&out), sizeof(out));
+      return out;
+    }
+  };
+
+  /**
+   * A function for reading the coordinates of a linestring or ring
+   */
+  template <typename Handler>
+  inline void read_wkb_sequence(wkb_scanner& scanner, const wkt_header& header, Handler& handler,
+                                unsigned int ring){
+    coordinate c;
+    boost::uint32_t size = scanner.read_count(16);
+    handler.begin_ring(ring);
+    for(boost::uint32_t i = 0; i < size; i++){
+      scanner.read_coordinate(header, c);
+      handler.coord(c);
+    }
+    handler.end_ring();
+  }
+
+  /**
+   * A function for reading a member of a multi- type, whose header must give
+   * the type that goes with the collection
+   */
+  inline void read_wkb_member_header(wkb_scanner& scanner, wkt_header& member, supported_types type){
+    scanner.read_header(member);
+    if(member.type != type){
+      scanner.fail("Object does not match the expected WKB type");
+    }
+  }
+
+  /**
+   * A function for reading a WKB object from its header onwards, reporting
+   * the same events to the handler that read_body reports for WKT. Points
+   * made of NaNs are taken to be empty, as PostGIS writes them.
+   *
+   * @param scanner a reference to a wkb_scanner positioned at the start of the object
+   *
+   * @param handler a reference to a handler to report to
+   *
+   * @param depth the number of GeometryCollections the object is inside;
+   * see max_nesting
+   */
+  template <typename Handler>
+  void read_wkb_body(wkb_scanner& scanner, Handler& handler, unsigned int depth = 0){
+
+    wkt_header header;
+    wkt_header member;
+    coordinate c;
+    boost::uint32_t size;
+    scanner.read_header(header);
+
+    switch(header.type){
+    case point:
+      scanner.read_coordinate(header, c);
+      header.is_empty = boost::math::isnan(c.x) && boost::math::isnan(c.y);
+      handler.begin_geometry(header);
+      if(!header.is_empty){
+        handler.coord(c);
+      }
+      break;
+    case line_string:
+      size = scanner.read_count(16);
+      header.is_empty = (size == 0);
+      handler.begin_geometry(header);
+      if(size){
+        handler.begin_ring(0);
+        for(boost::uint32_t i = 0; i < size; i++){
+          scanner.read_coordinate(header, c);
+          handler.coord(c);
+        }
+        handler.end_ring();
+      }
+      break;
+    case polygon:
+      size = scanner.read_count(4);
+      header.is_empty = (size == 0);
+      handler.begin_geometry(header);
+      for(boost::uint32_t i = 0; i < size; i++){
+        read_wkb_sequence(scanner, header, handler, i);
+      }
+      break;
+    case multi_point:
+      size = scanner.read_count(21);
+      header.is_empty = (size == 0);
+      handler.begin_geometry(header);
+      for(boost::uint32_t i = 0; i < size; i++){
+        handler.begin_part(i);
+        read_wkb_member_header(scanner, member, point);
+        scanner.read_coordinate(member, c);
+        if(!(boost::math::isnan(c.x) && boost::math::isnan(c.y))){
+          handler.coord(c);
+        }
+        handler.end_part();
+      }
+      break;
+    case multi_line_string:
+      size = scanner.read_count(9);
+      header.is_empty = (size == 0);
+      handler.begin_geometry(header);
+      for(boost::uint32_t i = 0; i < size; i++){
+        handler.begin_part(i);
+        read_wkb_member_header(scanner, member, line_string);
+        read_wkb_sequence(scanner, member, handler, 0);
+        handler.end_part();
+      }
+      break;
+    case multi_polygon:
+      size = scanner.read_count(9);
+      header.is_empty = (size == 0);
+      handler.begin_geometry(header);
+      for(boost::uint32_t i = 0; i < size; i++){
+        handler.begin_part(i);
+        read_wkb_member_header(scanner, member, polygon);
+        boost::uint32_t rings = scanner.read_count(4);
+        for(boost::uint32_t j = 0; j < rings; j++){
+          read_wkb_sequence(scanner, member, handler, j);
+        }
+        handler.end_part();
+      }
+      break;
+    default:
+      if(!Handler::collections){
+        scanner.fail("Object could not be recognised as a supported WKB type");
+      }
+      if(depth == max_nesting){
+        scanner.fail("GeometryCollections are too deeply nested");
+      }
+      size = scanner.read_count(9);
+      header.is_empty = (size == 0);
+      handler.begin_geometry(header);
+      for(boost::uint32_t i = 0; i < size; i++){
+        handler.begin_part(i);
+        read_wkb_body(scanner, handler, depth + 1);
+        handler.end_part();
+      }
+    }
+    handler.end_geometry();
+  }
+
+  /**
+   * A function for reading a complete WKB object into a handler
+   *
+   * @param x a pointer to the WKB object
+   *
+   * @param size the number of bytes in x
+   *
+   * @param handler a reference to a handler to report to
+   */
+  template <typename Handler>
+  void read_wkb_geometry(const unsigned char* x, size_t size, Handler& handler){
+    wkb_scanner scanner(x, size);
+    read_wkb_body(scanner, handler);
+    scanner.finish();
+  }
+
+  /**
+   * A function for identifying the type of a WKB object from its header
+   *
+   * @param x a pointer to the WKB object
+   *
+   * @param size the number of bytes in x
+   *
+   * @return a value from the supported_types enum; unsupported_type if the
+   * header can't be read
+   */
+  inline supported_types wkb_type(const unsigned char* x, size_t size){
+    wkb_scanner scanner(x, size);
+    wkt_header header;
+    try {
+      scanner.read_header(header);
+    } catch (read_wkb_exception &e){
+      return unsupported_type;
+    }
+    return header.type;
+  }
+
+  /**
+   * A function for reading a WKB object into a boost::geometry object; the
+   * binary counterpart to read_wkt
+   *
+   * @param x a pointer to the WKB object
+   *
+   * @param size the number of bytes in x
+   *
+   * @param geom a reference to the boost::geometry object to fill in
+   */
+  template <typename Geometry>
+  void read_wkb(const unsigned char* x, size_t size, Geometry& geom){
+    typedef geometry_builder<Geometry> builder_type;
+    builder_type builder(geom);
+
+    if(wkb_type(x, size) != builder_type::type){
+      boost::geometry::clear(geom);
+      throw read_wkb_exception("Object does not match the expected WKB type");
+    }
+    read_wkb_geometry(x, size, builder);
+  }
+
+  /**
+   * A handler that writes WKB as an object is read, from WKT or from WKB in
+   * another byte order. Counts that WKB puts ahead of the elements they count
+   * are written as placeholders and filled in once the elements have been seen.
+   * Dimensions use ISO codes unless an SRID is given, in which case the object
+   * is written as PostGIS EWKB.
+   */
+  struct wkb_writer : wkt_handler {
+
+    static const bool collections = true;
+
+    struct frame {
+      supported_types type;
+      bool has_z;
+      bool has_m;
+      size_t parts_at;
+      boost::uint32_t parts;
+      size_t rings_at;
+      boost::uint32_t rings;
+      size_t points_at;
+      boost::uint32_t points;
+    };
+
+    std::string& out;
+    bool little;
+    bool swap;
+    long srid;
+    std::vector < frame > frames;
+
+    /**
+     * @param out a reference to the string to append WKB to
+     *
+     * @param little whether to write little-endian (rather than big-endian) WKB
+     *
+     * @param srid an SRID to write, or -1 to write ISO WKB without one
+     */
+    wkb_writer(std::string& out, bool little, long srid)
+      : out(out), little(little), swap(little != little_endian()), srid(srid) {}
+
+    inline void begin_geometry(const wkt_header& header){
+      write_header(header.type, header.has_z, header.has_m, frames.empty());
+      frame f;
+      f.type = header.type;
+      f.has_z = header.has_z;
+      f.has_m = header.has_m;
+      f.points = 0;
+
+      switch(header.type){
+      case point:
+        break;
+      case line_string:
+        f.points_at = placeholder();
+        break;
+      case polygon:
+        f.rings_at = placeholder();
+        f.rings = 0;
+        break;
+      default:
+        f.parts_at = placeholder();
+        f.parts = 0;
+      }
+      frames.push_back(f);
+    }
+
+    inline void end_geometry(){
+      frame& f = frames.back();
+      switch(f.type){
+      case point:
+        if(!f.points){
+          write_empty_point(f);
+        }
+        break;
+      case line_string:
+        patch(f.points_at, f.points);
+        break;
+      case polygon:
+        patch(f.rings_at, f.rings);
+        break;
+      default:
+        patch(f.parts_at, f.parts);
+      }
+      frames.pop_back();
+    }
+
+    inline void begin_part(unsigned int){
+      frame& f = frames.back();
+      f.parts++;
+      f.points = 0;
+      switch(f.type){
+      case multi_point:
+        write_header(point, f.has_z, f.has_m, false);
+        break;
+      case multi_line_string:
+        write_header(line_string, f.has_z, f.has_m, false);
+        f.points_at = placeholder();
+        break;
+      case multi_polygon:
+        write_header(polygon, f.has_z, f.has_m, false);
+        f.rings_at = placeholder();
+        f.rings = 0;
+        break;
+      default:
+        // GeometryCollection members write their own headers
+        break;
+      }
+    }
+
+    inline void end_part(){
+      frame& f = frames.back();
+      switch(f.type){
+      case multi_point:
+        if(!f.points){
+          write_empty_point(f);
+        }
+        break;
+      case multi_line_string:
+        patch(f.points_at, f.points);
+        break;
+      case multi_polygon:
+        patch(f.rings_at, f.rings);
+        break;
+      default:
+        break;
+      }
+    }
+
+    inline void begin_ring(unsigned int){
+      frame& f = frames.back();
+      if(f.type == polygon || f.type == multi_polygon){
+        f.rings++;
+        f.points = 0;
+        f.points_at = placeholder();
+      }
+    }
+
+    inline void end_ring(){
+      frame& f = frames.back();
+      if(f.type == polygon || f.type == multi_polygon){
+        patch(f.points_at, f.points);
+      }
+    }
+
+    inline void coord(const coordinate& c){
+      frame& f = frames.back();
+      f.points++;
+      write_double(c.x);
+      write_double(c.y);
+      if(f.has_z){
+        write_double(c.z);
+      }
+      if(f.has_m){
+        write_double(c.m);
+      }
+    }
+
+    inline void write_header(supported_types type, bool has_z, bool has_m, bool top){
+      boost::uint32_t code;
+      switch(type){
+      case point: code = 1; break;
+      case line_string: code = 2; break;
+      case polygon: code = 3; break;
+      case multi_point: code = 4; break;
+      case multi_line_string: code = 5; break;
+      case multi_polygon: code = 6; break;
+      default: code = 7;
+      }
+      out += (char) (little ? 1 : 0);
+      if(srid < 0){
+        write_uint32(code + (has_z ? 1000 : 0) + (has_m ? 2000 : 0));
+        return;
+      }
+      code |= (has_z ? 0x80000000 : 0) | (has_m ? 0x40000000 : 0) | (top ? 0x20000000 : 0);
+      write_uint32(code);
+      if(top){
+        write_uint32((boost::uint32_t) srid);
+      }
+    }
+
+    inline void write_empty_point(const frame& f){
+      double nan = std::numeric_limits<double>::quiet_NaN();
+      unsigned int dims = 2 + f.has_z + f.has_m;
+      for(unsigned int i = 0; i < dims; i++){
+        write_double(nan);
+      }
+    }
+
+    inline size_t placeholder(){
+      size_t at = out.size();
+      write_uint32(0);
+      return at;
+    }
+
+    inline void patch(size_t at, boost::uint32_t value){
+      write_bytes(reinterpret_cast<const unsigned char*>(&value), sizeof(value), &out[at]);
+    }
+
+    inline void write_uint32(boost::uint32_t x){
+      out.resize(out.size() + sizeof(x));
+      write_bytes(reinterpret_cast<const unsigned char*>(&x), sizeof(x), &out[out.size() - sizeof(x)]);
+    }
+
+    inline void write_double(double x){
+      out.resize(out.size() + sizeof(x));
+      write_bytes(reinterpret_cast<const unsigned char*>(&x), sizeof(x), &out[out.size() - sizeof(x)]);
+    }
+
+    inline void write_bytes(const unsigned char* x, size_t n, char* to){
+      if(swap){
+        for(size_t i = 0; i < n; i++){
+          to[i] = x[n - 1 - i];
+        }
+      } else {
+        std::memcpy(to, x, n);
+      }
+    }
+  };
+}
+#endif
@@ -0,0 +1,223 @@
+#include <Rcpp.h>
+using namespace Rcpp;
+#include "utils.h"
+using namespace wkt_utils;
+
+/**
+ * A handler that builds the nested list wkt2geojson returns as a WKT object
+ * is read: a coordinate vector for points, a matrix (one row per coordinate)
+ * for multipoints and linestrings, and lists of matrices for everything above
+ * that. Z values are kept and M values dropped, as GeoJSON has no place for
+ * them.
+ */
+struct geojson_handler : wkt_handler {
+
+  static const bool collections = true;
+
+  struct frame {
+    wkt_header header;
+    std::vector < RObject > parts;
+    std::vector < RObject > rings;
+  };
+
+  int fmt;
+  bool feature;
+  bool numeric;
+  bool simplify;
+
+  std::vector < frame > frames;
+  std::vector < double > values;
+  bool has_z;
+  // Room for "%.20f" of -DBL_MAX: a sign, 309 digits, a point and 20 decimals
+  char buffer[400];
+  RObject result;
+
+  geojson_handler(int fmt, bool feature, bool numeric, bool simplify)
+    : fmt(fmt), feature(feature), numeric(numeric), simplify(simplify) {}
+
+  inline void begin_geometry(const wkt_header& header){
+    frame f;
+    f.header = header;
+    frames.push_back(f);
+    clear_sequence();
+  }
+
+  inline void begin_ring(unsigned int){
+    clear_sequence();
+  }
+
+  inline void coord(const coordinate& c){
+    values.push_back(c.x);
+    values.push_back(c.y);
+    values.push_back(c.z);
+    if(!ISNAN(c.z)){
+      has_z = true;
+    }
+  }
+
+  inline void end_ring(){
+    frame& f = frames.back();
+    if(f.header.type == multi_line_string){
+      f.parts.push_back(sequence(false));
+    } else {
+      f.rings.push_back(sequence(false));
+    }
+  }
+
+  inline void end_part(){
+    frame& f = frames.back();
+    if(f.header.type == multi_polygon){
+      f.parts.push_back(as_list(f.rings));
+      f.rings.clear();
+    }
+  }
+
+  void end_geometry(){
+    frame& f = frames.back();
+    RObject out;
+
+    switch(f.header.type){
+    case point:
+      out = geometry("Point", sequence(true));
+      break;
+    case multi_point:
+      if(simplify && frames.size() == 1 && values.size() == 3){
+        out = geometry("Point", sequence(true));
+      } else {
+        out = geometry("MultiPoint", sequence(false));
+      }
+      break;
+    case line_string:
+      if(f.rings.size()){
+        out = geometry("LineString", f.rings[0]);
+      } else {
+        out = geometry("LineString", sequence(false));
+      }
+      break;
+    case polygon:
+      out = geometry("Polygon", as_list(f.rings));
+      break;
+    case multi_line_string:
+      if(simplify && frames.size() == 1 && f.parts.size() == 1){
+        out = geometry("LineString", f.parts[0]);
+      } else {
+        out = geometry("MultiLineString", as_list(f.parts));
+      }
+      break;
+    case multi_polygon:
+      if(simplify && frames.size() == 1 && f.parts.size() == 1){
+        out = geometry("Polygon", f.parts[0]);
+      } else {
+        out = geometry("MultiPolygon", as_list(f.parts));
+      }
+      break;
+    default:
+      // Collections are never wrapped in a Feature; their members are
+      out = List::create(_["type"] = "GeometryCollection",
+                         _["geometries"] = as_list(f.parts));
+    }
+
+    frames.pop_back();
+    if(frames.size()){
+      frames.back().parts.push_back(out);
+    } else {
+      result = out;
+    }
+  }
+
+  inline void clear_sequence(){
+    values.clear();
+    has_z = false;
+  }
+
+  inline RObject as_list(const std::vector < RObject >& x){
+    List out(x.size());
+    for(unsigned int i = 0; i < x.size(); i++){
+      out[i] = x[i];
+    }
+    return out;
+  }
+
+  inline SEXP format(double x){
+    if(ISNAN(x)){
+      return NA_STRING;
+    }
+    snprintf(buffer, sizeof(buffer), "%.*f", fmt, x);
+    return Rf_mkChar(buffer);
+  }
+
+  // The coordinates read since the sequence was last cleared, as a matrix or
+  // (for a single position) a vector
+  RObject sequence(bool position){
+    unsigned int rows = values.size() / 3;
+    unsigned int cols = has_z ? 3 : 2;
+    if(position){
+      rows = rows ? 1 : 0;
+    }
+
+    if(numeric){
+      NumericVector out(rows * cols);
+      for(unsigned int i = 0; i < rows; i++){
+        for(unsigned int j = 0; j < cols; j++){
+          out[i + (j * rows)] = values[(i * 3) + j];
+        }
+      }
+      if(!position){
+        out.attr("dim") = Dimension(rows, cols);
+      }
+      return out;
+    }
+
+    CharacterVector out(rows * cols);
+    for(unsigned int i = 0; i < rows; i++){
+      for(unsigned int j = 0; j < cols; j++){
+        out[i + (j * rows)] = format(values[(i * 3) + j]);
+      }
+    }
+    if(!position){
+      out.attr("dim") = Dimension(rows, cols);
+    }
+    return out;
+  }
+
+  inline RObject geometry(const char* type, const RObject& coordinates){
+    List out = List::create(_["type"] = type,
+                            _["coordinates"] = coordinates);
+    if(feature){
+      return List::create(_["type"] = "Feature",
+                          _["geometry"] = out);
+    }
+    return out;
+  }
+};
+
+// [[Rcpp::export]]
+List wkt2geojson_(SEXP str, int fmt, bool feature, bool numeric, bool simplify){
+
+  if(fmt < 0 || fmt > 20){
+    Rcpp::stop("'fmt' must be between 0 and 20");
+  }
+
+  wkt_input input(str);
+  unsigned int input_size = input.length();
+  List output(input_size);
+  geojson_handler handler(fmt, feature, numeric, simplify);
+
+  for(unsigned int i = 0; i < input_size; i++){
+    if((i % 10000) == 0){
+      Rcpp::checkUserInterrupt();
+    }
+    if(input.is_na(i)){
+      continue;
+    }
+    handler.frames.clear();
+    try {
+      input.read(i, handler, true);
+    } catch (boost::geometry::read_wkt_exception &e){
+      Rcpp::stop(e.what());
+    }
+    handler.result.attr("class") = "geojson";
+    output[i] = handler.result;
+  }
+  return output;
+}
@@ -2,167 +2,142 @@
 using namespace Rcpp;
 #include "def.h"
 #include "utils.h"
+#include "parallel.h"
+#include "streaming.h"
+#include "file_input.h"
+#include "stats.h"
+#include "memo.h"
 using namespace wkt_utils;
 
-template <typename T>
-void wkt_bounding_single_matrix(std::string wkt, T& obj, box_type& holding, unsigned int& i, NumericMatrix& output){
-
-  try {
-    boost::geometry::read_wkt(wkt, obj);
-  } catch (boost::geometry::read_wkt_exception &e){
-    output(i, 0) = NA_REAL;
-    output(i, 1) = NA_REAL;
-    output(i, 2) = NA_REAL;
-    output(i, 3) = NA_REAL;
-    return;
+static const char* bounding_names[] = {"min_x", "min_y", "max_x", "max_y",
+                                       "min_z", "max_z", "min_m", "max_m"};
+
+/**
+ * Fills in one row of bounding box columns. The handler's type decides,
+ * at compile time, whether z and m ranges are tracked and written too.
+ */
+template <typename Handler>
+struct bounding_worker {
+
+  const wkt_input& wkt;
+  double* const* cols;
+  unsigned int width;
+  call_stats& stats;
+
+  bounding_worker(const wkt_input& wkt, double* const* cols, unsigned int width,
+                  call_stats& stats)
+    : wkt(wkt), cols(cols), width(width), stats(stats) {}
+
+  inline void set_na(unsigned int i){
+    for(unsigned int j = 0; j < width; j++){
+      cols[j][i] = NA_REAL;
+    }
   }
-  holding = boost::geometry::return_envelope<box_type>(obj);
-  output(i, 0) = holding.min_corner().get<0>();
-  output(i, 1) = holding.min_corner().get<1>();
-  output(i, 2) = holding.max_corner().get<0>();
-  output(i, 3) = holding.max_corner().get<1>();
-}
 
-NumericMatrix wkt_bounding_matrix(CharacterVector& wkt){
+  inline void set_range(unsigned int i, unsigned int col, const value_range& range){
+    cols[col][i] = range.is_empty() ? NA_REAL : range.min;
+    cols[col + 1][i] = range.is_empty() ? NA_REAL : range.max;
+  }
 
-  unsigned int input_size = wkt.size();
-  NumericMatrix output(input_size, 4);
+  inline void set_extra(unsigned int, const envelope_handler&){}
 
-  // Holding objects
-  point_type pt;
-  linestring_type ls;
-  polygon_type poly;
-  multipoint_type multip;
-  multilinestring_type multil;
-  multipolygon_type multipoly;
-  box_type box_inst;
-  std::string holding;
+  inline void set_extra(unsigned int i, const zm_envelope_handler& envelope){
+    set_range(i, 4, envelope.z);
+    set_range(i, 6, envelope.m);
+  }
 
-  for(unsigned int i = 0; i < input_size; i++){
-    if((i % 10000) == 0){
-      Rcpp::checkUserInterrupt();
+  void operator()(unsigned int i){
+    row_stats row(stats.local());
+    if(wkt.is_na(i)){
+      row.row(-1);
+      set_na(i);
+      return;
+    }
+    row.row(wkt.size(i));
+    // A fresh handler each row, so a failed read leaves nothing behind
+    Handler envelope;
+    try {
+      wkt.read(i, envelope);
+    } catch (boost::geometry::read_wkt_exception &e){
+      set_na(i);
+      row.lap(parse_phase);
+      row.failed(wkt, i);
+      return;
     }
-    if(wkt[i] == NA_STRING){
-      output(i, 0) = NA_REAL;
-      output(i, 1) = NA_REAL;
-      output(i, 2) = NA_REAL;
-      output(i, 3) = NA_REAL;
-    } else {
-      holding = Rcpp::as<std::string>(wkt[i]);
-      switch(id_type(holding)){
-        case point:
-          wkt_bounding_single_matrix(holding, pt, box_inst, i, output);
-          break;
-        case line_string:
-          wkt_bounding_single_matrix(holding, ls, box_inst, i, output);
-          break;
-        case polygon:
-          wkt_bounding_single_matrix(holding, poly, box_inst, i, output);
-          break;
-        case multi_point:
-          wkt_bounding_single_matrix(holding, multip, box_inst, i, output);
-          break;
-        case multi_line_string:
-          wkt_bounding_single_matrix(holding, multil, box_inst, i, output);
-          break;
-        case multi_polygon:
-          wkt_bounding_single_matrix(holding, multipoly, box_inst, i, output);
-          break;
-        default:
-          output(i, 0) = NA_REAL;
-          output(i, 1) = NA_REAL;
-          output(i, 2) = NA_REAL;
-          output(i, 3) = NA_REAL;
-      }
+    row.lap(parse_phase);
+    if(envelope.box.is_empty()){
+      set_na(i);
+      return;
     }
+    cols[0][i] = envelope.box.min_x;
+    cols[1][i] = envelope.box.min_y;
+    cols[2][i] = envelope.box.max_x;
+    cols[3][i] = envelope.box.max_y;
+    set_extra(i, envelope);
+  }
+};
+
+// Boxes of repeated objects, kept between calls if the wellknown.cache
+// option is set
+static result_cache bounding_cache(4);
+static result_cache zm_bounding_cache(8);
+
+void fill_bounding(const wkt_input& input, double* const* cols, bool zm, int nthreads,
+                   call_stats& stats){
+  if(zm){
+    row_memo memo(input, cols, 8, zm_bounding_cache);
+    memo.run(nthreads, bounding_worker<zm_envelope_handler>(input, cols, 8, stats));
+    memo.finish();
+  } else {
+    row_memo memo(input, cols, 4, bounding_cache);
+    memo.run(nthreads, bounding_worker<envelope_handler>(input, cols, 4, stats));
+    memo.finish();
   }
-  colnames(output) = CharacterVector::create("min_x", "min_y", "max_x", "max_y");
-  return output;
 }
 
-template <typename T>
-void wkt_bounding_single_df(std::string wkt, T& obj, box_type& holding, unsigned int& i,
-                            NumericVector& min_x, NumericVector& max_x, NumericVector& min_y,
-                            NumericVector& max_y){
-
-  try {
-    boost::geometry::read_wkt(wkt, obj);
-  } catch (boost::geometry::read_wkt_exception &e){
-    min_x[i] = NA_REAL;
-    max_x[i] = NA_REAL;
-    min_y[i] = NA_REAL;
-    max_y[i] = NA_REAL;
-    return;
+NumericMatrix wkt_bounding_matrix(const wkt_input& input, bool zm, int nthreads,
+                                  call_stats& stats){
+
+  unsigned int input_size = input.length();
+  unsigned int width = zm ? 8 : 4;
+  NumericMatrix output(input_size, width);
+  double* cols[8];
+  for(unsigned int j = 0; j < width; j++){
+    cols[j] = REAL(output) + (j * input_size);
   }
-  holding = boost::geometry::return_envelope<box_type>(obj);
-  min_x[i] = holding.min_corner().get<0>();
-  max_x[i] = holding.max_corner().get<0>();
-  min_y[i] = holding.min_corner().get<1>();
-  max_y[i] = holding.max_corner().get<1>();
+  fill_bounding(input, cols, zm, nthreads, stats);
 
+  row_stats row(stats.local());
+  CharacterVector names(width);
+  for(unsigned int j = 0; j < width; j++){
+    names[j] = bounding_names[j];
+  }
+  colnames(output) = names;
+  row.lap(output_phase);
+  return output;
 }
 
-DataFrame wkt_bounding_df(CharacterVector& wkt){
-
-  unsigned int input_size = wkt.size();
-  NumericVector min_x(input_size);
-  NumericVector max_x(input_size);
-  NumericVector min_y(input_size);
-  NumericVector max_y(input_size);
-
-  // Holding objects
-  point_type pt;
-  linestring_type ls;
-  polygon_type poly;
-  multipoint_type multip;
-  multilinestring_type multil;
-  multipolygon_type multipoly;
-  box_type box_inst;
-  std::string holding;
-
-  for(unsigned int i = 0; i < input_size; i++){
-    if((i % 10000) == 0){
-      Rcpp::checkUserInterrupt();
-    }
-    if(wkt[i] == NA_STRING){
-      min_x[i] = NA_REAL;
-      max_x[i] = NA_REAL;
-      min_y[i] = NA_REAL;
-      max_y[i] = NA_REAL;
-    } else {
-      holding = Rcpp::as<std::string>(wkt[i]);
-      switch(id_type(holding)){
-        case point:
-          wkt_bounding_single_df(holding, pt, box_inst, i, min_x, max_x, min_y, max_y);
-          break;
-        case line_string:
-          wkt_bounding_single_df(holding, ls, box_inst, i, min_x, max_x, min_y, max_y);
-          break;
-        case polygon:
-          wkt_bounding_single_df(holding, poly, box_inst, i, min_x, max_x, min_y, max_y);
-          break;
-        case multi_point:
-          wkt_bounding_single_df(holding, multip, box_inst, i, min_x, max_x, min_y, max_y);
-          break;
-        case multi_line_string:
-          wkt_bounding_single_df(holding, multil, box_inst, i, min_x, max_x, min_y, max_y);
-          break;
-        case multi_polygon:
-          wkt_bounding_single_df(holding, multipoly, box_inst, i, min_x, max_x, min_y, max_y);
-          break;
-        default:
-          min_x[i] = NA_REAL;
-          max_x[i] = NA_REAL;
-          min_y[i] = NA_REAL;
-          max_y[i] = NA_REAL;
-      }
-    }
+List wkt_bounding_df(const wkt_input& input, bool zm, int nthreads, call_stats& stats){
+
+  unsigned int input_size = input.length();
+  unsigned int width = zm ? 8 : 4;
+  List output(width);
+  CharacterVector names(width);
+  double* cols[8];
+  for(unsigned int j = 0; j < width; j++){
+    NumericVector col(input_size);
+    cols[j] = REAL(col);
+    output[j] = col;
+    names[j] = bounding_names[j];
   }
+  fill_bounding(input, cols, zm, nthreads, stats);
 
-  return DataFrame::create(_["min_x"] = min_x,
-                           _["min_y"] = min_y,
-                           _["max_x"] = max_x,
-                           _["max_y"] = max_y);
+  row_stats row(stats.local());
+  output.attr("names") = names;
+  output.attr("class") = "data.frame";
+  output.attr("row.names") = IntegerVector::create(NA_INTEGER, -static_cast<int>(input_size));
+  row.lap(output_phase);
+  return output;
 }
 
 //' @title Convert WKT Objects into Bounding Boxes
@@ -170,23 +145,96 @@ DataFrame wkt_bounding_df(CharacterVector& wkt){
 //' linestrings, polygons, and multi-points/linestrings/polygons) into 
 //' bounding boxes.
 //' @export
-//' @param wkt a character vector of WKT objects.
+//' @param wkt a character vector of WKT objects, or a list of raw vectors
+//' of WKB objects (or a single raw vector), or a `wkt_parsed` object from
+//' [wkt_parse()].
 //' @param as_matrix whether to return the results as a matrix (`TRUE`)
 //' or data.frame (`FALSE`). Set to `FALSE` by default.
+//' @param zm whether to also return the ranges of any Z and M values, as
+//' four more columns. Set to `FALSE` by default.
+//' @template nthreads
 //' @return either a data.frame or matrix, depending on the value of
 //' `as_matrix`, containing four columns - `min_x`, `min_y`, `max_x` and 
-//' `max_y` - representing the various points of the bounding box. In the
+//' `max_y` - representing the various points of the bounding box (and,
+//' if `zm` is `TRUE`, `min_z`, `max_z`, `min_m` and `max_m`; these are `NA`
+//' for objects without Z or M values). In the
 //' event that a valid bounding box cannot be generated
 //' (due to the invalidity or incompatibility of the WKT object), NAs will
 //' be returned.
+//' @details Identical WKT strings are only read once per call, and with
+//' the `wellknown.cache` option set, boxes are remembered between calls
+//' too; see the Caching section of [wellknown-package].
 //' @seealso [bounding_wkt()], to turn R-size bounding boxes into WKT objects
 //' @examples
 //' wkt_bounding("POLYGON ((30 10, 40 40, 20 40, 10 20, 30 10))")
+//' wkt_bounding(wkt_wkb("POLYGON ((30 10, 40 40, 20 40, 10 20, 30 10))"))
+//' wkt_bounding("LINESTRING ZM (0 0 4 100, 1 1 2 200)", zm = TRUE)
 // [[Rcpp::export]]
-SEXP wkt_bounding(CharacterVector wkt, bool as_matrix = false){
+SEXP wkt_bounding(SEXP wkt, bool as_matrix = false, bool zm = false, SEXP nthreads = R_NilValue){
+
+  int threads = resolve_threads(nthreads);
+  call_stats stats("wkt_bounding", threads);
+  wkt_input input(wkt);
+  SEXP result = as_matrix ? Rcpp::wrap(wkt_bounding_matrix(input, zm, threads, stats))
+                          : Rcpp::wrap(wkt_bounding_df(input, zm, threads, stats));
+  stats.finish();
+  return result;
+}
 
+// [[Rcpp::export]]
+SEXP wkt_bounding_file_(std::string path, std::string format, std::string column_name,
+                        int column_index, int chunk_size, bool as_matrix, bool zm,
+                        SEXP nthreads){
+
+  int threads = resolve_threads(nthreads);
+  call_stats stats("wkt_bounding_file", threads);
+  wkt_file file(path, get_file_format(format), column_name, column_index, chunk_size);
+  unsigned int width = zm ? 8 : 4;
+
+  // The file's length isn't known until it's been read, so the columns grow
+  // a chunk at a time; they're the only thing that does
+  std::vector < std::vector < double > > columns(width);
+  size_t rows = 0;
+  while(file.next()){
+    rows = file.first_row() + file.rows();
+    double* cols[8];
+    for(unsigned int j = 0; j < width; j++){
+      columns[j].resize(rows);
+      cols[j] = columns[j].data() + file.first_row();
+    }
+    fill_bounding(file.input(), cols, zm, threads, stats);
+    checkUserInterrupt();
+  }
+
+  row_stats row(stats.local());
+  CharacterVector names(width);
+  for(unsigned int j = 0; j < width; j++){
+    names[j] = bounding_names[j];
+  }
+
+  SEXP result;
   if(as_matrix){
-    return Rcpp::wrap(wkt_bounding_matrix(wkt));
+    NumericMatrix output(rows, width);
+    for(unsigned int j = 0; j < width; j++){
+      std::copy(columns[j].begin(), columns[j].end(), REAL(output) + (j * rows));
+      std::vector < double >().swap(columns[j]);
+    }
+    colnames(output) = names;
+    result = Rcpp::wrap(output);
+  } else {
+    List output(width);
+    for(unsigned int j = 0; j < width; j++){
+      NumericVector col(rows);
+      std::copy(columns[j].begin(), columns[j].end(), REAL(col));
+      std::vector < double >().swap(columns[j]);
+      output[j] = col;
+    }
+    output.attr("names") = names;
+    output.attr("class") = "data.frame";
+    output.attr("row.names") = IntegerVector::create(NA_INTEGER, -static_cast<int>(rows));
+    result = Rcpp::wrap(output);
   }
-  return Rcpp::wrap(wkt_bounding_df(wkt));
+  row.lap(output_phase);
+  stats.finish();
+  return result;
 }
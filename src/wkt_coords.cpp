@@ -1,121 +1,258 @@
 #include <Rcpp.h>
 using namespace Rcpp;
 #include "utils.h"
+#include "parallel.h"
 using namespace wkt_utils;
 //[[Rcpp::depends(BH)]]
 
-void get_coords_single(std::string& x,
-                       std::list<s_polygon_type>& output,
-                       unsigned int& out_size){
-
-  s_polygon_type p;
-  try {
-    boost::geometry::read_wkt(x, p);
-  } catch (...){
-    output.push_back(p);
-    out_size++;
-    return;
+/**
+ * A handler that counts an object's coordinates, for sizing the output
+ */
+struct count_handler : wkt_handler {
+
+  static const bool collections = true;
+
+  size_t count;
+
+  count_handler() : count(0) {}
+
+  inline void coord(const coordinate&){
+    count++;
   }
-  output.push_back(p);
-  if(p.outer().size()){
-    out_size += p.outer().size();
-  } else {
-    out_size++;
+};
+
+/**
+ * A handler that writes an object's coordinates into preallocated output
+ * columns, along with the part and ring each belongs to. Parts are numbered
+ * from 1 across the whole object - each point, linestring or polygon, whether
+ * it stands alone, is one of a multi-part object's parts or sits in a
+ * GeometryCollection, is a part of its own. Rings are coded 1 for a
+ * polygon's outer ring and k + 1 for its kth inner ring; coordinates outside
+ * polygons have no ring.
+ */
+struct fill_handler : wkt_handler {
+
+  static const bool collections = true;
+
+  int* part_col;
+  int* ring_col;
+  double* x_col;
+  double* y_col;
+  double* z_col;
+  double* m_col;
+
+  int part;
+  int ring;
+  bool multi;
+  bool areal;
+
+  fill_handler(int* part_col, int* ring_col, double* x_col, double* y_col, double* z_col,
+               double* m_col)
+    : part_col(part_col), ring_col(ring_col), x_col(x_col), y_col(y_col), z_col(z_col),
+      m_col(m_col), part(0), ring(NA_INTEGER), multi(false), areal(false) {}
+
+  inline void begin_geometry(const wkt_header& header){
+    multi = (header.type == multi_point || header.type == multi_line_string ||
+             header.type == multi_polygon);
+    areal = (header.type == polygon || header.type == multi_polygon);
+    ring = NA_INTEGER;
+    if(header.type == point || header.type == line_string || header.type == polygon){
+      part++;
+    }
   }
-  for(unsigned int i = 0; i < p.inners().size(); i++){
-    out_size += p.inners()[i].size();
+
+  inline void end_geometry(){
+    // So that a collection's begin_part, which comes next, isn't taken for
+    // a multi-part object's
+    multi = false;
   }
-}
 
+  inline void begin_part(unsigned int){
+    if(multi){
+      part++;
+    }
+  }
 
-void extract_coords(s_polygon_type& p, unsigned int& outsize,
-                    IntegerVector& object,
-                    CharacterVector& ring, NumericVector& lat,
-                    NumericVector& lng, unsigned int obj){
-  if(p.outer().size() == 0){
-    object[outsize] = obj;
-    ring[outsize] = NA_STRING;
-    lat[outsize] = NA_REAL;
-    lng[outsize] = NA_REAL;
-    outsize++;
-    return;
+  inline void begin_ring(unsigned int i){
+    if(areal){
+      ring = i + 1;
+    }
   }
-  std::vector < s_point_type > points = p.outer();
-  for(unsigned int i = 0; i < points.size(); i++){
-    object[outsize] = obj;
-    ring[outsize] = "outer";
-    lat[outsize]  = boost::geometry::get<1>(points[i]);
-    lng[outsize]  = boost::geometry::get<0>(points[i]);
-    outsize++;
+
+  inline void coord(const coordinate& c){
+    *part_col++ = part;
+    *ring_col++ = ring;
+    *x_col++ = c.x;
+    *y_col++ = c.y;
+    if(z_col != NULL){
+      *z_col++ = ISNAN(c.z) ? NA_REAL : c.z;
+      *m_col++ = ISNAN(c.m) ? NA_REAL : c.m;
+    }
   }
+};
 
-  if(p.inners().size()){
-    std::string ring_id;
-    s_polygon_type x;
-    for(unsigned int i = 0; i < p.inners().size(); i++){
-      boost::geometry::convert(p.inners()[i], x);
-      ring_id = "inner " + make_string(i+1);
-      for(unsigned int j = 0; j < x.outer().size(); j++){
-        object[outsize] = obj;
-        ring[outsize] = ring_id;
-        lat[outsize]  = boost::geometry::get<1>(x.outer()[j]);
-        lng[outsize]  = boost::geometry::get<0>(x.outer()[j]);
-        outsize++;
-      }
+struct count_worker {
+
+  const wkt_input& wkt;
+  size_t* counts;
+
+  count_worker(const wkt_input& wkt, size_t* counts) : wkt(wkt), counts(counts) {}
+
+  void operator()(unsigned int i){
+    counts[i] = 0;
+    if(wkt.is_na(i)){
+      return;
+    }
+    count_handler handler;
+    try {
+      wkt.read(i, handler);
+    } catch (boost::geometry::read_wkt_exception &e){
+      return;
     }
+    counts[i] = handler.count;
   }
+};
 
-}
+struct fill_worker {
+
+  const wkt_input& wkt;
+  const std::vector < size_t >& offsets;
+  const size_t* counts;
+  int* object;
+  int* part;
+  int* ring;
+  double* lng;
+  double* lat;
+  double* z;
+  double* m;
 
-//' @title Extract Latitude and Longitude from WKT polygons
-//' @description `wkt_coords` extracts lat/long values from WKT polygons,
-//' specifically the outer shell of those polygons (working on the assumption
-//' that said outer edge is what you want).
-//' 
+  fill_worker(const wkt_input& wkt, const std::vector < size_t >& offsets, const size_t* counts,
+              int* object, int* part, int* ring, double* lng, double* lat, double* z, double* m)
+    : wkt(wkt), offsets(offsets), counts(counts), object(object), part(part), ring(ring),
+      lng(lng), lat(lat), z(z), m(m) {}
+
+  void operator()(unsigned int i){
+    size_t at = offsets[i];
+    size_t rows = offsets[i + 1] - at;
+    for(size_t j = 0; j < rows; j++){
+      object[at + j] = i + 1;
+    }
+
+    // An object without coordinates (NA, unreadable or empty) still gets
+    // a row, of NAs
+    if(counts[i] == 0){
+      part[at] = NA_INTEGER;
+      ring[at] = NA_INTEGER;
+      lng[at] = NA_REAL;
+      lat[at] = NA_REAL;
+      if(z != NULL){
+        z[at] = NA_REAL;
+        m[at] = NA_REAL;
+      }
+      return;
+    }
+    // The object was read once already, when counting, so this won't fail;
+    // nothing can be allowed to escape a worker, regardless
+    fill_handler handler(part + at, ring + at, lng + at, lat + at,
+                         z == NULL ? NULL : z + at, m == NULL ? NULL : m + at);
+    try {
+      wkt.read(i, handler);
+    } catch (boost::geometry::read_wkt_exception &e){
+      return;
+    }
+  }
+};
+
+//' @title Extract Coordinates from WKT Objects
+//' @description `wkt_coords` extracts lat/long values from WKT objects of
+//' any type, one row per coordinate, along with the part and (for
+//' polygons) the ring each coordinate belongs to.
+//'
 //' Because it assumes **coordinates**, it also assumes a sphere - say, the
 //' earth - and uses spherical coordinate values.
 //' @export
-//' @param wkt a character vector of WKT objects
-//' @return a data.frame of four columns; `object` (containing which object
-//' the row refers to), `ring` containing which layer of the object the row
-//' refers to, `lng` and `lat`.
+//' @param wkt a character vector of WKT objects, or a list of raw vectors of
+//' WKB objects (or a single raw vector), or a `wkt_parsed` object from
+//' [wkt_parse()]
+//' @param zm whether to also return any Z and M values, as columns `z` and
+//' `m`. Set to `FALSE` by default.
+//' @template nthreads
+//' @return a data.frame of five columns; `object` (containing which object
+//' the row refers to), `part` (which part of the object - a point,
+//' linestring or polygon, numbered from 1 across multi-part objects and
+//' GeometryCollections), `ring` (a factor giving which ring of a polygon the
+//' row refers to: `"outer"`, `"inner 1"`, `"inner 2"` and so on, and `NA`
+//' for points and linestrings), `lng` and `lat` - and, if `zm` is `TRUE`,
+//' `z` and `m`, which are `NA` for coordinates without them. Objects that
+//' are `NA`, can't be read or are empty get a single row with only `object`
+//' filled in.
+//' @details The coordinates are counted in a first pass over the input, so
+//' that the output is allocated once at its exact size and filled in
+//' directly in a second; nothing is held between the two.
 //' @seealso [wkt_bounding()] to extract a bounding box, and [wkt_centroid()]
 //' to extract the centroid.
 //' @examples
 //' wkt_coords("POLYGON ((30 10, 40 40, 20 40, 10 20, 30 10))")
+//' wkt_coords("MULTILINESTRING ((10 10, 20 20), (40 40, 30 30))")
+//' wkt_coords("POLYGON Z ((30 10 1, 40 40 2, 20 40 3, 30 10 1))", zm = TRUE)
 // [[Rcpp::export]]
-DataFrame wkt_coords(CharacterVector wkt){
+DataFrame wkt_coords(SEXP wkt, bool zm = false, SEXP nthreads = R_NilValue){
 
-  unsigned int input_size = wkt.size();
-  std::list<s_polygon_type> holding;
-  std::string str_holding;
-  unsigned int n_size = 0;
+  int threads = resolve_threads(nthreads);
+  wkt_input input(wkt);
+  unsigned int input_size = input.length();
 
+  std::vector < size_t > counts(input_size);
+  parallel_for(input_size, threads, count_worker(input, counts.data()));
+
+  std::vector < size_t > offsets(input_size + 1);
+  offsets[0] = 0;
   for(unsigned int i = 0; i < input_size; i++){
-    if((i % 10000) == 0){
-      Rcpp::checkUserInterrupt();
-    }
-    str_holding = Rcpp::as<std::string>(wkt[i]);
-    get_coords_single(str_holding, holding, n_size);
+    offsets[i + 1] = offsets[i] + (counts[i] ? counts[i] : 1);
   }
+  R_xlen_t n_size = offsets[input_size];
 
-  IntegerVector   object(n_size);
-  CharacterVector ring(n_size);
-  NumericVector   lat(n_size);
-  NumericVector   lng(n_size);
-  s_polygon_type p;
-  unsigned int outsize = 0;
-  unsigned int obj = 1;
-  for(std::list<s_polygon_type>::const_iterator it = holding.begin(), end = holding.end();
-      it != end; ++it) {
-    p = *it;
-    extract_coords(p, outsize, object, ring, lat, lng, obj);
-    obj++;
+  IntegerVector object(n_size);
+  IntegerVector part(n_size);
+  IntegerVector ring(n_size);
+  NumericVector lng(n_size);
+  NumericVector lat(n_size);
+  NumericVector z(zm ? n_size : 0);
+  NumericVector m(zm ? n_size : 0);
+  parallel_for(input_size, threads,
+               fill_worker(input, offsets, counts.data(), INTEGER(object), INTEGER(part),
+                           INTEGER(ring), REAL(lng), REAL(lat), zm ? REAL(z) : NULL,
+                           zm ? REAL(m) : NULL));
+
+  // The ring codes become a factor, with as many inner ring levels as the
+  // most holed polygon needs
+  int rings = 1;
+  const int* codes = INTEGER(ring);
+  for(R_xlen_t i = 0; i < n_size; i++){
+    if(codes[i] != NA_INTEGER && codes[i] > rings){
+      rings = codes[i];
+    }
   }
+  CharacterVector levels(rings);
+  levels[0] = "outer";
+  for(int i = 1; i < rings; i++){
+    levels[i] = "inner " + make_string(i);
+  }
+  ring.attr("levels") = levels;
+  ring.attr("class") = "factor";
 
+  if(zm){
+    return DataFrame::create(_["object"] = object,
+                             _["part"] = part,
+                             _["ring"] = ring,
+                             _["lng"] = lng,
+                             _["lat"] = lat,
+                             _["z"] = z,
+                             _["m"] = m);
+  }
   return DataFrame::create(_["object"] = object,
+                           _["part"] = part,
                            _["ring"] = ring,
                            _["lng"] = lng,
-                           _["lat"] = lat,
-                           _["stringsAsFactors"] = false);
+                           _["lat"] = lat);
 }
@@ -1,26 +1,149 @@
 #include <Rcpp.h>
 #include "utils.h"
+#include "parallel.h"
+#include "writer.h"
+#include "streaming.h"
+#include "shape.h"
+#include "stats.h"
 
 using namespace Rcpp;
 using namespace wkt_utils;
 
-template <typename T>
-std::string wkt_correct_single(std::string& x, T& poly){
-  boost::geometry::validity_failure_type failure;
-  try {
-    boost::geometry::read_wkt(x, poly);
+/**
+ * Corrects whichever polygons and multipolygons in a shape fail is_valid
+ * only for their orientation, noting whether any did
+ */
+struct correct_op {
+
+  bool changed;
+
+  correct_op() : changed(false) {}
+
+  template <typename T>
+  inline void operator()(T&){}
+
+  inline void operator()(polygon_type& poly){
+    fix(poly);
+  }
+
+  inline void operator()(multipolygon_type& poly){
+    fix(poly);
+  }
+
+  template <typename T>
+  inline void fix(T& poly){
+    boost::geometry::validity_failure_type failure;
     boost::geometry::is_valid(poly, failure);
-  } catch (boost::geometry::read_wkt_exception &e){
-    return x;
+    if(failure == boost::geometry::failure_wrong_orientation){
+      boost::geometry::correct(poly);
+      changed = true;
+    }
   }
-  if(failure == boost::geometry::failure_wrong_orientation){
-    boost::geometry::correct(poly);
-    std::stringstream ss;
-    ss << boost::geometry::wkt(poly);
-    return ss.str();
+};
+
+struct correct_worker {
+
+  const wkt_input& x;
+  wkt_output& output;
+  call_stats& stats;
+
+  correct_worker(const wkt_input& x, wkt_output& output, call_stats& stats)
+    : x(x), output(output), stats(stats) {}
+
+  template <typename T>
+  inline void single(unsigned int i, row_stats& row){
+    T poly;
+    boost::geometry::validity_failure_type failure;
+    try {
+      x.read_into(i, poly);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.set_unchanged(i);
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+    boost::geometry::is_valid(poly, failure);
+    if(failure == boost::geometry::failure_wrong_orientation){
+      boost::geometry::correct(poly);
+      row.lap(compute_phase);
+      geometry_text_writer writer(output.open(i));
+      writer.write(poly);
+      row.lap(output_phase);
+      return;
+    }
+    output.set_unchanged(i);
+    row.lap(compute_phase);
   }
-  return x;
-}
+
+  inline void collection(unsigned int i, row_stats& row){
+    shape gc;
+    try {
+      gc.read(x, i);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.set_unchanged(i);
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+    correct_op op;
+    visit_shape(gc, op);
+    row.lap(compute_phase);
+    if(op.changed){
+      geometry_text_writer writer(output.open(i));
+      write_shape(writer, gc);
+      row.lap(output_phase);
+      return;
+    }
+    output.set_unchanged(i);
+  }
+
+  void operator()(unsigned int i){
+    // Each row's geometry is built in, and released with, the arena
+    arena_scope scope;
+    row_stats row(stats.local());
+    if(x.is_na(i)){
+      row.row(-1);
+      output.set_na(i);
+      return;
+    }
+    row.row(x.size(i));
+    // Only polygons (on their own or in a collection) can be wrongly
+    // oriented; anything else is passed through without being read
+    supported_types type = x.type(i);
+    row.lap(dispatch_phase);
+    if(type != polygon && type != multi_polygon && type != geometry_collection){
+      output.set_unchanged(i);
+      return;
+    }
+
+    // Most polygons are already oriented correctly, which the ring areas
+    // settle as the object is read, without building it or calling is_valid
+    orientation_handler orientation;
+    try {
+      x.read(i, orientation);
+    } catch (boost::geometry::read_wkt_exception &e){
+      output.set_unchanged(i);
+      row.lap(parse_phase);
+      row.failed(x, i);
+      return;
+    }
+    row.lap(parse_phase);
+    if(orientation.oriented){
+      output.set_unchanged(i);
+      return;
+    }
+
+    if(type == polygon){
+      single<polygon_type>(i, row);
+    } else if(type == multi_polygon){
+      single<multipolygon_type>(i, row);
+    } else {
+      collection(i, row);
+    }
+  }
+};
 
 //' @title Correct Incorrectly Oriented WKT Objects
 //' @description `wkt_correct` does precisely what it says on the tin,
@@ -28,7 +151,9 @@ std::string wkt_correct_single(std::string& x, T& poly){
 //' (say, back to front). It can be applied to WKT objects that,
 //' when validated with [validate_wkt()], fail for that reason.
 //' @export
-//' @param x a character vector of WKT objects to correct
+//' @param x a character vector of WKT objects to correct, or a `wkt_parsed`
+//' object from [wkt_parse()]
+//' @template nthreads
 //' @return a character vector, the same length as `x`, containing
 //' either the original value (if there was no correction to make, or if
 //' the object was invalid for other reasons) or the corrected WKT
@@ -43,53 +168,20 @@ std::string wkt_correct_single(std::string& x, T& poly){
 //' # And suddenly isn't!
 //' wkt_correct(wkt)
 // [[Rcpp::export]]
-CharacterVector wkt_correct(CharacterVector x){
-
-  // Create instances of each type
-  point_type pt;
-  linestring_type ls;
-  polygon_type poly;
-  multipoint_type multip;
-  multilinestring_type multil;
-  multipolygon_type multipoly;
+CharacterVector wkt_correct(SEXP x, SEXP nthreads = R_NilValue){
 
   // Generate output objects
-  unsigned int input_size = x.size();
-  CharacterVector output(input_size);
-  std::string holding;
+  int threads = resolve_threads(nthreads);
+  call_stats stats("wkt_correct", threads);
+  wkt_input input(x);
+  unsigned int input_size = input.length();
+  wkt_output output(input_size);
 
-  for(unsigned int i = 0; i < input_size; i++){
-    if((i % 10000) == 0){
-      Rcpp::checkUserInterrupt();
-    }
-    if(x[i] == NA_STRING){
-      output[i] = NA_STRING;
-    } else {
-      holding = Rcpp::as<std::string>(x[i]);
-      switch(id_type(holding)){
-      case point:
-        output[i] = wkt_correct_single(holding, pt);
-        break;
-      case line_string:
-        output[i] = wkt_correct_single(holding, ls);
-        break;
-      case polygon:
-        output[i] = wkt_correct_single(holding, poly);
-        break;
-      case multi_point:
-        output[i] = wkt_correct_single(holding, multip);
-        break;
-      case multi_line_string:
-        output[i] = wkt_correct_single(holding, multil);
-        break;
-      case multi_polygon:
-        output[i] = wkt_correct_single(holding, multipoly);
-        break;
-      default:
-        output[i] = x[i];
-      }
-    }
-  }
+  parallel_for(input_size, threads, correct_worker(input, output, stats));
 
-  return output;
+  row_stats row(stats.local());
+  CharacterVector result = output.to_r(input);
+  row.lap(output_phase);
+  stats.finish();
+  return result;
 }
@@ -0,0 +1,410 @@
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "reader.h"
+#include "format.h"
+
+#ifndef __WKT_WRITER__
+#define __WKT_WRITER__
+namespace wkt_utils {
+
+  /**
+   * A handler that writes WKT as an object is read, whether from WKT or from
+   * WKB. Output follows the layout wkb_wkt has always produced -
+   * "POINT Z (1 2 3)", "MULTIPOINT ((1 2), (3 4))" - with numbers written to
+   * `precision` significant digits, trailing zeros trimmed, or to `precision`
+   * decimal places if trim is false.
+   */
+  struct wkt_text_writer : wkt_handler {
+
+    static const bool collections = true;
+
+    struct frame {
+      supported_types type;
+      bool has_z;
+      bool has_m;
+      bool is_empty;
+    };
+
+    std::string& out;
+    int precision;
+    bool trim;
+    std::vector < frame > frames;
+    unsigned int ring_size;
+    unsigned int part_rings;
+    char buffer[400];
+
+    /**
+     * @param out a reference to the string to append WKT to
+     *
+     * @param precision the number of significant digits (or decimal places) to write
+     *
+     * @param trim whether to trim trailing zeros
+     */
+    wkt_text_writer(std::string& out, int precision, bool trim)
+      : out(out), precision(precision), trim(trim) {}
+
+    inline void begin_geometry(const wkt_header& header){
+      static const char* names[] = {
+        "", "POINT", "MULTIPOINT", "LINESTRING", "MULTILINESTRING", "POLYGON",
+        "GEOMETRYCOLLECTION", "MULTIPOLYGON"
+      };
+      out += names[header.type];
+      if(header.has_z && header.has_m){
+        out += " ZM";
+      } else if(header.has_z){
+        out += " Z";
+      } else if(header.has_m){
+        out += " M";
+      }
+
+      frame f = {header.type, header.has_z, header.has_m, header.is_empty};
+      frames.push_back(f);
+      if(header.is_empty){
+        out += " EMPTY";
+      } else if(header.type != line_string){
+        out += " (";
+      } else {
+        out += ' ';
+      }
+      ring_size = 0;
+    }
+
+    inline void end_geometry(){
+      if(!frames.back().is_empty && frames.back().type != line_string){
+        out += ')';
+      }
+      frames.pop_back();
+    }
+
+    inline void begin_part(unsigned int i){
+      if(i){
+        out += ", ";
+      }
+      ring_size = 0;
+      part_rings = 0;
+    }
+
+    inline void end_part(){
+      switch(frames.back().type){
+      case multi_point:
+        if(!ring_size){
+          out += "EMPTY";
+        }
+        break;
+      case multi_polygon:
+        out += part_rings ? ")" : "EMPTY";
+        break;
+      default:
+        break;
+      }
+    }
+
+    inline void begin_ring(unsigned int i){
+      if(i){
+        out += ", ";
+      } else if(frames.back().type == multi_polygon){
+        out += '(';
+      }
+      ring_size = 0;
+      part_rings++;
+    }
+
+    inline void end_ring(){
+      out += ring_size ? ")" : "EMPTY";
+    }
+
+    inline void coord(const coordinate& c){
+      const frame& f = frames.back();
+      if(f.type == point){
+        // The opening bracket is already written
+      } else if(f.type == multi_point){
+        out += '(';
+      } else if(ring_size){
+        out += ", ";
+      } else {
+        out += '(';
+      }
+      ring_size++;
+
+      number(c.x);
+      out += ' ';
+      number(c.y);
+      if(f.has_z){
+        out += ' ';
+        number(c.z);
+      }
+      if(f.has_m){
+        out += ' ';
+        number(c.m);
+      }
+      if(f.type == multi_point){
+        out += ')';
+      }
+    }
+
+    inline void number(double x){
+      int size = (trim && precision <= 17) ? format_double(buffer, x, precision) :
+        snprintf(buffer, sizeof(buffer), trim ? "%.*g" : "%.*f", precision, x);
+      out.append(buffer, size);
+    }
+  };
+
+  /**
+   * A handler that writes WKT as wkt_text_writer does, moving every
+   * coordinate to the nearest point of a grid on the way, and writing
+   * consecutive points of a linestring or ring that land in the same place
+   * (duplicate points, as boost::geometry::is_valid has it) only once. The
+   * grid's spacing is either a power of ten or any positive number; Z and M
+   * values are snapped too if snap_zm is set. Numbers are written with the
+   * fewest digits that read back exactly, so coordinates snapped to 0.1
+   * come out as "1.2", not "1.2000000000000002" - or, where the grid's
+   * points can't all be written exactly (a spacing of 0.3, say), to 15
+   * significant digits.
+   */
+  struct snapping_writer : wkt_handler {
+
+    static const bool collections = true;
+
+    wkt_text_writer writer;
+    double step;
+    // 1 / step, where that is a whole number: dividing by it, rather than
+    // multiplying by step, gives the double nearest the decimal
+    double inverse;
+    bool snap_zm;
+    unsigned long ring_size;
+    coordinate previous;
+
+    /**
+     * @param out a reference to the string to append WKT to
+     *
+     * @param step the spacing of the grid
+     *
+     * @param snap_zm whether to snap Z and M values as well as x and y
+     */
+    snapping_writer(std::string& out, double step, bool snap_zm)
+      : writer(out, whole_inverse(step) ? 0 : 15, true), step(step), inverse(whole_inverse(step)),
+        snap_zm(snap_zm), ring_size(0) {}
+
+    /**
+     * A function for finding 1 / step, if it's a whole number
+     *
+     * @return the number, or 0 if it isn't one
+     */
+    static inline double whole_inverse(double step){
+      double whole = std::floor(1 / step + 0.5);
+      return whole >= 1 && std::fabs(1 / step - whole) <= 1e-9 * whole ? whole : 0;
+    }
+
+    inline double snap(double x) const {
+      double scaled = inverse ? x * inverse : x / step;
+      if(!std::isfinite(scaled)){
+        return x;
+      }
+      // Adding 0 turns -0 into 0
+      return (inverse ? std::round(scaled) / inverse : std::round(scaled) * step) + 0.0;
+    }
+
+    inline void begin_geometry(const wkt_header& header){
+      ring_size = 0;
+      writer.begin_geometry(header);
+    }
+
+    inline void end_geometry(){
+      writer.end_geometry();
+    }
+
+    inline void begin_part(unsigned int i){
+      writer.begin_part(i);
+    }
+
+    inline void end_part(){
+      writer.end_part();
+    }
+
+    inline void begin_ring(unsigned int i){
+      ring_size = 0;
+      writer.begin_ring(i);
+    }
+
+    inline void end_ring(){
+      writer.end_ring();
+    }
+
+    inline void coord(const coordinate& c){
+      coordinate snapped = c;
+      snapped.x = snap(c.x);
+      snapped.y = snap(c.y);
+      if(snap_zm){
+        snapped.z = snap(c.z);
+        snapped.m = snap(c.m);
+      }
+      supported_types type = writer.frames.back().type;
+      if(type != point && type != multi_point){
+        if(ring_size && duplicate_points(snapped, previous)){
+          return;
+        }
+        previous = snapped;
+        ring_size++;
+      }
+      writer.coord(snapped);
+    }
+  };
+
+  /**
+   * Writes boost::geometry objects as WKT in the layout boost::geometry::wkt
+   * has always given them - "POLYGON((30 10,40 40,20 40,30 10))", with no
+   * spaces between coordinates - straight into a string, rather than through
+   * an ostream. Numbers are written to `digits` significant digits (by
+   * default 6, as an ostream would), or with 0, the fewest that read back
+   * exactly.
+   */
+  struct geometry_text_writer {
+
+    std::string& out;
+    int digits;
+    char buffer[32];
+
+    /**
+     * @param out a reference to the string to append WKT to
+     *
+     * @param digits the number of significant digits to write, at most 17
+     */
+    geometry_text_writer(std::string& out, int digits = 6) : out(out), digits(digits) {}
+
+    template <typename Geometry>
+    inline void write(const Geometry& geom){
+      write(geom, typename boost::geometry::tag<Geometry>::type());
+    }
+
+    /**
+     * A function for writing a box as the polygon boost::geometry::convert
+     * would make of it, without making the polygon. Each of the four values
+     * is formatted once, and copied to the corners that use it.
+     */
+    inline void write_box(double min_x, double min_y, double max_x, double max_y){
+      char text[4][32];
+      int size[4];
+      size[0] = format_double(text[0], min_x, digits);
+      size[1] = format_double(text[1], min_y, digits);
+      size[2] = format_double(text[2], max_x, digits);
+      size[3] = format_double(text[3], max_y, digits);
+      // min_x min_y, min_x max_y, max_x max_y, max_x min_y, min_x min_y
+      static const int corners[5][2] = {{0, 1}, {0, 3}, {2, 3}, {2, 1}, {0, 1}};
+      out += "POLYGON((";
+      for(unsigned int i = 0; i < 5; i++){
+        if(i){
+          out += ',';
+        }
+        out.append(text[corners[i][0]], size[corners[i][0]]);
+        out += ' ';
+        out.append(text[corners[i][1]], size[corners[i][1]]);
+      }
+      out += "))";
+    }
+
+  private:
+
+    inline void number(double x){
+      out.append(buffer, format_double(buffer, x, digits));
+    }
+
+    inline void coordinate(double x, double y){
+      number(x);
+      out += ' ';
+      number(y);
+    }
+
+    template <typename Point>
+    inline void point_coordinate(const Point& p){
+      coordinate(boost::geometry::get<0>(p), boost::geometry::get<1>(p));
+    }
+
+    template <typename Range>
+    inline void points(const Range& range, bool ring = false){
+      out += '(';
+      for(unsigned int i = 0; i < range.size(); i++){
+        if(i){
+          out += ',';
+        }
+        point_coordinate(range[i]);
+      }
+      // Like boost, rings that aren't closed are written closed
+      if(ring && range.size() > 1 && boost::geometry::disjoint(range.front(), range.back())){
+        out += ',';
+        point_coordinate(range.front());
+      }
+      out += ')';
+    }
+
+    template <typename Polygon>
+    inline void rings(const Polygon& poly){
+      out += '(';
+      points(poly.outer(), true);
+      for(unsigned int i = 0; i < poly.inners().size(); i++){
+        out += ',';
+        points(poly.inners()[i], true);
+      }
+      out += ')';
+    }
+
+    template <typename Geometry>
+    inline void write(const Geometry& p, boost::geometry::point_tag){
+      out += "POINT(";
+      point_coordinate(p);
+      out += ')';
+    }
+
+    template <typename Geometry>
+    inline void write(const Geometry& line, boost::geometry::linestring_tag){
+      out += "LINESTRING";
+      points(line);
+    }
+
+    template <typename Geometry>
+    inline void write(const Geometry& poly, boost::geometry::polygon_tag){
+      out += "POLYGON";
+      rings(poly);
+    }
+
+    template <typename Geometry>
+    inline void write(const Geometry& multi, boost::geometry::multi_point_tag){
+      out += "MULTIPOINT(";
+      for(unsigned int i = 0; i < multi.size(); i++){
+        if(i){
+          out += ',';
+        }
+        out += '(';
+        point_coordinate(multi[i]);
+        out += ')';
+      }
+      out += ')';
+    }
+
+    template <typename Geometry>
+    inline void write(const Geometry& multi, boost::geometry::multi_linestring_tag){
+      out += "MULTILINESTRING(";
+      for(unsigned int i = 0; i < multi.size(); i++){
+        if(i){
+          out += ',';
+        }
+        points(multi[i]);
+      }
+      out += ')';
+    }
+
+    template <typename Geometry>
+    inline void write(const Geometry& multi, boost::geometry::multi_polygon_tag){
+      out += "MULTIPOLYGON(";
+      for(unsigned int i = 0; i < multi.size(); i++){
+        if(i){
+          out += ',';
+        }
+        rings(multi[i]);
+      }
+      out += ')';
+    }
+  };
+}
+#endif
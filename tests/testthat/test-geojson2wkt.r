@@ -96,6 +96,102 @@ test_that("convert geometrycollection works", {
   expect_equal(g, "GEOMETRYCOLLECTION (POINT (0 1), LINESTRING (0 0, 2 1, 4 2, 5 4), POLYGON ((100.001 0.001, 101.100 0.001, 101.001 1.001, 100.001 0.001), (100.201 0.201, 100.801 0.201, 100.801 0.801, 100.201 0.201)))")
 })
 
+test_that("convert json to wkt", {
+  expect_equal(geojson2wkt('{"type":"Point","coordinates":[1,2]}', fmt = 0),
+    "POINT (1 2)")
+  # members can come in any order, and types in any case
+  expect_equal(geojson2wkt('{"coordinates":[1,2],"type":"point"}', fmt = 0),
+    "POINT (1 2)")
+  expect_equal(geojson2wkt('{"type":"Point","coordinates":[116.4,45.2]}'),
+    "POINT (116.4000000000000057  45.2000000000000028)")
+
+  poly <- '{"type":"Polygon","coordinates":[[[100.001,0.001],[101.1,0.001],
+    [101.001,1.001],[100.001,0.001]]]}'
+  expect_equal(geojson2wkt(poly, fmt = 0),
+    "POLYGON ((100.001 0.001, 101.100 0.001, 101.001 1.001, 100.001 0.001))")
+
+  st <- '{"type":"LineString","coordinates":[[1,2,3],[4,5,6]]}'
+  expect_equal(geojson2wkt(st, fmt = 0), "LINESTRING Z(1 2 3, 4 5 6)")
+  expect_equal(geojson2wkt(st, fmt = 0, third = "m"), "LINESTRING M(1 2 3, 4 5 6)")
+
+  gc <- '{"type":"GeometryCollection","geometries":[
+    {"type":"Point","coordinates":[0,1]},
+    {"type":"LineString","coordinates":[[0,0],[2,1]]}]}'
+  expect_equal(geojson2wkt(gc, fmt = 0),
+    "GEOMETRYCOLLECTION (POINT (0 1), LINESTRING (0 0, 2 1))")
+
+  expect_equal(geojson2wkt('{"type":"Point","coordinates":[]}'), "POINT EMPTY")
+})
+
+test_that("json and lists give the same wkt", {
+  multist <- list(MultiLineString = list(
+    matrix(c(0, -2, -4, -1, -3, -5), ncol = 2),
+    matrix(c(1.66, 10.9999, 10.9, 0, -31.5, 3.0, 1.1, 0), ncol = 2)
+  ))
+  json <- jsonlite::toJSON(multist, digits = NA)
+  expect_is(json, "json")
+  expect_equal(geojson2wkt(json, fmt = 0), geojson2wkt(multist, fmt = 0))
+  expect_equal(geojson2wkt(json), geojson2wkt(multist))
+
+  same <- function(x, ...) {
+    json <- jsonlite::toJSON(x, digits = NA)
+    expect_equal(geojson2wkt(json, ...), geojson2wkt(x, ...))
+  }
+  same(list(Point = c(116.4, 45.2)))
+  same(list(Point = c(-1, 2.5, 1e-10)), fmt = 0)
+  same(list(MultiPoint = matrix(c(100, 101, 3.14, 3.101, 2.1, 2.18), ncol = 2)))
+  same(list(LineString = matrix(c(1e-10, 2, 123456789, 4), ncol = 2)), fmt = 0)
+  same(list(LineString = matrix(c(99999999.3, 1, 0.5, 2), ncol = 2)), fmt = 2)
+  same(list(Polygon = list(
+    matrix(c(100.001, 101.1, 101.001, 100.001, 0.001, 0.001, 1.001, 0.001), ncol = 2)
+  )), fmt = 0)
+  same(list(MultiPolygon = list(list(
+    matrix(c(30, 40, 54, 30, 0.1, 42, 62, 0.1), ncol = 2)
+  ))), fmt = 0)
+
+  # getOption("digits") and getOption("scipen") apply to both
+  op <- options(digits = 3, scipen = 10)
+  on.exit(options(op))
+  same(list(LineString = matrix(c(1e-10, 10.9999, 123456789, -0.5), ncol = 2)), fmt = 1)
+})
+
+test_that("arguments in ... read json with jsonlite, as before", {
+  point <- '{"type":"Point","coordinates":[116.4,45.2]}'
+  expect_equal(geojson2wkt(point, simplifyVector = TRUE), geojson2wkt(point))
+  expect_equal(geojson2wkt(point, fmt = 0, simplifyVector = TRUE),
+    "POINT (116.4  45.2)")
+})
+
+test_that("features and feature collections give one wkt per feature", {
+  fc <- '{"type":"FeatureCollection","features":[
+    {"type":"Feature","properties":{"type":"x","a":[1,{"b":null}]},
+      "geometry":{"type":"Point","coordinates":[1,2]}},
+    {"type":"Feature","properties":{},"geometry":null},
+    {"type":"Feature","geometry":{"type":"LineString","coordinates":[[0,0],[1,1]]}}
+  ]}'
+  expect_equal(geojson2wkt(fc, fmt = 0),
+    c("POINT (1 2)", NA, "LINESTRING (0 0, 1 1)"))
+
+  feature <- '{"type":"Feature","geometry":{"type":"Point","coordinates":[3,4]}}'
+  expect_equal(geojson2wkt(c(feature, NA, fc), fmt = 0),
+    c("POINT (3 4)", NA, "POINT (1 2)", NA, "LINESTRING (0 0, 1 1)"))
+})
+
+test_that("json - fails well", {
+  expect_error(geojson2wkt('{"type":"Point","coordinates":[1,2]'),
+    "Invalid JSON")
+  expect_error(geojson2wkt('{"type":"Point","coordinates":[[1,2]]}'),
+    "expecting a vector in 'coordinates'")
+  expect_error(geojson2wkt('{"type":"LineString","coordinates":[1,2]}'),
+    "expecting a matrix in 'coordinates'")
+  expect_error(geojson2wkt('{"type":"Point","coordinates":[1,2,3,4,5]}'),
+    "only 2D, 3D, and 4D supported")
+  expect_error(geojson2wkt('{"type":"Circle","coordinates":[1,2]}'),
+    "type Circle not supported")
+  expect_error(geojson2wkt('{"type":"Point","coordinates":[1,2]}', fmt = 21),
+    "between 0 and 20")
+})
+
 
 
 